@@ -0,0 +1,152 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for automatically selecting calibration views from a live stream based on image coverage and pose diversity.
+*/
+
+#include "autocapture.h"
+
+/*
+ Given a vector of detected corners ordered row by row and the board size in corners,
+ this function computes a pose descriptor for the view without needing the camera intrinsics:
+ the perspective terms of the board-to-image homography scaled by the board extent (tilt about each axis)
+ and the square root of the board area relative to the image area (distance).
+ */
+static cv::Vec3f viewDescriptor(std::vector<cv::Point2f> &corners, cv::Size board_size, cv::Size image_size)
+{
+    // Corner positions on the board plane in units of squares
+    std::vector<cv::Point2f> plane;
+    for (int k = 0; k < (int)corners.size(); k++)
+    {
+        plane.push_back(cv::Point2f((float)(k % board_size.width), (float)(k / board_size.width)));
+    }
+
+    cv::Mat H = cv::findHomography(plane, corners);
+    if (H.empty())
+    {
+        return cv::Vec3f(0, 0, 0);
+    }
+    H /= H.at<double>(2, 2);
+
+    float tilt_x = (float)(H.at<double>(2, 0) * (board_size.width - 1));  // Foreshortening along the board rows
+    float tilt_y = (float)(H.at<double>(2, 1) * (board_size.height - 1)); // Foreshortening along the board columns
+
+    // Apparent size from the outer corners of the board
+    int last = (int)corners.size() - 1;
+    std::vector<cv::Point2f> outline = {corners[0], corners[board_size.width - 1], corners[last], corners[last - board_size.width + 1]};
+    float size = (float)std::sqrt(std::fabs(cv::contourArea(outline)) / ((double)image_size.width * image_size.height));
+
+    return cv::Vec3f(tilt_x, tilt_y, size);
+}
+
+/*
+ Given the view selector and the size of the calibration frames,
+ this function clears the selector so that a new capture session can begin.
+ */
+int initViewSelector(ViewSelector &selector, cv::Size image_size)
+{
+    selector.image_size = image_size;
+    selector.coverage = cv::Mat::zeros(selector.grid, CV_32S);
+    selector.descriptors.clear();
+    selector.uncertainty = -1.0;
+    selector.converged = false;
+
+    return (0);
+}
+
+/*
+ Given the view selector, a vector of detected corners ordered row by row and the board size in corners,
+ this function scores how much new information the view would add, from 0 (duplicate) to 1 (entirely new).
+ The score combines the fraction of corners landing in uncovered cells with the distance of the board tilt
+ and apparent size from the views already accepted.
+ */
+float scoreCalibrationView(ViewSelector &selector, std::vector<cv::Point2f> &corners, cv::Size board_size)
+{
+    if (corners.size() != (size_t)board_size.area())
+    {
+        return (0.0f);
+    }
+
+    // Fraction of the corners that land in cells no accepted view has reached yet
+    int fresh = 0;
+    for (auto &corner : corners)
+    {
+        int cx = std::min(selector.grid.width - 1, std::max(0, (int)(corner.x * selector.grid.width / selector.image_size.width)));
+        int cy = std::min(selector.grid.height - 1, std::max(0, (int)(corner.y * selector.grid.height / selector.image_size.height)));
+        if (selector.coverage.at<int>(cy, cx) == 0)
+        {
+            fresh++;
+        }
+    }
+    float coverage_gain = (float)fresh / corners.size();
+
+    // Distance in tilt and size to the closest accepted view, where 1 means clearly different
+    cv::Vec3f descriptor = viewDescriptor(corners, board_size, selector.image_size);
+    float novelty = 1.0f;
+    for (auto &accepted : selector.descriptors)
+    {
+        float dx = (descriptor[0] - accepted[0]) / selector.tilt_scale;
+        float dy = (descriptor[1] - accepted[1]) / selector.tilt_scale;
+        float ds = (descriptor[2] - accepted[2]) / selector.size_scale;
+        novelty = std::min(novelty, std::sqrt(dx * dx + dy * dy + ds * ds));
+    }
+
+    return (selector.coverage_weight * coverage_gain + (1.0f - selector.coverage_weight) * novelty);
+}
+
+/*
+ Given the view selector, a vector of detected corners ordered row by row and the board size in corners,
+ this function records the view as accepted, updating the coverage cells and pose descriptors.
+ */
+int acceptCalibrationView(ViewSelector &selector, std::vector<cv::Point2f> &corners, cv::Size board_size)
+{
+    for (auto &corner : corners)
+    {
+        int cx = std::min(selector.grid.width - 1, std::max(0, (int)(corner.x * selector.grid.width / selector.image_size.width)));
+        int cy = std::min(selector.grid.height - 1, std::max(0, (int)(corner.y * selector.grid.height / selector.image_size.height)));
+        selector.coverage.at<int>(cy, cx)++;
+    }
+
+    selector.descriptors.push_back(viewDescriptor(corners, board_size, selector.image_size));
+
+    return (0);
+}
+
+/*
+ Given the view selector, vectors having a list of point sets and corner sets, camera matrix and distortion coefficients,
+ this function calibrates the camera, estimates the standard deviation of the intrinsics and updates the convergence state.
+ This function also returns the reprojection error after performing calibration.
+ */
+float calibrateWithUncertainty(ViewSelector &selector, std::vector<std::vector<cv::Vec3f>> &points_list, std::vector<std::vector<cv::Point2f>> &corners_list, cv::Mat &camera_matrix, cv::Mat &dist_coeff)
+{
+    std::vector<cv::Mat> rot, trans;                     // Rotation and translation of each view
+    cv::Mat std_intrinsics, std_extrinsics, view_errors; // Standard deviations and per-view errors
+
+    float error = cv::calibrateCamera(points_list,                                                                            // List of 3D points for each calibration image
+                                      corners_list,                                                                           // List of 2D corner points for each calibration image
+                                      selector.image_size,                                                                    // Size of the calibration images
+                                      camera_matrix,                                                                          // Output camera matrix
+                                      dist_coeff,                                                                             // Output distortion coefficients
+                                      rot,                                                                                    // Output rotation vectors
+                                      trans,                                                                                  // Output translation vectors
+                                      std_intrinsics,                                                                         // Standard deviation of the intrinsics
+                                      std_extrinsics,                                                                         // Standard deviation of the extrinsics
+                                      view_errors,                                                                            // Per-view reprojection error
+                                      cv::CALIB_FIX_ASPECT_RATIO,                                                             // Fix the aspect ratio during calibration
+                                      cv::TermCriteria(cv::TermCriteria::MAX_ITER + cv::TermCriteria::EPS, 30, DBL_EPSILON)); // Termination criteria
+
+    // Largest standard deviation of fx, fy, cx, cy relative to the parameter itself
+    const double params[4] = {camera_matrix.at<double>(0, 0), camera_matrix.at<double>(1, 1), camera_matrix.at<double>(0, 2), camera_matrix.at<double>(1, 2)};
+    selector.uncertainty = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+        selector.uncertainty = std::max(selector.uncertainty, std_intrinsics.at<double>(i) / std::max(std::fabs(params[i]), 1e-9));
+    }
+
+    selector.converged = (int)points_list.size() >= selector.min_views && selector.uncertainty < selector.converge_tol;
+
+    return (error);
+}
@@ -0,0 +1,67 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for automatically selecting calibration views from a live stream based on image coverage and pose diversity.
+*/
+
+#ifndef autocapture_hpp
+#define autocapture_hpp
+
+#include <stdio.h>
+#include <iostream>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/calib3d.hpp>
+
+/*
+ State of the automatic view selection: which parts of the sensor have been covered,
+ the pose descriptors of the views accepted so far and the convergence of the calibration.
+ */
+struct ViewSelector
+{
+    cv::Size image_size;                // Size of the calibration frames
+    cv::Size grid = cv::Size(8, 6);     // Number of coverage cells across and down the sensor
+    cv::Mat coverage;                   // Number of accepted corners that fell in each cell (CV_32S)
+    std::vector<cv::Vec3f> descriptors; // Tilt x, tilt y and apparent size of every accepted view
+    float coverage_weight = 0.5f;       // Weight of the coverage gain against the pose novelty
+    float tilt_scale = 0.15f;           // Tilt difference that counts as a new pose
+    float size_scale = 0.15f;           // Apparent size difference that counts as a new distance
+    float min_score = 0.35f;            // Views scoring below this add too little information to be kept
+    int min_views = 5;                  // Number of views needed before calibrating
+    double converge_tol = 0.01;         // Relative standard deviation of the intrinsics at which capture stops
+    double uncertainty = -1.0;          // Largest relative standard deviation from the last calibration
+    bool converged = false;             // True once the uncertainty drops below the tolerance
+};
+
+/*
+ Given the view selector and the size of the calibration frames,
+ this function clears the selector so that a new capture session can begin.
+ */
+int initViewSelector(ViewSelector &selector, cv::Size image_size);
+
+/*
+ Given the view selector, a vector of detected corners ordered row by row and the board size in corners,
+ this function scores how much new information the view would add, from 0 (duplicate) to 1 (entirely new).
+ The score combines the fraction of corners landing in uncovered cells with the distance of the board tilt
+ and apparent size from the views already accepted.
+ */
+float scoreCalibrationView(ViewSelector &selector, std::vector<cv::Point2f> &corners, cv::Size board_size);
+
+/*
+ Given the view selector, a vector of detected corners ordered row by row and the board size in corners,
+ this function records the view as accepted, updating the coverage cells and pose descriptors.
+ */
+int acceptCalibrationView(ViewSelector &selector, std::vector<cv::Point2f> &corners, cv::Size board_size);
+
+/*
+ Given the view selector, vectors having a list of point sets and corner sets, camera matrix and distortion coefficients,
+ this function calibrates the camera, estimates the standard deviation of the intrinsics and updates the convergence state.
+ This function also returns the reprojection error after performing calibration.
+ */
+float calibrateWithUncertainty(ViewSelector &selector, std::vector<std::vector<cv::Vec3f>> &points_list, std::vector<std::vector<cv::Point2f>> &corners_list, cv::Mat &camera_matrix, cv::Mat &dist_coeff);
+
+#endif /* autocapture_hpp */
@@ -0,0 +1,155 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+main() CPP function for calibrating many recorded sessions at once. Every session gets its own CoreContext and runs
+on a thread of the session pool: its frames are replayed through the same detector as main and main_ar, every N-th
+frame with the whole target becomes a calibration view, and the calibration is saved next to the session.
+
+Usage: batch_calib session.rec [session.rec ...] [--target=chessboard|circles] [--every=N] [--threads=N] [--solver=sparse] [--loss=huber:S] [--fix=k3,...]
+*/
+
+#include <iostream>
+#include <chrono>
+
+// OpenCV headers
+#include <opencv2/core.hpp>
+
+// User-defined headers
+#include "core.h"
+#include "recorder.h"
+#include "sessionpool.h"
+
+/*
+ Results of one session, filled in by its thread and printed once every session is done.
+ */
+struct SessionResult
+{
+    std::string filename; // Session file
+    bool opened = false;  // Whether the session file could be opened for replay
+    int frames = 0;       // Frames replayed
+    int views = 0;        // Calibration views taken
+    float error = -1.0f;  // Reprojection error, -1 when there were too few views
+    double ms = 0.0;      // Time to replay and calibrate the session
+    cv::Mat camera_matrix;
+};
+
+/*
+ Given a session result, the target, the view spacing and the solver settings, this function replays the session,
+ collects calibration views, calibrates and saves the calibration to the session's name with .csv appended.
+ */
+static int calibrateSession(SessionResult &result, TargetKind kind, int every, BundleParams solver)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    SessionReplay replay;
+    if (openReplay(replay, result.filename, false) != 0)
+    {
+        return (-1);
+    }
+    result.opened = true;
+
+    CoreContext core;
+    cv::Size frame_size = replayFrameSize(replay);
+    initCoreContext(core, kind, frame_size);
+
+    cv::Mat frame, output;
+    std::vector<cv::Point2f> corners;
+    std::vector<cv::Vec3f> points;
+    int key, found_frames = 0;
+    while (replayFrame(replay, frame, key))
+    {
+        if (frame.empty())
+        {
+            continue;
+        }
+        result.frames++;
+
+        if (detectTarget(core, frame, output, corners, false) && found_frames++ % every == 0)
+        {
+            selectCalibrationImg(core, corners, points);
+        }
+    }
+    closeReplay(replay);
+
+    result.views = (int)core.corners_list.size();
+    if (result.views >= 5)
+    {
+        result.error = calibrateCamera(core, frame_size, solver);
+        result.camera_matrix = core.camera_matrix.clone();
+        saveCalibration(result.filename + ".csv", core.camera_matrix, core.dist_coeff, frame_size);
+    }
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return (0);
+}
+
+// Main function
+int main(int argc, char *argv[])
+{
+    TargetKind kind = TARGET_CHESSBOARD;
+    int every = 10;
+    int threads = 0;
+    BundleParams solver;
+    std::vector<SessionResult> results;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--target=", 0) == 0)
+        {
+            kind = arg.substr(9) == "circles" ? TARGET_CIRCLES : TARGET_CHESSBOARD;
+        }
+        else if (arg.rfind("--every=", 0) == 0)
+        {
+            every = std::max(1, atoi(arg.c_str() + 8));
+        }
+        else if (arg.rfind("--threads=", 0) == 0)
+        {
+            threads = atoi(arg.c_str() + 10);
+        }
+        else if (!parseBundleArg(solver, arg))
+        {
+            results.emplace_back();
+            results.back().filename = arg;
+        }
+    }
+    if (results.empty())
+    {
+        printf("Usage: batch_calib session.rec [session.rec ...] [--target=chessboard|circles] [--every=N] [--threads=N] [--solver=sparse]\n");
+        return (-1);
+    }
+
+    // Each session owns its context and its result, so the sessions share nothing while they run
+    auto start = std::chrono::steady_clock::now();
+    SessionPool pool;
+    startSessionPool(pool, threads);
+    for (auto &result : results)
+    {
+        submitSession(pool, [&result, kind, every, solver] { calibrateSession(result, kind, every, solver); });
+    }
+    stopSessionPool(pool);
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    for (auto &result : results)
+    {
+        if (!result.opened)
+        {
+            printf("%s: unable to open the session\n", result.filename.c_str());
+            continue;
+        }
+        if (result.error < 0)
+        {
+            printf("%s: %d frames, %d views, too few to calibrate\n", result.filename.c_str(), result.frames, result.views);
+            continue;
+        }
+        printf("%s: %d frames, %d views, fx %.1f fy %.1f cx %.1f cy %.1f, error %.3f px, %.0f ms\n", result.filename.c_str(), result.frames,
+               result.views, result.camera_matrix.at<double>(0, 0), result.camera_matrix.at<double>(1, 1), result.camera_matrix.at<double>(0, 2),
+               result.camera_matrix.at<double>(1, 2), result.error, result.ms);
+    }
+    printf("%zu sessions on %zu threads in %.0f ms\n", results.size(), (size_t)(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())),
+           total_ms);
+
+    return (0);
+}
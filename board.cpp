@@ -0,0 +1,26 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for the geometry of calibration targets chosen at run time.
+*/
+
+#include "board.h"
+
+/*
+ Given a run-time board and a vector of points, this function populates the vector with the world points of the board.
+ */
+int boardObjectPoints(const DynamicBoard &board, std::vector<cv::Vec3f> &points)
+{
+    int count = board.size.area();
+    points.resize(count);
+    for (int k = 0; k < count; k++)
+    {
+        BoardPoint point = boardPoint(k, board.size.width, board.size.height, board.pattern);
+        points[k] = cv::Vec3f(point.x, point.y, point.z);
+    }
+
+    return (0);
+}
@@ -0,0 +1,138 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Geometry of the calibration targets. Board<Cols, Rows, Pattern> fixes a target's size at compile time and keeps its
+world points in a constexpr table; DynamicBoard describes a target chosen at run time with the same point layout.
+*/
+
+#ifndef board_hpp
+#define board_hpp
+
+#include <stdio.h>
+#include <iostream>
+#include <array>
+
+#include <opencv2/core.hpp>
+#include <opencv2/calib3d.hpp>
+
+/*
+ Layouts of the calibration targets.
+ */
+enum BoardPattern
+{
+    PATTERN_CHESSBOARD,        // Inner corners of a chessboard, row by row from the top left, rows going down the negative y axis
+    PATTERN_ASYMMETRIC_CIRCLES // Asymmetric circle grid, Cols circles per column starting at the right, odd columns shifted down one unit
+};
+
+/*
+ A world point of a target, one unit per square or per half circle spacing.
+ */
+struct BoardPoint
+{
+    float x, y, z;
+};
+
+/*
+ Given the index of a point, the pattern size and the layout, this function returns the point's world coordinates.
+ The ordering is the one cv::findChessboardCorners and cv::findCirclesGrid return the points in.
+ */
+constexpr BoardPoint boardPoint(int k, int cols, int rows, BoardPattern pattern)
+{
+    return pattern == PATTERN_CHESSBOARD ? BoardPoint{(float)(k % cols), (float)(-(k / cols)), 0.0f}
+                                         : BoardPoint{(float)(rows - 1 - k / cols), (float)(2 * cols - 1 - 2 * (k % cols) - (k / cols) % 2), 0.0f};
+}
+
+/*
+ A target chosen at run time.
+ */
+struct DynamicBoard
+{
+    cv::Size size;        // Pattern size as passed to the OpenCV detectors
+    BoardPattern pattern; // Layout of the points
+};
+
+/*
+ A target fixed at compile time. Cols and Rows are the pattern size as passed to the OpenCV detectors,
+ so the size used to find, draw and number the points comes from one place and cannot be transposed.
+ */
+template <int Cols, int Rows, BoardPattern Pattern>
+struct Board
+{
+    static_assert(Cols > 1 && Rows > 1, "A board needs at least two points along each side");
+
+    static constexpr int cols = Cols;
+    static constexpr int rows = Rows;
+    static constexpr int count = Cols * Rows;
+    static constexpr BoardPattern pattern = Pattern;
+
+    /*
+     This function builds the table of world points at compile time.
+     */
+    static constexpr std::array<BoardPoint, Cols * Rows> makePoints()
+    {
+        std::array<BoardPoint, Cols * Rows> table{};
+        for (int k = 0; k < Cols * Rows; k++)
+        {
+            table[k] = boardPoint(k, Cols, Rows, Pattern);
+        }
+        return (table);
+    }
+
+    static constexpr std::array<BoardPoint, Cols * Rows> points = makePoints(); // World point of every pattern point
+
+    /*
+     This function returns the pattern size for the OpenCV detectors and drawing functions.
+     */
+    static cv::Size size()
+    {
+        return (cv::Size(Cols, Rows));
+    }
+
+    /*
+     Given a vector of points, this function populates it with the world points of the board.
+     The copy has a fixed trip count, so the compiler unrolls or vectorises it.
+     */
+    static void objectPoints(std::vector<cv::Vec3f> &out)
+    {
+        out.resize(count);
+        for (int k = 0; k < count; k++)
+        {
+            out[k] = cv::Vec3f(points[k].x, points[k].y, points[k].z);
+        }
+    }
+
+    /*
+     Given a cv::Mat for the output, the detected points and whether the whole pattern was found,
+     this function draws the detections with the board's own pattern size.
+     */
+    static void drawCorners(cv::Mat &dst, std::vector<cv::Point2f> &corners, bool found)
+    {
+        cv::drawChessboardCorners(dst, size(), corners, found);
+    }
+
+    /*
+     This function returns the run-time description of the board.
+     */
+    static DynamicBoard dynamic()
+    {
+        return (DynamicBoard{size(), Pattern});
+    }
+};
+
+typedef Board<9, 6, PATTERN_CHESSBOARD> Chessboard9x6;           // Printed chessboard used by main.cpp
+typedef Board<4, 11, PATTERN_ASYMMETRIC_CIRCLES> CircleGrid4x11; // Printed circle grid used by main_ar.cpp
+
+// The tables are evaluated by the compiler, so a wrong layout fails the build
+static_assert(Chessboard9x6::points[10].x == 1 && Chessboard9x6::points[10].y == -1, "Chessboard rows run down the negative y axis");
+static_assert(CircleGrid4x11::points[0].x == 10 && CircleGrid4x11::points[0].y == 7, "Circle grid starts at the top right");
+static_assert(CircleGrid4x11::points[7].x == 9 && CircleGrid4x11::points[7].y == 0, "Odd circle columns are shifted down one unit");
+
+/*
+ Given a run-time board and a vector of points, this function populates the vector with the world points of the board.
+ */
+int boardObjectPoints(const DynamicBoard &board, std::vector<cv::Vec3f> &points);
+
+#endif /* board_hpp */
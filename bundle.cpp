@@ -0,0 +1,535 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for calibrating a camera from many views with a sparse Levenberg-Marquardt bundle adjustment.
+*/
+
+#include <chrono>
+#include <math.h>
+
+#include "bundle.h"
+
+typedef cv::Matx<double, PARAM_COUNT, PARAM_COUNT> IntrinsicMat; // Normal equations of the intrinsics
+typedef cv::Matx<double, PARAM_COUNT, 6> CouplingMat;             // Coupling of the intrinsics with one pose
+typedef cv::Vec<double, PARAM_COUNT> IntrinsicVec;                // Gradient or step of the intrinsics
+
+static const int jacobian_column[PARAM_COUNT] = {6, 7, 8, 9, 10, 11, 12, 13, 14}; // Column of each parameter in cv::projectPoints' jacobian
+
+/*
+ Blocks of the normal equations contributed by one view. The free intrinsics occupy the first entries of the intrinsic blocks.
+ */
+struct ViewBlocks
+{
+    IntrinsicMat U;    // Intrinsic block
+    IntrinsicVec gc;   // Intrinsic gradient
+    cv::Matx66d V;     // Pose block
+    cv::Vec6d ge;      // Pose gradient
+    CouplingMat W;     // Coupling block
+    cv::Matx66d V_inv; // Inverse of the damped pose block, kept for the back substitution
+};
+
+/*
+ Given the settings and the squared error of a corner, this function returns the corner's robust cost.
+ */
+static double robustCost(BundleParams &params, double squared)
+{
+    double scale2 = params.loss_scale * params.loss_scale;
+    switch (params.loss)
+    {
+    case LOSS_HUBER:
+        return (squared <= scale2 ? squared : 2.0 * params.loss_scale * sqrt(squared) - scale2);
+    case LOSS_CAUCHY:
+        return (scale2 * log1p(squared / scale2));
+    default:
+        return (squared);
+    }
+}
+
+/*
+ Given the settings and the squared error of a corner, this function returns the weight of the corner's rows
+ in the normal equations: the derivative of the robust cost with respect to the squared error.
+ */
+static double robustWeight(BundleParams &params, double squared)
+{
+    double scale2 = params.loss_scale * params.loss_scale;
+    switch (params.loss)
+    {
+    case LOSS_HUBER:
+        return (squared <= scale2 ? 1.0 : params.loss_scale / sqrt(squared));
+    case LOSS_CAUCHY:
+        return (1.0 / (1.0 + squared / scale2));
+    default:
+        return (1.0);
+    }
+}
+
+/*
+ Given the intrinsic parameter vector, this function builds the camera matrix and distortion coefficients.
+ */
+static int modelMatrices(const double *c, cv::Mat &camera_matrix, cv::Mat &dist_coeff)
+{
+    camera_matrix = (cv::Mat_<double>(3, 3) << c[PARAM_FX], 0, c[PARAM_CX], 0, c[PARAM_FY], c[PARAM_CY], 0, 0, 1);
+    dist_coeff = (cv::Mat_<double>(1, 5) << c[PARAM_K1], c[PARAM_K2], c[PARAM_P1], c[PARAM_P2], c[PARAM_K3]);
+
+    return (0);
+}
+
+/*
+ Given a view, the intrinsics and the view's pose, this function returns the view's robust cost and adds its squared error to squared.
+ */
+static double viewCost(cv::Mat &points, cv::Mat &corners, const double *c, cv::Vec3d &rot, cv::Vec3d &trans, BundleParams &params, double &squared)
+{
+    cv::Mat camera_matrix, dist_coeff;
+    modelMatrices(c, camera_matrix, dist_coeff);
+    std::vector<cv::Point2d> projected;
+    cv::projectPoints(points, rot, trans, camera_matrix, dist_coeff, projected);
+
+    const cv::Point2f *observed = corners.ptr<cv::Point2f>();
+    double cost = 0.0;
+    for (size_t j = 0; j < projected.size(); j++)
+    {
+        double ex = projected[j].x - observed[j].x;
+        double ey = projected[j].y - observed[j].y;
+        squared += ex * ex + ey * ey;
+        cost += robustCost(params, ex * ex + ey * ey);
+    }
+
+    return (cost);
+}
+
+/*
+ Given a view, the intrinsics, the view's pose, the free intrinsics and the aspect ratio, this function linearises the view
+ and populates its blocks of the normal equations. With the aspect ratio fixed, fy follows fx, so the fy column is folded into fx.
+ */
+static int linearizeView(cv::Mat &points, cv::Mat &corners, const double *c, cv::Vec3d &rot, cv::Vec3d &trans,
+                         std::vector<int> &free, double aspect, BundleParams &params, ViewBlocks &blocks)
+{
+    cv::Mat camera_matrix, dist_coeff, jacobian;
+    modelMatrices(c, camera_matrix, dist_coeff);
+    std::vector<cv::Point2d> projected;
+    cv::projectPoints(points, rot, trans, camera_matrix, dist_coeff, projected, jacobian);
+
+    blocks = ViewBlocks();
+    const cv::Point2f *observed = corners.ptr<cv::Point2f>();
+    for (size_t j = 0; j < projected.size(); j++)
+    {
+        double e[2] = {projected[j].x - observed[j].x, projected[j].y - observed[j].y};
+        double w = robustWeight(params, e[0] * e[0] + e[1] * e[1]);
+
+        for (int axis = 0; axis < 2; axis++)
+        {
+            const double *row = jacobian.ptr<double>(2 * (int)j + axis);
+            double a[PARAM_COUNT];
+            for (size_t k = 0; k < free.size(); k++)
+            {
+                a[k] = row[jacobian_column[free[k]]];
+                a[k] += free[k] == PARAM_FX && params.fix_aspect_ratio ? aspect * row[jacobian_column[PARAM_FY]] : 0.0;
+            }
+            const double *b = row; // Rotation and translation are the first six columns
+
+            for (size_t k = 0; k < free.size(); k++)
+            {
+                for (size_t l = 0; l <= k; l++)
+                {
+                    blocks.U(k, l) += w * a[k] * a[l];
+                }
+                for (int l = 0; l < 6; l++)
+                {
+                    blocks.W(k, l) += w * a[k] * b[l];
+                }
+                blocks.gc[k] += w * a[k] * e[axis];
+            }
+            for (int k = 0; k < 6; k++)
+            {
+                for (int l = 0; l <= k; l++)
+                {
+                    blocks.V(k, l) += w * b[k] * b[l];
+                }
+                blocks.ge[k] += w * b[k] * e[axis];
+            }
+        }
+    }
+
+    // Only the lower triangles were accumulated
+    for (int k = 0; k < PARAM_COUNT; k++)
+    {
+        for (int l = 0; l < k; l++)
+        {
+            blocks.U(l, k) = blocks.U(k, l);
+        }
+    }
+    for (int k = 0; k < 6; k++)
+    {
+        for (int l = 0; l < k; l++)
+        {
+            blocks.V(l, k) = blocks.V(k, l);
+        }
+    }
+
+    return (0);
+}
+
+/*
+ Given the blocks of every view, the summed intrinsic block and gradient, the number of free intrinsics and the damping,
+ this function eliminates the poses with the Schur complement, solves the reduced system for the intrinsic step
+ and back-substitutes the step of every pose. Each view's share is computed in parallel and summed in view order,
+ so the result does not depend on the scheduling.
+ */
+static int solveStep(std::vector<ViewBlocks> &blocks, IntrinsicMat &U, IntrinsicVec &gc, int m, double lambda,
+                     IntrinsicVec &dc, std::vector<cv::Vec6d> &de)
+{
+    int n = (int)blocks.size();
+    std::vector<IntrinsicMat> reduced(n);
+    std::vector<IntrinsicVec> rhs(n);
+    cv::parallel_for_(cv::Range(0, n), [&](const cv::Range &range)
+                      {
+        for (int i = range.start; i < range.end; i++)
+        {
+            ViewBlocks &view = blocks[i];
+            cv::Matx66d damped = view.V;
+            for (int k = 0; k < 6; k++)
+            {
+                damped(k, k) += lambda * view.V(k, k) + 1e-12;
+            }
+            bool ok = false;
+            view.V_inv = damped.inv(cv::DECOMP_CHOLESKY, &ok);
+            if (!ok)
+            {
+                view.V_inv = damped.inv(cv::DECOMP_SVD);
+            }
+            CouplingMat WV = view.W * view.V_inv;
+            reduced[i] = WV * view.W.t();
+            rhs[i] = WV * view.ge;
+        } });
+
+    // S dc = -gc + sum W V^-1 ge, with S = U - sum W V^-1 W^T
+    IntrinsicMat S = U;
+    IntrinsicVec b = -gc;
+    for (int i = 0; i < n; i++)
+    {
+        S -= reduced[i];
+        b += rhs[i];
+    }
+    for (int k = 0; k < PARAM_COUNT; k++)
+    {
+        if (k < m)
+        {
+            S(k, k) += lambda * U(k, k) + 1e-12;
+        }
+        else
+        {
+            S(k, k) = 1.0; // Unused slots of the fixed intrinsics
+            b[k] = 0.0;
+        }
+    }
+    dc = S.solve(b, cv::DECOMP_SVD);
+
+    // de = V^-1 (-ge - W^T dc)
+    de.resize(n);
+    cv::parallel_for_(cv::Range(0, n), [&](const cv::Range &range)
+                      {
+        for (int i = range.start; i < range.end; i++)
+        {
+            de[i] = blocks[i].V_inv * (-blocks[i].ge - blocks[i].W.t() * dc);
+        } });
+
+    return (0);
+}
+
+/*
+ Given the views, the intrinsics and the poses, this function returns the total robust cost, computing the views in parallel.
+ The squared error of all corners is written to squared.
+ */
+static double totalCost(std::vector<cv::Mat> &points, std::vector<cv::Mat> &corners, const double *c, std::vector<cv::Vec3d> &rot,
+                        std::vector<cv::Vec3d> &trans, BundleParams &params, double &squared)
+{
+    int n = (int)points.size();
+    std::vector<double> costs(n, 0.0), squares(n, 0.0);
+    cv::parallel_for_(cv::Range(0, n), [&](const cv::Range &range)
+                      {
+        for (int i = range.start; i < range.end; i++)
+        {
+            costs[i] = viewCost(points[i], corners[i], c, rot[i], trans[i], params, squares[i]);
+        } });
+
+    double cost = 0.0;
+    squared = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        cost += costs[i];
+        squared += squares[i];
+    }
+
+    return (cost);
+}
+
+/*
+ Given the settings and a command line argument, this function applies the argument when it is one of the solver's options
+ (--solver=opencv|sparse, --loss=squared|huber|cauchy[:SCALE], --fix=fx,cx,cy,k1,k2,p1,p2,k3) and returns true,
+ or returns false for any other argument.
+ */
+bool parseBundleArg(BundleParams &params, std::string arg)
+{
+    if (arg.rfind("--solver=", 0) == 0)
+    {
+        params.solver = arg.substr(9) == "sparse" ? SOLVER_SPARSE : SOLVER_OPENCV;
+    }
+    else if (arg.rfind("--loss=", 0) == 0)
+    {
+        std::string loss = arg.substr(7);
+        size_t colon = loss.find(':');
+        if (colon != std::string::npos)
+        {
+            params.loss_scale = std::max(1e-6, atof(loss.c_str() + colon + 1));
+            loss = loss.substr(0, colon);
+        }
+        params.loss = loss == "huber" ? LOSS_HUBER : loss == "cauchy" ? LOSS_CAUCHY
+                                                                      : LOSS_SQUARED;
+    }
+    else if (arg.rfind("--fix=", 0) == 0)
+    {
+        static const char *names[PARAM_COUNT] = {"fx", "fy", "cx", "cy", "k1", "k2", "p1", "p2", "k3"};
+        std::string list = arg.substr(6) + ",";
+        for (size_t start = 0, comma; (comma = list.find(',', start)) != std::string::npos; start = comma + 1)
+        {
+            std::string name = list.substr(start, comma - start);
+            for (int k = 0; k < PARAM_COUNT; k++)
+            {
+                params.fixed |= name == names[k] ? 1 << k : 0;
+            }
+        }
+    }
+    else
+    {
+        return (false);
+    }
+
+    return (true);
+}
+
+/*
+ Given one point set and one corner set per view, the image size, an initial camera matrix whose fx / fy gives the aspect ratio
+ and the settings, this function calibrates the camera with the sparse bundle adjustment.
+ The intrinsics are initialised from the views, the distortion from zero and the poses with solvePnP.
+ The camera matrix and the five distortion coefficients are populated, and the RMS reprojection error is returned.
+ */
+float calibrateBundle(std::vector<cv::Mat> &points_in, std::vector<cv::Mat> &corners_in, cv::Size image_size, cv::Mat &camera_matrix, cv::Mat &dist_coeff, BundleParams &params)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // A pose needs at least four corners
+    std::vector<cv::Mat> points, corners;
+    int total = 0;
+    for (size_t i = 0; i < points_in.size(); i++)
+    {
+        if (points_in[i].total() >= 4 && points_in[i].total() == corners_in[i].total())
+        {
+            points.push_back(points_in[i]);
+            corners.push_back(corners_in[i]);
+            total += (int)points_in[i].total();
+        }
+    }
+    int n = (int)points.size();
+    params.iterations = 0;
+    if (n == 0)
+    {
+        return (-1.0f);
+    }
+
+    // Same initialisation as cv::calibrateCamera: intrinsics from the homographies of the views, no distortion
+    double aspect = 1.0;
+    if (params.fix_aspect_ratio && camera_matrix.rows == 3 && camera_matrix.cols == 3)
+    {
+        cv::Mat initial;
+        camera_matrix.convertTo(initial, CV_64F);
+        aspect = initial.at<double>(1, 1) != 0.0 ? initial.at<double>(0, 0) / initial.at<double>(1, 1) : 1.0;
+    }
+    cv::Mat guess = cv::initCameraMatrix2D(points, corners, image_size, params.fix_aspect_ratio ? aspect : 0.0);
+    double c[PARAM_COUNT] = {guess.at<double>(0, 0), guess.at<double>(1, 1), guess.at<double>(0, 2), guess.at<double>(1, 2), 0, 0, 0, 0, 0};
+    aspect = c[PARAM_FY] / c[PARAM_FX];
+
+    // Fixed parameters are held at the caller's values when there are any: a camera matrix with a real focal length
+    // (the context's placeholder has fx = 1) and the distortion coefficients in OpenCV order k1, k2, p1, p2, k3
+    if (params.fixed && camera_matrix.rows == 3 && camera_matrix.cols == 3)
+    {
+        cv::Mat initial;
+        camera_matrix.convertTo(initial, CV_64F);
+        double supplied[PARAM_CY + 1] = {initial.at<double>(0, 0), initial.at<double>(1, 1), initial.at<double>(0, 2), initial.at<double>(1, 2)};
+        for (int k = PARAM_FX; k <= PARAM_CY; k++)
+        {
+            if (params.fixed & (1 << k) && supplied[PARAM_FX] > 1.0)
+            {
+                c[k] = supplied[k];
+            }
+        }
+    }
+    if (params.fixed && !dist_coeff.empty())
+    {
+        cv::Mat initial;
+        dist_coeff.reshape(1, 1).convertTo(initial, CV_64F);
+        for (int k = PARAM_K1; k <= PARAM_K3; k++)
+        {
+            if (params.fixed & (1 << k) && k - PARAM_K1 < initial.cols)
+            {
+                c[k] = initial.at<double>(0, k - PARAM_K1);
+            }
+        }
+    }
+    if (params.fix_aspect_ratio)
+    {
+        c[PARAM_FY] = aspect * c[PARAM_FX]; // fy follows a supplied fx
+    }
+    else
+    {
+        aspect = c[PARAM_FY] / c[PARAM_FX];
+    }
+
+    // Free intrinsics; with the aspect ratio fixed, fy is carried by fx
+    std::vector<int> free;
+    for (int k = 0; k < PARAM_COUNT; k++)
+    {
+        if (!(params.fixed & (1 << k)) && !(k == PARAM_FY && params.fix_aspect_ratio))
+        {
+            free.push_back(k);
+        }
+    }
+    int m = (int)free.size();
+
+    std::vector<cv::Vec3d> rot(n), trans(n);
+    cv::parallel_for_(cv::Range(0, n), [&](const cv::Range &range)
+                      {
+        cv::Mat K, D;
+        modelMatrices(c, K, D);
+        for (int i = range.start; i < range.end; i++)
+        {
+            cv::solvePnP(points[i], corners[i], K, D, rot[i], trans[i]);
+        } });
+
+    double squared = 0.0;
+    double cost = totalCost(points, corners, c, rot, trans, params, squared);
+    double lambda = 1e-3;
+    std::vector<ViewBlocks> blocks(n);
+    std::vector<cv::Vec6d> de;
+    IntrinsicVec dc;
+
+    while (params.iterations < params.max_iterations)
+    {
+        params.iterations++;
+        cv::parallel_for_(cv::Range(0, n), [&](const cv::Range &range)
+                          {
+            for (int i = range.start; i < range.end; i++)
+            {
+                linearizeView(points[i], corners[i], c, rot[i], trans[i], free, aspect, params, blocks[i]);
+            } });
+
+        IntrinsicMat U;
+        IntrinsicVec gc;
+        for (int i = 0; i < n; i++)
+        {
+            U += blocks[i].U;
+            gc += blocks[i].gc;
+        }
+
+        // Raise the damping until the step lowers the cost
+        bool improved = false;
+        double decrease = 0.0;
+        for (int attempt = 0; attempt < 10 && !improved; attempt++)
+        {
+            solveStep(blocks, U, gc, m, lambda, dc, de);
+
+            double candidate[PARAM_COUNT];
+            std::copy(c, c + PARAM_COUNT, candidate);
+            for (int k = 0; k < m; k++)
+            {
+                candidate[free[k]] += dc[k];
+            }
+            if (params.fix_aspect_ratio)
+            {
+                candidate[PARAM_FY] = aspect * candidate[PARAM_FX];
+            }
+            std::vector<cv::Vec3d> rot_new(n), trans_new(n);
+            for (int i = 0; i < n; i++)
+            {
+                rot_new[i] = rot[i] + cv::Vec3d(de[i][0], de[i][1], de[i][2]);
+                trans_new[i] = trans[i] + cv::Vec3d(de[i][3], de[i][4], de[i][5]);
+            }
+
+            double squared_new = 0.0;
+            double cost_new = totalCost(points, corners, candidate, rot_new, trans_new, params, squared_new);
+            if (cost_new < cost)
+            {
+                decrease = (cost - cost_new) / std::max(cost, DBL_MIN);
+                std::copy(candidate, candidate + PARAM_COUNT, c);
+                rot.swap(rot_new);
+                trans.swap(trans_new);
+                cost = cost_new;
+                squared = squared_new;
+                lambda = std::max(lambda / 10.0, 1e-12);
+                improved = true;
+            }
+            else
+            {
+                lambda *= 10.0;
+            }
+        }
+        if (!improved || decrease < params.epsilon)
+        {
+            break;
+        }
+    }
+
+    cv::Mat K, D;
+    modelMatrices(c, K, D);
+    K.copyTo(camera_matrix);
+    D.copyTo(dist_coeff);
+    params.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return ((float)sqrt(squared / total));
+}
+
+/*
+ Given one point set and one corner set per view, the image size, an initial camera matrix and the settings,
+ this function calibrates the camera with the solver chosen in the settings and returns the RMS reprojection error.
+ The fixed parameters are passed to cv::calibrateCamera as the nearest calibration flags, and whatever the flags widen
+ or cannot hold is printed.
+ */
+float calibrateViews(std::vector<cv::Mat> &points, std::vector<cv::Mat> &corners, cv::Size image_size, cv::Mat &camera_matrix, cv::Mat &dist_coeff, BundleParams &params)
+{
+    if (params.solver == SOLVER_SPARSE)
+    {
+        float error = calibrateBundle(points, corners, image_size, camera_matrix, dist_coeff, params);
+        printf("Sparse solver: %zu views, %d iterations, %.1f ms\n", points.size(), params.iterations, params.ms);
+        return (error);
+    }
+
+    // The flags cannot hold every parameter on its own, so say what the mapping changes
+    int fixed_pp = params.fixed & (1 << PARAM_CX | 1 << PARAM_CY), fixed_tangent = params.fixed & (1 << PARAM_P1 | 1 << PARAM_P2);
+    if (params.fixed & (1 << PARAM_FX | 1 << PARAM_FY))
+    {
+        printf("OpenCV solver: fx and fy cannot be fixed and are calibrated, use --solver=sparse to hold them\n");
+    }
+    if (fixed_pp)
+    {
+        printf("OpenCV solver: %s the principal point at the image centre\n", fixed_pp == (1 << PARAM_CX | 1 << PARAM_CY) ? "fixing" : "cx or cy alone cannot be fixed, fixing");
+    }
+    if (fixed_tangent)
+    {
+        printf("OpenCV solver: %s p1 and p2 to zero\n", fixed_tangent == (1 << PARAM_P1 | 1 << PARAM_P2) ? "setting" : "p1 or p2 alone cannot be fixed, setting");
+    }
+
+    int flags = params.fix_aspect_ratio ? cv::CALIB_FIX_ASPECT_RATIO : 0;
+    flags |= params.fixed & (1 << PARAM_CX | 1 << PARAM_CY) ? cv::CALIB_FIX_PRINCIPAL_POINT : 0;
+    flags |= params.fixed & (1 << PARAM_P1 | 1 << PARAM_P2) ? cv::CALIB_ZERO_TANGENT_DIST : 0;
+    flags |= params.fixed & 1 << PARAM_K1 ? cv::CALIB_FIX_K1 : 0;
+    flags |= params.fixed & 1 << PARAM_K2 ? cv::CALIB_FIX_K2 : 0;
+    flags |= params.fixed & 1 << PARAM_K3 ? cv::CALIB_FIX_K3 : 0;
+
+    std::vector<cv::Mat> rot, trans;
+    float error = cv::calibrateCamera(points, corners, image_size, camera_matrix, dist_coeff, rot, trans, flags,
+                                      cv::TermCriteria(cv::TermCriteria::MAX_ITER + cv::TermCriteria::EPS, params.max_iterations, DBL_EPSILON));
+
+    return (error);
+}
@@ -0,0 +1,99 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for calibrating a camera from many views with a sparse Levenberg-Marquardt bundle adjustment.
+The normal equations are block sparse: the intrinsics couple every view, but the pose of a view only couples with its own corners.
+The poses are eliminated with the Schur complement, so each iteration solves one small system for the intrinsics
+and costs time linear in the number of views.
+*/
+
+#ifndef bundle_hpp
+#define bundle_hpp
+
+#include <stdio.h>
+#include <iostream>
+#include <float.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/calib3d.hpp>
+
+/*
+ Solvers a calibration can be run with.
+ */
+enum CalibSolver
+{
+    SOLVER_OPENCV, // cv::calibrateCamera
+    SOLVER_SPARSE  // Schur complement bundle adjustment in calibrateBundle
+};
+
+/*
+ Losses applied to the reprojection error of each corner, in pixels.
+ */
+enum RobustLoss
+{
+    LOSS_SQUARED, // Plain least squares
+    LOSS_HUBER,   // Quadratic up to the loss scale, linear beyond it
+    LOSS_CAUCHY   // Logarithmic beyond the loss scale, so gross outliers have almost no pull
+};
+
+/*
+ Intrinsic parameters, in the order of the solver's parameter vector. Used as bit positions of BundleParams::fixed.
+ */
+enum CalibParam
+{
+    PARAM_FX,
+    PARAM_FY,
+    PARAM_CX,
+    PARAM_CY,
+    PARAM_K1,
+    PARAM_K2,
+    PARAM_P1,
+    PARAM_P2,
+    PARAM_K3,
+    PARAM_COUNT
+};
+
+/*
+ Settings of a calibration and the solver's statistics.
+ */
+struct BundleParams
+{
+    CalibSolver solver = SOLVER_OPENCV; // Solver used by calibrateViews, e.g. --solver=sparse
+    RobustLoss loss = LOSS_SQUARED;     // Loss of the sparse solver, e.g. --loss=huber:1.5
+    double loss_scale = 1.0;            // Error in pixels where a robust loss stops being quadratic
+    bool fix_aspect_ratio = true;       // Keep fx / fy at its initial value, as CALIB_FIX_ASPECT_RATIO does
+    int fixed = 0;                      // Bit mask of CalibParam values held at their initial values, e.g. --fix=k3,p1,p2
+    int max_iterations = 30;            // Linearisations before the solver stops
+    double epsilon = DBL_EPSILON;       // Relative decrease of the cost below which the solver stops
+    int iterations = 0;                 // Linearisations performed by the last solve
+    double ms = 0.0;                    // Duration of the last solve
+};
+
+/*
+ Given the settings and a command line argument, this function applies the argument when it is one of the solver's options
+ (--solver=opencv|sparse, --loss=squared|huber|cauchy[:SCALE], --fix=fx,cx,cy,k1,k2,p1,p2,k3) and returns true,
+ or returns false for any other argument.
+ */
+bool parseBundleArg(BundleParams &params, std::string arg);
+
+/*
+ Given one point set and one corner set per view, the image size, an initial camera matrix whose fx / fy gives the aspect ratio
+ and the settings, this function calibrates the camera with the sparse bundle adjustment.
+ The intrinsics are initialised from the views, the distortion from zero and the poses with solvePnP; fixed parameters
+ keep the values of the given camera matrix and distortion coefficients when those are supplied.
+ The camera matrix and the five distortion coefficients are populated, and the RMS reprojection error is returned.
+ */
+float calibrateBundle(std::vector<cv::Mat> &points, std::vector<cv::Mat> &corners, cv::Size image_size, cv::Mat &camera_matrix, cv::Mat &dist_coeff, BundleParams &params);
+
+/*
+ Given one point set and one corner set per view, the image size, an initial camera matrix and the settings,
+ this function calibrates the camera with the solver chosen in the settings and returns the RMS reprojection error.
+ The fixed parameters are passed to cv::calibrateCamera as the nearest calibration flags, and whatever the flags widen
+ or cannot hold is printed.
+ */
+float calibrateViews(std::vector<cv::Mat> &points, std::vector<cv::Mat> &corners, cv::Size image_size, cv::Mat &camera_matrix, cv::Mat &dist_coeff, BundleParams &params);
+
+#endif /* bundle_hpp */
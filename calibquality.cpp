@@ -0,0 +1,243 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for measuring calibration quality: per-view and per-point reprojection errors, outlier view rejection and residual reports.
+*/
+
+#include <numeric>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "calibquality.h"
+
+/*
+ Given vectors having a list of point sets and corner sets, camera matrix, distortion coefficients and the pose of each view,
+ this function computes the reprojection error of every point of every view in one vectorised pass
+ and the RMS reprojection error of each view.
+ */
+int computeReprojectionErrors(std::vector<std::vector<cv::Vec3f>> &points_list, std::vector<std::vector<cv::Point2f>> &corners_list, cv::Mat &camera_matrix, cv::Mat &dist_coeff, std::vector<cv::Mat> &rot, std::vector<cv::Mat> &trans, cv::Mat &point_errors, std::vector<double> &view_errors)
+{
+    int views = (int)points_list.size();
+
+    // Offsets of each view in the flattened point arrays
+    std::vector<int> offsets(views + 1, 0);
+    for (int v = 0; v < views; v++)
+    {
+        offsets[v + 1] = offsets[v] + (int)points_list[v].size();
+    }
+    int total = offsets[views];
+
+    // Flatten all views and move every point into its camera frame
+    cv::Mat world(total, 1, CV_64FC3);    // World coordinates of all points
+    cv::Mat camera(total, 1, CV_64FC3);   // Camera coordinates of all points
+    cv::Mat observed(total, 1, CV_64FC2); // Detected image coordinates of all points
+    for (int v = 0; v < views; v++)
+    {
+        for (int i = 0; i < (int)points_list[v].size(); i++)
+        {
+            cv::Vec3f &point = points_list[v][i];
+            cv::Point2f &corner = corners_list[v][i];
+            world.at<cv::Vec3d>(offsets[v] + i) = cv::Vec3d(point[0], point[1], point[2]);
+            observed.at<cv::Vec2d>(offsets[v] + i) = cv::Vec2d(corner.x, corner.y);
+        }
+
+        cv::Mat R, Rt;
+        cv::Rodrigues(rot[v], R);
+        cv::hconcat(R, trans[v].reshape(1, 3), Rt);
+        cv::transform(world.rowRange(offsets[v], offsets[v + 1]), camera.rowRange(offsets[v], offsets[v + 1]), Rt);
+    }
+
+    // Pinhole projection with radial and tangential distortion evaluated on whole columns at once
+    double k[5] = {0, 0, 0, 0, 0}; // k1, k2, p1, p2, k3
+    cv::Mat dist;
+    dist_coeff.convertTo(dist, CV_64F);
+    for (int i = 0; i < std::min(5, (int)dist.total()); i++)
+    {
+        k[i] = dist.at<double>(i);
+    }
+    double fx = camera_matrix.at<double>(0, 0), fy = camera_matrix.at<double>(1, 1);
+    double cx = camera_matrix.at<double>(0, 2), cy = camera_matrix.at<double>(1, 2);
+
+    cv::Mat xyz[3], uv[2];
+    cv::split(camera, xyz);
+    cv::split(observed, uv);
+
+    cv::Mat x = xyz[0] / xyz[2];
+    cv::Mat y = xyz[1] / xyz[2];
+    cv::Mat xy = x.mul(y);
+    cv::Mat r2 = x.mul(x) + y.mul(y);
+    cv::Mat r4 = r2.mul(r2);
+    cv::Mat radial = 1 + k[0] * r2 + k[1] * r4 + k[4] * r4.mul(r2);
+    cv::Mat xd = x.mul(radial) + 2 * k[2] * xy + k[3] * (r2 + 2 * x.mul(x));
+    cv::Mat yd = y.mul(radial) + k[2] * (r2 + 2 * y.mul(y)) + 2 * k[3] * xy;
+
+    cv::Mat du = fx * xd + cx - uv[0];
+    cv::Mat dv = fy * yd + cy - uv[1];
+    cv::magnitude(du, dv, point_errors);
+
+    // RMS of each view from its block of the flattened errors
+    view_errors.assign(views, 0.0);
+    for (int v = 0; v < views; v++)
+    {
+        cv::Mat block = point_errors.rowRange(offsets[v], offsets[v + 1]);
+        int n = offsets[v + 1] - offsets[v];
+        view_errors[v] = n > 0 ? std::sqrt(block.dot(block) / n) : 0.0;
+    }
+
+    return (0);
+}
+
+/*
+ Given vectors having a list of point sets and corner sets, the image size, camera matrix and distortion coefficients,
+ this function calibrates the camera and then repeatedly drops the worst view while its RMS error is above the threshold,
+ re-solving from the previous intrinsics each time. At least min_views views are always kept.
+ The report is populated with the kept and dropped views, the per-point errors and a residual heatmap.
+ This function also returns the reprojection error of the final calibration.
+ */
+float calibrateWithOutlierRejection(std::vector<std::vector<cv::Vec3f>> &points_list, std::vector<std::vector<cv::Point2f>> &corners_list, cv::Size image_size, cv::Mat &camera_matrix, cv::Mat &dist_coeff, double threshold, int min_views, CalibrationReport &report)
+{
+    report = CalibrationReport();
+
+    std::vector<int> kept(points_list.size()); // Indices of the views still in use
+    std::iota(kept.begin(), kept.end(), 0);
+
+    std::vector<std::vector<cv::Vec3f>> points;    // Point sets of the views still in use
+    std::vector<std::vector<cv::Point2f>> corners; // Corner sets of the views still in use
+    std::vector<cv::Mat> rot, trans;               // Pose of each view
+    std::vector<double> view_errors;               // RMS error of each view
+    cv::Mat point_errors;                          // Error of each point
+    int flags = cv::CALIB_FIX_ASPECT_RATIO;
+    float error = 0.0f;
+
+    while (true)
+    {
+        points.clear();
+        corners.clear();
+        for (int index : kept)
+        {
+            points.push_back(points_list[index]);
+            corners.push_back(corners_list[index]);
+        }
+
+        error = cv::calibrateCamera(points, corners, image_size, camera_matrix, dist_coeff, rot, trans, flags,
+                                    cv::TermCriteria(cv::TermCriteria::MAX_ITER + cv::TermCriteria::EPS, 30, DBL_EPSILON));
+        report.rounds++;
+
+        computeReprojectionErrors(points, corners, camera_matrix, dist_coeff, rot, trans, point_errors, view_errors);
+
+        // Stop once every remaining view is under the threshold or there is nothing left to drop
+        int worst = (int)(std::max_element(view_errors.begin(), view_errors.end()) - view_errors.begin());
+        if (view_errors[worst] <= threshold || (int)kept.size() <= min_views)
+        {
+            break;
+        }
+
+        report.dropped_views.push_back(kept[worst]);
+        report.dropped_errors.push_back(view_errors[worst]);
+        kept.erase(kept.begin() + worst);
+
+        // Seed the next solve with the intrinsics just found
+        flags |= cv::CALIB_USE_INTRINSIC_GUESS;
+    }
+
+    report.rms = error;
+    report.kept_views = kept;
+    report.view_errors = view_errors;
+    report.point_errors = point_errors;
+    residualHeatmap(corners, point_errors, image_size, cv::Size(16, 9), report.heatmap);
+
+    return (error);
+}
+
+/*
+ Given a list of corner sets, the matching per-point errors, the image size and the number of cells,
+ this function builds a colour coded map of the mean residual in each cell of the sensor, resized to the image size.
+ Cells without any corner are left black.
+ */
+int residualHeatmap(std::vector<std::vector<cv::Point2f>> &corners_list, cv::Mat &point_errors, cv::Size image_size, cv::Size grid, cv::Mat &heatmap)
+{
+    cv::Mat sum = cv::Mat::zeros(grid, CV_64F);   // Sum of the residuals in each cell
+    cv::Mat count = cv::Mat::zeros(grid, CV_32S); // Number of corners in each cell
+
+    int index = 0;
+    for (auto &corners : corners_list)
+    {
+        for (auto &corner : corners)
+        {
+            int cx = std::min(grid.width - 1, std::max(0, (int)(corner.x * grid.width / image_size.width)));
+            int cy = std::min(grid.height - 1, std::max(0, (int)(corner.y * grid.height / image_size.height)));
+            sum.at<double>(cy, cx) += point_errors.at<double>(index++);
+            count.at<int>(cy, cx)++;
+        }
+    }
+
+    // Mean residual per cell, scaled so the worst cell is the hottest
+    cv::Mat mean = cv::Mat::zeros(grid, CV_64F);
+    double max_mean = 1e-9;
+    for (int y = 0; y < grid.height; y++)
+    {
+        for (int x = 0; x < grid.width; x++)
+        {
+            if (count.at<int>(y, x) > 0)
+            {
+                mean.at<double>(y, x) = sum.at<double>(y, x) / count.at<int>(y, x);
+                max_mean = std::max(max_mean, mean.at<double>(y, x));
+            }
+        }
+    }
+
+    cv::Mat scaled, colour;
+    mean.convertTo(scaled, CV_8U, 255.0 / max_mean);
+    cv::applyColorMap(scaled, colour, cv::COLORMAP_JET);
+    colour.setTo(cv::Scalar(0, 0, 0), count == 0);
+
+    cv::resize(colour, heatmap, image_size, 0, 0, cv::INTER_NEAREST);
+
+    return (0);
+}
+
+/*
+ Given a calibration report and a file prefix, this function writes the per-view errors to <prefix>.txt
+ and the residual heatmap to <prefix>-heatmap.png.
+ */
+int writeCalibrationReport(CalibrationReport &report, std::string prefix)
+{
+    std::string fname = prefix + ".txt";
+    FILE *fp = fopen(fname.c_str(), "w");
+    if (fp == NULL)
+    {
+        printf("Unable to open %s for writing\n", fname.c_str());
+        return (-1);
+    }
+
+    fprintf(fp, "re-projection error: %f\n", report.rms);
+    fprintf(fp, "calibration rounds: %d\n", report.rounds);
+    fprintf(fp, "kept views: %d\n", (int)report.kept_views.size());
+    for (size_t i = 0; i < report.kept_views.size(); i++)
+    {
+        fprintf(fp, "  view %d \t %f\n", report.kept_views[i] + 1, report.view_errors[i]);
+    }
+    fprintf(fp, "dropped views: %d\n", (int)report.dropped_views.size());
+    for (size_t i = 0; i < report.dropped_views.size(); i++)
+    {
+        fprintf(fp, "  view %d \t %f\n", report.dropped_views[i] + 1, report.dropped_errors[i]);
+    }
+
+    if (!report.point_errors.empty())
+    {
+        double max_error;
+        cv::minMaxLoc(report.point_errors, NULL, &max_error);
+        fprintf(fp, "largest point error: %f\n", max_error);
+    }
+    fclose(fp);
+
+    if (!report.heatmap.empty())
+    {
+        cv::imwrite(prefix + "-heatmap.png", report.heatmap);
+    }
+
+    return (0);
+}
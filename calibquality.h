@@ -0,0 +1,65 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for measuring calibration quality: per-view and per-point reprojection errors, outlier view rejection and residual reports.
+*/
+
+#ifndef calibquality_hpp
+#define calibquality_hpp
+
+#include <stdio.h>
+#include <iostream>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/calib3d.hpp>
+
+/*
+ Result of the calibration quality stage.
+ View indices refer to the positions of the views in the lists passed to calibrateWithOutlierRejection.
+ */
+struct CalibrationReport
+{
+    double rms = 0.0;                   // Reprojection error of the final calibration
+    int rounds = 0;                     // Number of calibrations performed
+    std::vector<int> kept_views;        // Indices of the views used by the final calibration
+    std::vector<double> view_errors;    // RMS reprojection error of each kept view
+    std::vector<int> dropped_views;     // Indices of the rejected views, in the order they were dropped
+    std::vector<double> dropped_errors; // RMS reprojection error of each rejected view when it was dropped
+    cv::Mat point_errors;               // Reprojection error of every point of the kept views (CV_64F, one row per point)
+    cv::Mat heatmap;                    // Colour coded mean residual across the sensor
+};
+
+/*
+ Given vectors having a list of point sets and corner sets, camera matrix, distortion coefficients and the pose of each view,
+ this function computes the reprojection error of every point of every view in one vectorised pass
+ and the RMS reprojection error of each view.
+ */
+int computeReprojectionErrors(std::vector<std::vector<cv::Vec3f>> &points_list, std::vector<std::vector<cv::Point2f>> &corners_list, cv::Mat &camera_matrix, cv::Mat &dist_coeff, std::vector<cv::Mat> &rot, std::vector<cv::Mat> &trans, cv::Mat &point_errors, std::vector<double> &view_errors);
+
+/*
+ Given vectors having a list of point sets and corner sets, the image size, camera matrix and distortion coefficients,
+ this function calibrates the camera and then repeatedly drops the worst view while its RMS error is above the threshold,
+ re-solving from the previous intrinsics each time. At least min_views views are always kept.
+ The report is populated with the kept and dropped views, the per-point errors and a residual heatmap.
+ This function also returns the reprojection error of the final calibration.
+ */
+float calibrateWithOutlierRejection(std::vector<std::vector<cv::Vec3f>> &points_list, std::vector<std::vector<cv::Point2f>> &corners_list, cv::Size image_size, cv::Mat &camera_matrix, cv::Mat &dist_coeff, double threshold, int min_views, CalibrationReport &report);
+
+/*
+ Given a list of corner sets, the matching per-point errors, the image size and the number of cells,
+ this function builds a colour coded map of the mean residual in each cell of the sensor, resized to the image size.
+ Cells without any corner are left black.
+ */
+int residualHeatmap(std::vector<std::vector<cv::Point2f>> &corners_list, cv::Mat &point_errors, cv::Size image_size, cv::Size grid, cv::Mat &heatmap);
+
+/*
+ Given a calibration report and a file prefix, this function writes the per-view errors to <prefix>.txt
+ and the residual heatmap to <prefix>-heatmap.png.
+ */
+int writeCalibrationReport(CalibrationReport &report, std::string prefix);
+
+#endif /* calibquality_hpp */
@@ -0,0 +1,184 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for detecting partially visible ChArUco boards, several per frame, and for calibrating and estimating poses
+from whichever corners are visible.
+*/
+
+#include "charuco.h"
+
+/*
+ Given the board set, the number of boards and the squares per board,
+ this function creates the boards with disjoint marker ID ranges and their detectors.
+ */
+int initCharucoBoards(CharucoBoardSet &set, int count, cv::Size squares)
+{
+    set.squares = squares;
+    set.markers_per_board = squares.area() / 2; // Markers sit in the white squares
+    set.dictionary = cv::aruco::getPredefinedDictionary(cv::aruco::DICT_4X4_250);
+    set.boards.clear();
+    set.detectors.clear();
+
+    int max_boards = 250 / set.markers_per_board;
+    if (count > max_boards)
+    {
+        printf("Only %d boards of %dx%d squares fit in the marker dictionary\n", max_boards, squares.width, squares.height);
+        count = max_boards;
+    }
+
+    for (int k = 0; k < count; k++)
+    {
+        std::vector<int> ids(set.markers_per_board);
+        for (int i = 0; i < set.markers_per_board; i++)
+        {
+            ids[i] = k * set.markers_per_board + i;
+        }
+
+        // Square side of one unit, so world coordinates match the 9x6 chessboard
+        set.boards.push_back(cv::aruco::CharucoBoard(squares, 1.0f, set.marker_length, set.dictionary, ids));
+        set.detectors.push_back(cv::aruco::CharucoDetector(set.boards.back()));
+    }
+
+    set.marker_detector = cv::makePtr<cv::aruco::ArucoDetector>(set.dictionary);
+
+    return (0);
+}
+
+/*
+ Given the board set, the index of a board and a cv::Mat for the output,
+ this function renders the board for printing with the given number of pixels per square.
+ */
+int renderCharucoBoard(CharucoBoardSet &set, int board, cv::Mat &image, int pixels_per_square)
+{
+    // Half a square of white margin on every side, so the outer markers stay detectable when printed
+    int margin = pixels_per_square / 2;
+    cv::Size size(set.squares.width * pixels_per_square + 2 * margin, set.squares.height * pixels_per_square + 2 * margin);
+    set.boards[board].generateImage(size, image, margin);
+
+    return (0);
+}
+
+/*
+ Given the board set and the IDs of the visible corners of a board,
+ this function checks that the corners span at least two rows and two columns, so that they fix a plane pose.
+ */
+static bool cornersSpanPlane(CharucoBoardSet &set, std::vector<int> &ids)
+{
+    int per_row = set.squares.width - 1;
+    int first_row = ids[0] / per_row, first_col = ids[0] % per_row;
+    bool rows = false, cols = false;
+    for (int id : ids)
+    {
+        rows = rows || id / per_row != first_row;
+        cols = cols || id % per_row != first_col;
+    }
+
+    return (rows && cols);
+}
+
+/*
+ Given the board set, a grayscale frame, the camera matrix and distortion coefficients and a vector of views,
+ this function finds the markers of all boards in one pass, then interpolates and refines the visible corners
+ of each board in parallel and populates the vector with one view per board that shows at least min_corners corners.
+ When the camera matrix is not empty, each view also gets the board pose solved from its visible corners.
+ */
+int detectCharucoBoards(CharucoBoardSet &set, cv::Mat &gray, cv::Mat &camera_matrix, cv::Mat &dist_coeff, std::vector<CharucoView> &views)
+{
+    views.clear();
+
+    std::vector<std::vector<cv::Point2f>> marker_corners;
+    std::vector<int> marker_ids;
+    set.marker_detector->detectMarkers(gray, marker_corners, marker_ids);
+
+    // Hand every marker to the board its ID belongs to
+    int count = (int)set.boards.size();
+    std::vector<std::vector<std::vector<cv::Point2f>>> board_corners(count);
+    std::vector<std::vector<int>> board_ids(count);
+    for (size_t i = 0; i < marker_ids.size(); i++)
+    {
+        int board = marker_ids[i] / set.markers_per_board;
+        if (board < count)
+        {
+            board_corners[board].push_back(marker_corners[i]);
+            board_ids[board].push_back(marker_ids[i]);
+        }
+    }
+
+    std::vector<CharucoView> found(count);
+    std::vector<char> visible(count, 0); // Not vector<bool>: its packed bits cannot be written from several threads
+    cv::parallel_for_(cv::Range(0, count), [&](const cv::Range &range)
+                      {
+                          for (int k = range.start; k < range.end; k++)
+                          {
+                              // A board without markers is not in view; passing it on would make the detector search the frame again
+                              if (board_ids[k].empty())
+                              {
+                                  continue;
+                              }
+
+                              CharucoView &view = found[k];
+                              view.board = k;
+                              set.detectors[k].detectBoard(gray, view.corners, view.ids, board_corners[k], board_ids[k]);
+                              if ((int)view.ids.size() < set.min_corners)
+                              {
+                                  continue;
+                              }
+
+                              // Board coordinates run down the rows; the rest of the project has y pointing up the board
+                              const std::vector<cv::Point3f> &board_points = set.boards[k].getChessboardCorners();
+                              for (int id : view.ids)
+                              {
+                                  view.points.push_back(cv::Vec3f(board_points[id].x, -board_points[id].y, 0.0f));
+                              }
+
+                              if (!camera_matrix.empty() && cornersSpanPlane(set, view.ids))
+                              {
+                                  // IPPE handles the few, planar points of a partial view without an initial guess
+                                  view.posed = cv::solvePnP(view.points, view.corners, camera_matrix, dist_coeff, view.rot, view.trans, false, cv::SOLVEPNP_IPPE);
+                              }
+                              visible[k] = 1;
+                          } });
+
+    for (int k = 0; k < count; k++)
+    {
+        if (visible[k])
+        {
+            views.push_back(found[k]);
+        }
+    }
+
+    return (0);
+}
+
+/*
+ Given a cv::Mat of the image frame and the views found in it,
+ this function draws the visible corners of every board with their IDs.
+ */
+int drawCharucoViews(cv::Mat &dst, std::vector<CharucoView> &views)
+{
+    for (auto &view : views)
+    {
+        cv::aruco::drawDetectedCornersCharuco(dst, view.corners, view.ids, cv::Scalar(0, 0, 255));
+        cv::putText(dst, "board " + std::to_string(view.board), view.corners[0] + cv::Point2f(8, -8), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 255), 2);
+    }
+
+    return (0);
+}
+
+/*
+ Given vectors having a list of point sets and corner sets of partial views, the image size and an initial camera matrix,
+ this function calibrates the camera and returns the reprojection error. Views may have different numbers of corners.
+ */
+float calibrateCharuco(std::vector<std::vector<cv::Vec3f>> &points_list, std::vector<std::vector<cv::Point2f>> &corners_list, cv::Size image_size, cv::Mat &camera_matrix, cv::Mat &dist_coeff)
+{
+    std::vector<cv::Mat> rot, trans;
+
+    // Same model and termination as the chessboard calibration in main.cpp
+    float error = cv::calibrateCamera(points_list, corners_list, image_size, camera_matrix, dist_coeff, rot, trans, cv::CALIB_FIX_ASPECT_RATIO,
+                                      cv::TermCriteria(cv::TermCriteria::MAX_ITER + cv::TermCriteria::EPS, 30, DBL_EPSILON));
+
+    return (error);
+}
@@ -0,0 +1,83 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for detecting partially visible ChArUco boards, several per frame, and for calibrating and estimating poses
+from whichever corners are visible.
+*/
+
+#ifndef charuco_hpp
+#define charuco_hpp
+
+#include <stdio.h>
+#include <iostream>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/objdetect/charuco_detector.hpp>
+
+/*
+ The printed boards and their detectors. Every board has its own range of marker IDs,
+ so a marker identifies both the board and the square it sits in.
+ */
+struct CharucoBoardSet
+{
+    cv::Size squares = {5, 7};                         // Squares per row and per column of each board
+    float marker_length = 0.7f;                        // Marker side, as a fraction of the square side
+    int min_corners = 6;                               // Fewest visible corners a board needs for a pose or a calibration view
+    cv::aruco::Dictionary dictionary;                  // Marker dictionary shared by all boards
+    std::vector<cv::aruco::CharucoBoard> boards;       // One entry per printed board
+    std::vector<cv::aruco::CharucoDetector> detectors; // Corner detector of each board
+    cv::Ptr<cv::aruco::ArucoDetector> marker_detector; // Finds the markers of every board in one pass
+    int markers_per_board = 0;                         // Size of each board's marker ID range
+};
+
+/*
+ The visible part of one board in a frame.
+ */
+struct CharucoView
+{
+    int board = 0;                    // Index of the board in the set
+    std::vector<int> ids;             // IDs of the visible chessboard corners
+    std::vector<cv::Point2f> corners; // Image coordinates of the visible corners
+    std::vector<cv::Vec3f> points;    // World coordinates of the visible corners, one unit per square
+    cv::Mat rot, trans;               // Pose of the board, when a camera model was given and the corners allow one
+    bool posed = false;               // True when rot and trans hold a pose
+};
+
+/*
+ Given the board set, the number of boards and the squares per board,
+ this function creates the boards with disjoint marker ID ranges and their detectors.
+ */
+int initCharucoBoards(CharucoBoardSet &set, int count, cv::Size squares = cv::Size(5, 7));
+
+/*
+ Given the board set, the index of a board and a cv::Mat for the output,
+ this function renders the board for printing with the given number of pixels per square.
+ */
+int renderCharucoBoard(CharucoBoardSet &set, int board, cv::Mat &image, int pixels_per_square = 120);
+
+/*
+ Given the board set, a grayscale frame, the camera matrix and distortion coefficients and a vector of views,
+ this function finds the markers of all boards in one pass, then interpolates and refines the visible corners
+ of each board in parallel and populates the vector with one view per board that shows at least min_corners corners.
+ When the camera matrix is not empty, each view also gets the board pose solved from its visible corners.
+ */
+int detectCharucoBoards(CharucoBoardSet &set, cv::Mat &gray, cv::Mat &camera_matrix, cv::Mat &dist_coeff, std::vector<CharucoView> &views);
+
+/*
+ Given a cv::Mat of the image frame and the views found in it,
+ this function draws the visible corners of every board with their IDs.
+ */
+int drawCharucoViews(cv::Mat &dst, std::vector<CharucoView> &views);
+
+/*
+ Given vectors having a list of point sets and corner sets of partial views, the image size and an initial camera matrix,
+ this function calibrates the camera and returns the reprojection error. Views may have different numbers of corners.
+ */
+float calibrateCharuco(std::vector<std::vector<cv::Vec3f>> &points_list, std::vector<std::vector<cv::Point2f>> &corners_list, cv::Size image_size, cv::Mat &camera_matrix, cv::Mat &dist_coeff);
+
+#endif /* charuco_hpp */
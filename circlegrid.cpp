@@ -0,0 +1,370 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for fast circle-grid detection: a blob detector whose threshold levels run in parallel,
+a search region taken from the last detection, and reuse of the previous grid ordering to skip grid clustering.
+*/
+
+#include "circlegrid.h"
+
+/*
+ A blob found at one threshold level.
+ */
+struct BlobCenter
+{
+    cv::Point2d location;
+    double radius;
+};
+
+ParallelBlobDetector::ParallelBlobDetector(const cv::SimpleBlobDetector::Params &blob_params) : params(blob_params)
+{
+}
+
+cv::Ptr<ParallelBlobDetector> ParallelBlobDetector::create(const cv::SimpleBlobDetector::Params &blob_params)
+{
+    return (cv::makePtr<ParallelBlobDetector>(blob_params));
+}
+
+/*
+ Given the blob filters and the binarisation of the image at one threshold,
+ this function finds the contours that pass the filters and populates the vector with their centres and radii.
+ The filters are the ones applied by cv::SimpleBlobDetector.
+ */
+static int findBlobs(const cv::SimpleBlobDetector::Params &params, const cv::Mat &binary, std::vector<BlobCenter> &centers)
+{
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(binary, contours, cv::RETR_LIST, cv::CHAIN_APPROX_NONE);
+
+    for (auto &contour : contours)
+    {
+        cv::Moments moms = cv::moments(contour);
+        if (moms.m00 == 0.0)
+        {
+            continue;
+        }
+
+        if (params.filterByArea && (moms.m00 < params.minArea || moms.m00 >= params.maxArea))
+        {
+            continue;
+        }
+
+        if (params.filterByCircularity)
+        {
+            double perimeter = cv::arcLength(contour, true);
+            double circularity = 4 * CV_PI * moms.m00 / (perimeter * perimeter);
+            if (circularity < params.minCircularity || circularity >= params.maxCircularity)
+            {
+                continue;
+            }
+        }
+
+        if (params.filterByInertia)
+        {
+            double denominator = std::sqrt(std::pow(2 * moms.mu11, 2) + std::pow(moms.mu20 - moms.mu02, 2));
+            double ratio = 1.0;
+            if (denominator > 0.01)
+            {
+                double cosmin = (moms.mu20 - moms.mu02) / denominator;
+                double sinmin = 2 * moms.mu11 / denominator;
+                double imin = 0.5 * (moms.mu20 + moms.mu02) - 0.5 * (moms.mu20 - moms.mu02) * cosmin - moms.mu11 * sinmin;
+                double imax = 0.5 * (moms.mu20 + moms.mu02) + 0.5 * (moms.mu20 - moms.mu02) * cosmin + moms.mu11 * sinmin;
+                ratio = imin / imax;
+            }
+            if (ratio < params.minInertiaRatio || ratio >= params.maxInertiaRatio)
+            {
+                continue;
+            }
+        }
+
+        if (params.filterByConvexity)
+        {
+            std::vector<cv::Point> hull;
+            cv::convexHull(contour, hull);
+            double hull_area = cv::contourArea(hull);
+            double convexity = hull_area > 0 ? cv::contourArea(contour) / hull_area : 0.0;
+            if (convexity < params.minConvexity || convexity >= params.maxConvexity)
+            {
+                continue;
+            }
+        }
+
+        BlobCenter center;
+        center.location = cv::Point2d(moms.m10 / moms.m00, moms.m01 / moms.m00);
+
+        if (params.filterByColor)
+        {
+            int x = cvRound(center.location.x), y = cvRound(center.location.y);
+            if (x < 0 || y < 0 || x >= binary.cols || y >= binary.rows || binary.at<uchar>(y, x) != params.blobColor)
+            {
+                continue;
+            }
+        }
+
+        // Radius is the median distance from the centre to the contour
+        std::vector<double> distances;
+        for (auto &point : contour)
+        {
+            distances.push_back(cv::norm(center.location - cv::Point2d(point)));
+        }
+        std::sort(distances.begin(), distances.end());
+        center.radius = (distances[(distances.size() - 1) / 2] + distances[distances.size() / 2]) / 2.0;
+
+        centers.push_back(center);
+    }
+
+    return (0);
+}
+
+/*
+ Given a grayscale image, this function finds the blobs at every threshold level in parallel,
+ then merges the levels in order exactly as cv::SimpleBlobDetector does, so the keypoints match the serial detector.
+ */
+void ParallelBlobDetector::detect(cv::InputArray image, std::vector<cv::KeyPoint> &keypoints, cv::InputArray mask)
+{
+    keypoints.clear();
+
+    cv::Mat gray = image.getMat();
+    if (gray.channels() == 3)
+    {
+        cv::cvtColor(gray, gray, cv::COLOR_BGR2GRAY);
+    }
+
+    std::vector<double> thresholds;
+    for (double thresh = params.minThreshold; thresh < params.maxThreshold; thresh += params.thresholdStep)
+    {
+        thresholds.push_back(thresh);
+    }
+
+    std::vector<std::vector<BlobCenter>> levels(thresholds.size());
+    cv::parallel_for_(cv::Range(0, (int)thresholds.size()), [&](const cv::Range &range)
+                      {
+                          cv::Mat binary;
+                          for (int i = range.start; i < range.end; i++)
+                          {
+                              cv::threshold(gray, binary, thresholds[i], 255, cv::THRESH_BINARY);
+                              findBlobs(params, binary, levels[i]);
+                          } });
+
+    // Group blobs that appear at the same place across levels
+    std::vector<std::vector<BlobCenter>> groups;
+    for (auto &level : levels)
+    {
+        std::vector<std::vector<BlobCenter>> added;
+        for (auto &center : level)
+        {
+            bool matched = false;
+            for (auto &group : groups)
+            {
+                BlobCenter &middle = group[group.size() / 2];
+                double distance = cv::norm(middle.location - center.location);
+                matched = distance < params.minDistBetweenBlobs || distance < middle.radius || distance < center.radius;
+                if (matched)
+                {
+                    // Keep the group sorted by radius so its middle entry is the median blob
+                    group.push_back(center);
+                    size_t k = group.size() - 1;
+                    while (k > 0 && center.radius < group[k - 1].radius)
+                    {
+                        group[k] = group[k - 1];
+                        k--;
+                    }
+                    group[k] = center;
+                    break;
+                }
+            }
+            if (!matched)
+            {
+                added.push_back(std::vector<BlobCenter>(1, center));
+            }
+        }
+        groups.insert(groups.end(), added.begin(), added.end());
+    }
+
+    for (auto &group : groups)
+    {
+        if (group.size() < params.minRepeatability)
+        {
+            continue;
+        }
+
+        cv::Point2d sum(0, 0);
+        for (auto &center : group)
+        {
+            sum += center.location;
+        }
+        cv::KeyPoint keypoint(cv::Point2f(sum * (1.0 / group.size())), (float)(group[group.size() / 2].radius * 2.0));
+        keypoints.push_back(keypoint);
+    }
+
+    if (!mask.empty())
+    {
+        cv::KeyPointsFilter::runByPixelsMask(keypoints, mask.getMat());
+    }
+}
+
+/*
+ Given the detector, this function sets the blob filters tuned for the printed 4x11 grid:
+ fewer, coarser threshold levels and an area range that follows the frame size.
+ */
+int initCircleGridDetector(CircleGridDetector &detector, cv::Size frame_size)
+{
+    cv::SimpleBlobDetector::Params &params = detector.blob_params;
+
+    // The circles are solid black on white, so a handful of levels is enough to catch them under uneven lighting
+    params.minThreshold = 40;
+    params.maxThreshold = 200;
+    params.thresholdStep = 20;
+    params.minRepeatability = 2;
+    params.filterByColor = true;
+    params.blobColor = 0;
+    params.filterByArea = true;
+    params.minArea = 12;
+    params.maxArea = 0.02f * frame_size.area();
+    params.filterByCircularity = false;
+    params.filterByInertia = true;
+    params.minInertiaRatio = 0.1f;
+    params.filterByConvexity = true;
+    params.minConvexity = 0.9f;
+
+    detector.blobs = ParallelBlobDetector::create(params);
+    detector.previous.clear();
+    detector.roi = cv::Rect();
+    detector.frame_size = frame_size;
+
+    return (0);
+}
+
+/*
+ Given the previous grid and the blobs of the current frame, this function assigns every previous centre its nearest blob.
+ It succeeds only when every circle moved less than the tolerance, no blob is used twice
+ and the new centres are a plane projective transform of the old ones, as they must be for a flat target.
+ */
+static bool reuseOrdering(CircleGridDetector &detector, std::vector<cv::KeyPoint> &keypoints, std::vector<cv::Point2f> &centers)
+{
+    std::vector<cv::Point2f> &previous = detector.previous;
+    if (previous.empty() || keypoints.size() < previous.size())
+    {
+        return (false);
+    }
+
+    // Circle spacing from the closest pair of the previous grid
+    double spacing = DBL_MAX;
+    for (size_t i = 0; i < previous.size(); i++)
+    {
+        for (size_t j = i + 1; j < previous.size(); j++)
+        {
+            spacing = std::min(spacing, (double)cv::norm(previous[i] - previous[j]));
+        }
+    }
+    double tolerance = detector.reuse_tolerance * spacing;
+
+    centers.clear();
+    std::vector<bool> used(keypoints.size(), false);
+    for (auto &point : previous)
+    {
+        int nearest = -1;
+        double best = tolerance;
+        for (size_t k = 0; k < keypoints.size(); k++)
+        {
+            double distance = cv::norm(keypoints[k].pt - point);
+            if (distance < best)
+            {
+                best = distance;
+                nearest = (int)k;
+            }
+        }
+        if (nearest < 0 || used[nearest])
+        {
+            return (false);
+        }
+        used[nearest] = true;
+        centers.push_back(keypoints[nearest].pt);
+    }
+
+    cv::Mat H = cv::findHomography(previous, centers, 0);
+    if (H.empty())
+    {
+        return (false);
+    }
+    std::vector<cv::Point2f> mapped;
+    cv::perspectiveTransform(previous, mapped, H);
+    for (size_t i = 0; i < mapped.size(); i++)
+    {
+        if (cv::norm(mapped[i] - centers[i]) > 0.1 * spacing)
+        {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+/*
+ Given the detector, a grayscale frame and a vector of points, this function finds the asymmetric circle grid,
+ searching only around the last detection when there is one, and populates the vector with the centres in grid order.
+ When every circle is found close to where it was in the previous frame, the previous ordering is reused
+ and cv::findCirclesGrid is skipped altogether. It returns true when the grid is found.
+ */
+bool detectCircleGrid(CircleGridDetector &detector, cv::Mat &gray, std::vector<cv::Point2f> &centers)
+{
+    // Frames of another size (e.g. downscaled by the frame scheduler) invalidate the search region and the previous grid
+    if (detector.blobs.empty() || detector.frame_size != gray.size())
+    {
+        initCircleGridDetector(detector, gray.size());
+    }
+
+    cv::Rect frame_rect(0, 0, gray.cols, gray.rows);
+    cv::Rect roi = detector.roi.empty() ? frame_rect : (detector.roi & frame_rect);
+    cv::Mat search = gray(roi);
+    cv::Point2f offset((float)roi.x, (float)roi.y);
+
+    bool found = false;
+    if (!detector.previous.empty())
+    {
+        std::vector<cv::KeyPoint> keypoints;
+        detector.blobs->detect(search, keypoints);
+        for (auto &keypoint : keypoints)
+        {
+            keypoint.pt += offset;
+        }
+        found = reuseOrdering(detector, keypoints, centers);
+        detector.reused += found;
+    }
+
+    if (!found)
+    {
+        found = cv::findCirclesGrid(search, detector.pattern_size, centers, cv::CALIB_CB_ASYMMETRIC_GRID + cv::CALIB_CB_CLUSTERING, detector.blobs);
+        if (found)
+        {
+            for (auto &center : centers)
+            {
+                center += offset;
+            }
+        }
+        else if (roi != frame_rect)
+        {
+            // The grid may have left the search region; look at the whole frame before giving up
+            found = cv::findCirclesGrid(gray, detector.pattern_size, centers, cv::CALIB_CB_ASYMMETRIC_GRID + cv::CALIB_CB_CLUSTERING, detector.blobs);
+        }
+        detector.clustered++;
+    }
+
+    if (found)
+    {
+        // Search around the grid next frame, widened to allow for motion
+        cv::Rect box = cv::boundingRect(centers);
+        int dx = (int)(box.width * detector.roi_margin) + 16, dy = (int)(box.height * detector.roi_margin) + 16;
+        detector.roi = cv::Rect(box.x - dx, box.y - dy, box.width + 2 * dx, box.height + 2 * dy) & frame_rect;
+        detector.previous = centers;
+    }
+    else
+    {
+        detector.roi = cv::Rect();
+        detector.previous.clear();
+    }
+
+    return (found);
+}
@@ -0,0 +1,71 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for fast circle-grid detection: a blob detector whose threshold levels run in parallel,
+a search region taken from the last detection, and reuse of the previous grid ordering to skip grid clustering.
+*/
+
+#ifndef circlegrid_hpp
+#define circlegrid_hpp
+
+#include <stdio.h>
+#include <iostream>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/features2d.hpp>
+
+#include "board.h"
+
+/*
+ Blob detector with the same filters and results as cv::SimpleBlobDetector,
+ but with every threshold level binarised and searched for blobs on its own core.
+ */
+class ParallelBlobDetector : public cv::Feature2D
+{
+public:
+    explicit ParallelBlobDetector(const cv::SimpleBlobDetector::Params &params);
+
+    static cv::Ptr<ParallelBlobDetector> create(const cv::SimpleBlobDetector::Params &params = cv::SimpleBlobDetector::Params());
+
+    void detect(cv::InputArray image, std::vector<cv::KeyPoint> &keypoints, cv::InputArray mask = cv::noArray()) override;
+
+    cv::SimpleBlobDetector::Params params;
+};
+
+/*
+ Configuration and tracking state of the circle-grid detector.
+ */
+struct CircleGridDetector
+{
+    cv::Size pattern_size = CircleGrid4x11::size(); // Circles per column and number of columns of the asymmetric grid
+    cv::SimpleBlobDetector::Params blob_params;     // Filters of the blob detector
+    cv::Ptr<ParallelBlobDetector> blobs;            // Blob detector, created on first use
+    float roi_margin = 0.25f;                       // Search region around the last grid, as a fraction of its size
+    double reuse_tolerance = 0.35;                  // Largest blob movement, relative to the circle spacing, for reusing the ordering
+    std::vector<cv::Point2f> previous;              // Centres found in the previous frame, in grid order
+    cv::Rect roi;                                   // Search region for the next frame, empty for the whole frame
+    cv::Size frame_size;                            // Size of the frames the state above refers to
+    int reused = 0;                                 // Frames ordered by matching against the previous grid
+    int clustered = 0;                              // Frames that needed the full grid search
+};
+
+/*
+ Given the detector, this function sets the blob filters tuned for the printed 4x11 grid:
+ fewer, coarser threshold levels and an area range that follows the frame size.
+ */
+int initCircleGridDetector(CircleGridDetector &detector, cv::Size frame_size);
+
+/*
+ Given the detector, a grayscale frame and a vector of points, this function finds the asymmetric circle grid,
+ searching only around the last detection when there is one, and populates the vector with the centres in grid order.
+ When every circle is found close to where it was in the previous frame, the previous ordering is reused
+ and cv::findCirclesGrid is skipped altogether. It returns true when the grid is found.
+ */
+bool detectCircleGrid(CircleGridDetector &detector, cv::Mat &gray, std::vector<cv::Point2f> &centers);
+
+#endif /* circlegrid_hpp */
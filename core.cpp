@@ -0,0 +1,367 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations shared by the calibration and AR frontends. Nothing here keeps static state:
+detector state and scratch buffers live in the CoreContext of each session.
+*/
+
+#include "core.h"
+#include "csv_util.h"
+
+/*
+ Given a vector of segments and the direction of the world Y axis along the board,
+ this function populates it with the 3D axes at the origin of world coordinates: X in red, Y in green and Z in blue.
+ */
+static int axesSegments(std::vector<OverlaySegment> &segments, float y_sign)
+{
+    cv::Vec3f origin(0, 0, 0); // Origin of world coordinates
+
+    segments.clear();
+    segments.push_back({origin, cv::Vec3f(2, 0, 0), cv::Scalar(0, 0, 255), 5, true});          // X-axis arrow in red
+    segments.push_back({origin, cv::Vec3f(0, 2 * y_sign, 0), cv::Scalar(0, 255, 0), 5, true}); // Y-axis arrow in green
+    segments.push_back({origin, cv::Vec3f(0, 0, 2), cv::Scalar(255, 0, 0), 5, true});          // Z-axis arrow in blue
+
+    return (0);
+}
+
+/*
+ Given a vector of segments, this function populates it with the edges of the virtual objects placed on the chessboard:
+ a cylinder at the origin, a pyramid and a cube.
+ */
+static int chessboardObjects(std::vector<OverlaySegment> &segments)
+{
+    segments.clear();
+
+    // CYLINDER
+    float radius = 1.0f;   // Define radius of the cylinder
+    float height = 3.0f;   // Define height of the cylinder
+    int num_segments = 30; // Number of segments to approximate the circle
+
+    std::vector<cv::Vec3f> top, bottom; // Vertices of the top and bottom circles
+    for (int i = 0; i < num_segments; ++i)
+    {
+        float theta = 2.0f * M_PI * i / num_segments; // Calculate angle for each segment
+        float x = radius * cosf(theta);               // Calculate x-coordinate of the vertex
+        float y = radius * sinf(theta);               // Calculate y-coordinate of the vertex
+        top.push_back(cv::Vec3f(x, y, height / 2.0f));
+        bottom.push_back(cv::Vec3f(x, y, -height / 2.0f));
+    }
+
+    cv::Scalar blue(255, 0, 0);
+    for (int i = 0; i < num_segments; ++i)
+    {
+        segments.push_back({top[i], top[(i + 1) % num_segments], blue, 2, false});       // Connect top circle vertices
+        segments.push_back({bottom[i], bottom[(i + 1) % num_segments], blue, 2, false}); // Connect bottom circle vertices
+        if (i % 2 == 0)
+        {
+            segments.push_back({top[i], bottom[i], blue, 2, false}); // Connect top and bottom circle vertices skipping every other vertex
+        }
+    }
+
+    // PYRAMID
+    cv::Vec3f apex(2, -2, 3);                                                                                   // Center
+    cv::Vec3f base[4] = {cv::Vec3f(3, -1, 0), cv::Vec3f(3, -3, 0), cv::Vec3f(1, -3, 0), cv::Vec3f(1, -1, 0)}; // Top right, bottom right, bottom left, top left
+    cv::Scalar yellow(0, 255, 255);
+    for (int i = 0; i < 4; i++)
+    {
+        segments.push_back({apex, base[i], yellow, 5, false});              // Connect the center to each base corner
+        segments.push_back({base[i], base[(i + 1) % 4], yellow, 5, false}); // Connect the base corners
+    }
+
+    // CUBE
+    cv::Vec3f cube[8] = {cv::Vec3f(8, -5, 0), cv::Vec3f(8, -5, 2), cv::Vec3f(6, -5, 0), cv::Vec3f(6, -5, 2), // Base: bottom right, top right, bottom left, top left
+                         cv::Vec3f(8, -3, 0), cv::Vec3f(8, -3, 2), cv::Vec3f(6, -3, 0), cv::Vec3f(6, -3, 2)}; // Top: bottom right, top right, bottom left, top left
+    int edges[12][2] = {{0, 2}, {4, 6}, {0, 4}, {2, 6}, {1, 3}, {5, 7}, {1, 5}, {3, 7}, {0, 1}, {2, 3}, {4, 5}, {6, 7}};
+    for (auto &edge : edges)
+    {
+        segments.push_back({cube[edge[0]], cube[edge[1]], cv::Scalar(255, 255, 0), 5, false}); // Connect the cube's vertices
+    }
+
+    return (0);
+}
+
+/*
+ Given a vector of segments, this function populates it with the edges of the virtual cube placed on the circle grid.
+ */
+static int circleGridObjects(std::vector<OverlaySegment> &segments)
+{
+    // CUBE
+    cv::Vec3f cube[8] = {cv::Vec3f(8, 5, 0), cv::Vec3f(8, 5, 2), cv::Vec3f(6, 5, 0), cv::Vec3f(6, 5, 2), // Base: bottom right, top right, bottom left, top left
+                         cv::Vec3f(8, 3, 0), cv::Vec3f(8, 3, 2), cv::Vec3f(6, 3, 0), cv::Vec3f(6, 3, 2)}; // Top: bottom right, top right, bottom left, top left
+    int edges[9][2] = {{0, 2}, {4, 6}, {0, 4}, {2, 6}, {1, 3}, {5, 7}, {1, 5}, {3, 7}, {0, 1}};
+
+    segments.clear();
+    for (auto &edge : edges)
+    {
+        segments.push_back({cube[edge[0]], cube[edge[1]], cv::Scalar(255, 255, 0), 5, false}); // Connect the cube's vertices
+    }
+
+    return (0);
+}
+
+/*
+ Given a target kind, this function returns the target's world points and overlay geometry.
+ */
+TargetModel makeTargetModel(TargetKind kind)
+{
+    TargetModel target;
+    target.kind = kind;
+    if (kind == TARGET_CHESSBOARD)
+    {
+        Chessboard9x6::objectPoints(target.points);
+        axesSegments(target.axes, -1.0f); // Down the board is negative y
+        chessboardObjects(target.objects);
+    }
+    else
+    {
+        CircleGrid4x11::objectPoints(target.points);
+        axesSegments(target.axes, 1.0f);
+        circleGridObjects(target.objects);
+        target.quad = {cv::Vec3f(-3, 9, 0), cv::Vec3f(13, 9, 0), cv::Vec3f(13, -2, 0), cv::Vec3f(-3, -2, 0)}; // The grid and its margin
+    }
+
+    return (target);
+}
+
+/*
+ Given the context, a target kind and the frame size, this function sets up the target and the initial camera matrix
+ and clears the calibration views. The gate and detector settings are left as they are.
+ */
+int initCoreContext(CoreContext &core, TargetKind kind, cv::Size frame_size)
+{
+    core.target = makeTargetModel(kind);
+    core.camera_matrix = (cv::Mat_<double>(3, 3) << 1, 0, (double)frame_size.width / 2, 0, 1, (double)frame_size.height / 2, 0, 0, 1);
+    core.dist_coeff.release();
+    core.points_list.clear();
+    core.corners_list.clear();
+
+    return (0);
+}
+
+/*
+ Given the context, the image frame, a cv::Mat for the output and a vector of points, this function finds the target,
+ populates the vector with the image coordinates of its corners or centres and, when draw is set, draws them on the output.
+ Chessboard frames go through the focus gate and the pre-filter first, and the corners are refined to sub-pixel accuracy.
+ It returns true when the whole target is found.
+ */
+bool detectTarget(CoreContext &core, const cv::Mat &src, cv::Mat &dst, std::vector<cv::Point2f> &corners, bool draw)
+{
+    dst = src.clone();
+
+    // Convert to grayscale once; the gates, the detector and the refinement all use it
+    cv::cvtColor(src, core.gray, cv::COLOR_BGR2GRAY);
+
+    bool found;
+    if (core.target.kind == TARGET_CHESSBOARD)
+    {
+        // Blurred frames neither yield accurate corners nor make good calibration views, and frames
+        // without board-like corners are where the detector is slowest, so both skip the detector
+        if (!frameSharp(core.focus, core.gray) || !boardLikely(core.prefilter, src))
+        {
+            corners.clear();
+            return (false);
+        }
+
+        found = cv::findChessboardCorners(core.gray, Chessboard9x6::size(), corners);
+        if (found)
+        {
+            refineCorners(core.gray, corners, core.subpix);
+        }
+        updatePrefilter(core.prefilter, found);
+
+        if (draw)
+        {
+            Chessboard9x6::drawCorners(dst, corners, found);
+        }
+    }
+    else
+    {
+        // Detection runs on grayscale with the parallel blob detector, searching around the last grid
+        found = detectCircleGrid(core.circles, core.gray, corners);
+
+        if (draw)
+        {
+            CircleGrid4x11::drawCorners(dst, corners, found);
+        }
+    }
+
+    return (found);
+}
+
+/*
+ Given the context, the image coordinates of a detected target and a vector of points, this function populates the vector
+ with the target's world points and adds the view to the calibration views.
+ */
+int selectCalibrationImg(CoreContext &core, const std::vector<cv::Point2f> &corners, std::vector<cv::Vec3f> &points)
+{
+    points = core.target.points;
+
+    // Store corners and points for calibration
+    core.corners_list.push_back(corners);
+    core.points_list.push_back(points);
+
+    return (0);
+}
+
+/*
+ Given the context, the image size and the solver settings, this function calibrates the context's camera matrix
+ and distortion coefficients from its views and returns the reprojection error.
+ */
+float calibrateCamera(CoreContext &core, cv::Size image_size, BundleParams &solver)
+{
+    std::vector<cv::Mat> points, corners; // Headers over each view, the points are not copied
+    for (size_t i = 0; i < core.points_list.size(); i++)
+    {
+        points.push_back(cv::Mat(core.points_list[i]));
+        corners.push_back(cv::Mat(core.corners_list[i]));
+    }
+
+    return (calibrateViews(points, corners, image_size, core.camera_matrix, core.dist_coeff, solver));
+}
+
+/*
+ Given the world points and image coordinates of a detected target, calibrated camera matrix and distortion coefficients,
+ this function estimates the position of the camera relative to the target and populates the rotation and translation.
+ */
+int calcCameraPosition(const std::vector<cv::Vec3f> &points, const std::vector<cv::Point2f> &corners, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff, cv::Mat &rot, cv::Mat &trans)
+{
+    cv::solvePnP(points, corners, camera_matrix, dist_coeff, rot, trans); // Solve PnP problem to estimate camera position
+
+    return (0);
+}
+
+/*
+ Given a CSV file name, camera matrix, distortion coefficients and the image size they were calibrated at,
+ this function saves the calibration into the file, replacing its contents, to be retrieved later for calculating camera pose.
+ */
+int saveCalibration(const std::string &csv_filename, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff, cv::Size image_size)
+{
+    // Each matrix is flattened row by row into one row of the file
+    std::vector<float> camVector, distVector;
+    camera_matrix.reshape(1, 1).convertTo(camVector, CV_32F);
+    if (!dist_coeff.empty())
+    {
+        dist_coeff.reshape(1, 1).convertTo(distVector, CV_32F);
+    }
+    std::vector<float> sizeVector = {(float)image_size.width, (float)image_size.height}; // Image size the calibration was made at
+
+    // Replace the file, so readCalibration always finds the latest calibration in the first rows
+    return (writeCsvRows(csv_filename, {"camera_matrix", "distortion_coefficient", "image_size"}, {camVector, distVector, sizeVector}));
+}
+
+/*
+ Given the CSV with calibration stats,
+ this function retrieves the calibrated camera matrix, distortion coefficients and the image size they were calibrated at.
+ The image size is left empty for calibrations saved without one. It returns -1, leaving the matrices as they were, when the file holds no calibration.
+ */
+int readCalibration(const std::string &csv_filename, cv::Mat &camera_matrix, cv::Mat &dist_coeff, cv::Size &image_size)
+{
+    std::cout << "Retrieving saved calibration..." << std::endl;
+
+    std::vector<std::string> featureName;
+    std::vector<std::vector<float>> data;
+    if (readCsvRows(csv_filename, featureName, data) != 0 || data.size() < 2 || data[0].size() < 9 || data[1].size() < 5)
+    {
+        printf("%s does not hold a calibration\n", csv_filename.c_str());
+        return (-1); // Keep the current calibration
+    }
+
+    // Camera matrix, row by row
+    camera_matrix.create(3, 3, CV_64F);
+    for (int i = 0; i < 9; i++)
+    {
+        camera_matrix.at<double>(i / 3, i % 3) = (double)data[0][i];
+    }
+
+    dist_coeff = cv::Mat(1, 5, CV_32F);
+    for (int i = 0; i < 5; i++)
+    {
+        dist_coeff.at<float>(0, i) = data[1][i];
+    }
+
+    // Image size the calibration was made at, when the record has one
+    image_size = cv::Size();
+    if (data.size() > 2 && featureName[2] == "image_size" && data[2].size() >= 2)
+    {
+        image_size = cv::Size((int)data[2][0], (int)data[2][1]);
+    }
+
+    return (0);
+}
+
+/*
+ Given a cv::Mat of the image frame, the target, calibrated camera matrix, distortion coefficients, rotation and translation data
+ from the current estimated camera position, this function projects the target's 3D axes onto the frame and draws them.
+ */
+int draw3dAxes(cv::Mat &dst, const TargetModel &target, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff, const cv::Mat &rot, const cv::Mat &trans)
+{
+    return (drawOverlaySegments(dst, target.axes, camera_matrix, dist_coeff, rot, trans));
+}
+
+/*
+ Given a cv::Mat of the image frame, the target, calibrated camera matrix, distortion coefficients, rotation and translation data
+ from the current estimated camera position, this function projects the target's virtual objects onto the frame and draws them.
+ */
+int draw3dObject(cv::Mat &dst, const TargetModel &target, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff, const cv::Mat &rot, const cv::Mat &trans)
+{
+    return (drawOverlaySegments(dst, target.objects, camera_matrix, dist_coeff, rot, trans));
+}
+
+/*
+ Given the context, the frame scheduler, the drift monitor, the overlay compositor, the image frame, a cv::Mat for the output,
+ a vector of points, the pose carried from frame to frame, whether an AR mode is on and whether to draw the detected points,
+ this function runs one frame of main, main_ar and soak. It finds the target, or in AR modes lets the scheduler track or predict it,
+ then solves the pose from the target's world points, hands it to the scheduler and the drift monitor, and composites the overlays.
+ AR frames never become calibration views. The caller sets each layer's visible flag for its mode; the flags are cleared
+ when the target is not found. It returns true when the target is found.
+ */
+bool processArFrame(CoreContext &core, FrameScheduler &scheduler, DriftMonitor &drift, OverlayCompositor &overlays, cv::Mat &frame, cv::Mat &output,
+                    std::vector<cv::Point2f> &corners, cv::Mat &rot, cv::Mat &trans, bool posing, bool draw)
+{
+    // In AR modes the scheduler may track or predict instead of running the full detector to hold the target rate
+    bool found;
+    FrameAction action = FRAME_DETECT;
+    if (scheduler.target_fps > 0 && posing)
+    {
+        TargetDetector detect = [&core](cv::Mat &src, cv::Mat &dst, std::vector<cv::Point2f> &points, bool draw_points)
+        {
+            return detectTarget(core, src, dst, points, draw_points);
+        };
+        action = scheduleFrame(scheduler);
+        found = runScheduledFrame(scheduler, action, frame, corners, detect, core.target.kind == TARGET_CHESSBOARD);
+        output = frame.clone();
+        if (action == FRAME_PREDICT && found)
+        {
+            predictPose(scheduler, rot, trans); // Extrapolate the pose when there is no time to look at the image
+        }
+    }
+    else
+    {
+        resetTracking(scheduler);
+        found = detectTarget(core, frame, output, corners, draw);
+    }
+
+    // The pose comes from the target's world points, so the context's calibration views stay as they are
+    if (posing && found && action != FRAME_PREDICT)
+    {
+        calcCameraPosition(core.target.points, corners, core.camera_matrix, core.dist_coeff, rot, trans);
+        updatePose(scheduler, rot, trans);
+        offerDriftSample(drift, corners, rot, trans); // Sampled for the drift monitor; never waits
+    }
+
+    // Re-render the overlays whose projection changed and blend them onto the output frame
+    if (!found)
+    {
+        for (OverlayLayer &layer : overlays.layers)
+        {
+            layer.visible = false;
+        }
+    }
+    updateOverlays(overlays, output.size(), core.camera_matrix, core.dist_coeff, rot, trans);
+    compositeOverlays(overlays, output);
+
+    return (found);
+}
@@ -0,0 +1,144 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions shared by the calibration and AR frontends: target detection, view selection, calibration, pose estimation,
+calibration files, the 3D overlays and the per-frame AR step. Every function works on the state it is given, so independent sessions
+can run concurrently in one process, each with its own context.
+*/
+
+#ifndef core_hpp
+#define core_hpp
+
+#include <stdio.h>
+#include <iostream>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/calib3d.hpp>
+
+#include "board.h"
+#include "bundle.h"
+#include "circlegrid.h"
+#include "driftmon.h"
+#include "focus.h"
+#include "overlay.h"
+#include "prefilter.h"
+#include "scheduler.h"
+#include "subpix.h"
+
+/*
+ Calibration targets.
+ */
+enum TargetKind
+{
+    TARGET_CHESSBOARD, // The 9x6 chessboard; world y runs up the board, so the rows sit at negative y
+    TARGET_CIRCLES     // The 4x11 asymmetric circle grid; world y runs down the grid
+};
+
+/*
+ World geometry of a target and of the overlays placed on it.
+ */
+struct TargetModel
+{
+    TargetKind kind = TARGET_CHESSBOARD;
+    std::vector<cv::Vec3f> points;       // World coordinates of the corners or centres, in detection order
+    std::vector<OverlaySegment> axes;    // 3D axes at the origin, the Y axis pointing along the board
+    std::vector<OverlaySegment> objects; // Virtual objects standing on the target
+    std::vector<cv::Vec3f> quad;         // Area an artwork replaces, top left, top right, bottom right, bottom left; empty for the chessboard
+};
+
+/*
+ Everything one calibration or AR session owns: the target, the calibration being built,
+ the detector state carried between frames and the scratch buffers reused from frame to frame.
+ */
+struct CoreContext
+{
+    TargetModel target;                                 // Target the session detects
+    cv::Mat camera_matrix;                              // Camera matrix (CV_64F), focal length 1 at the frame centre until calibrated
+    cv::Mat dist_coeff;                                 // Distortion coefficients, empty until calibrated
+    std::vector<std::vector<cv::Vec3f>> points_list;    // World points of every calibration view
+    std::vector<std::vector<cv::Point2f>> corners_list; // Image points of every calibration view
+    FocusGate focus;                                    // Sharpness gate in front of the chessboard detector, e.g. --focus=50
+    BoardPrefilter prefilter;                           // Board-presence test in front of the chessboard detector, e.g. --prefilter
+    SubpixParams subpix;                                // Refinement of the chessboard corners
+    CircleGridDetector circles;                         // Circle-grid detector and its tracking state
+    cv::Mat gray;                                       // Grayscale frame shared by the gates, the detector and the refinement
+};
+
+/*
+ Given a target kind, this function returns the target's world points and overlay geometry.
+ */
+TargetModel makeTargetModel(TargetKind kind);
+
+/*
+ Given the context, a target kind and the frame size, this function sets up the target and the initial camera matrix
+ and clears the calibration views. The gate and detector settings are left as they are.
+ */
+int initCoreContext(CoreContext &core, TargetKind kind, cv::Size frame_size);
+
+/*
+ Given the context, the image frame, a cv::Mat for the output and a vector of points, this function finds the target,
+ populates the vector with the image coordinates of its corners or centres and, when draw is set, draws them on the output.
+ Chessboard frames go through the focus gate and the pre-filter first, and the corners are refined to sub-pixel accuracy.
+ It returns true when the whole target is found.
+ */
+bool detectTarget(CoreContext &core, const cv::Mat &src, cv::Mat &dst, std::vector<cv::Point2f> &corners, bool draw);
+
+/*
+ Given the context, the image coordinates of a detected target and a vector of points, this function populates the vector
+ with the target's world points and adds the view to the calibration views.
+ */
+int selectCalibrationImg(CoreContext &core, const std::vector<cv::Point2f> &corners, std::vector<cv::Vec3f> &points);
+
+/*
+ Given the context, the image size and the solver settings, this function calibrates the context's camera matrix
+ and distortion coefficients from its views and returns the reprojection error.
+ */
+float calibrateCamera(CoreContext &core, cv::Size image_size, BundleParams &solver);
+
+/*
+ Given the world points and image coordinates of a detected target, calibrated camera matrix and distortion coefficients,
+ this function estimates the position of the camera relative to the target and populates the rotation and translation.
+ */
+int calcCameraPosition(const std::vector<cv::Vec3f> &points, const std::vector<cv::Point2f> &corners, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff, cv::Mat &rot, cv::Mat &trans);
+
+/*
+ Given a CSV file name, camera matrix, distortion coefficients and the image size they were calibrated at,
+ this function saves the calibration into the file, replacing its contents, to be retrieved later for calculating camera pose.
+ */
+int saveCalibration(const std::string &csv_filename, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff, cv::Size image_size);
+
+/*
+ Given the CSV with calibration stats,
+ this function retrieves the calibrated camera matrix, distortion coefficients and the image size they were calibrated at.
+ The image size is left empty for calibrations saved without one. It returns -1, leaving the matrices as they were, when the file holds no calibration.
+ */
+int readCalibration(const std::string &csv_filename, cv::Mat &camera_matrix, cv::Mat &dist_coeff, cv::Size &image_size);
+
+/*
+ Given a cv::Mat of the image frame, the target, calibrated camera matrix, distortion coefficients, rotation and translation data
+ from the current estimated camera position, this function projects the target's 3D axes onto the frame and draws them.
+ */
+int draw3dAxes(cv::Mat &dst, const TargetModel &target, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff, const cv::Mat &rot, const cv::Mat &trans);
+
+/*
+ Given a cv::Mat of the image frame, the target, calibrated camera matrix, distortion coefficients, rotation and translation data
+ from the current estimated camera position, this function projects the target's virtual objects onto the frame and draws them.
+ */
+int draw3dObject(cv::Mat &dst, const TargetModel &target, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff, const cv::Mat &rot, const cv::Mat &trans);
+
+/*
+ Given the context, the frame scheduler, the drift monitor, the overlay compositor, the image frame, a cv::Mat for the output,
+ a vector of points, the pose carried from frame to frame, whether an AR mode is on and whether to draw the detected points,
+ this function runs one frame of main, main_ar and soak. It finds the target, or in AR modes lets the scheduler track or predict it,
+ then solves the pose from the target's world points, hands it to the scheduler and the drift monitor, and composites the overlays.
+ AR frames never become calibration views. The caller sets each layer's visible flag for its mode; the flags are cleared
+ when the target is not found. It returns true when the target is found.
+ */
+bool processArFrame(CoreContext &core, FrameScheduler &scheduler, DriftMonitor &drift, OverlayCompositor &overlays, cv::Mat &frame, cv::Mat &output,
+                    std::vector<cv::Point2f> &corners, cv::Mat &rot, cv::Mat &trans, bool posing, bool draw);
+
+#endif /* core_hpp */
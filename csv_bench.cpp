@@ -0,0 +1,109 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+main() CPP function for measuring the throughput of the CSV reader and writer. It writes a feature file of random values,
+reads it back with the streaming reader, with readCsvRows and with a getline and stringstream parser for comparison,
+checks that every value survived the round trip, and prints the rate of each pass.
+
+Usage: csv_bench [rows] [columns] [file]
+*/
+
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <random>
+
+// User-defined headers
+#include "csv_util.h"
+
+/*
+ Given a start time and the number of bytes processed since, this function prints the time and rate of a pass.
+ */
+static int reportPass(const char *pass, std::chrono::steady_clock::time_point start, size_t bytes)
+{
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-22s %8.1f ms %9.1f MB/s\n", pass, 1000.0 * seconds, seconds > 0.0 ? bytes / seconds / 1e6 : 0.0);
+
+    return (0);
+}
+
+// Main function
+int main(int argc, char *argv[])
+{
+    int rows = argc > 1 ? atoi(argv[1]) : 100000;
+    int columns = argc > 2 ? atoi(argv[2]) : 64;
+    std::string filename = argc > 3 ? argv[3] : "csv_bench.csv";
+
+    // Random feature vectors over a wide range of magnitudes
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> mantissa(-1.0f, 1.0f);
+    std::uniform_int_distribution<int> exponent(-6, 6);
+    std::vector<std::string> names(rows);
+    std::vector<std::vector<float>> data(rows, std::vector<float>(columns));
+    for (int i = 0; i < rows; i++)
+    {
+        names[i] = "image-" + std::to_string(i) + ".png";
+        for (float &value : data[i])
+        {
+            value = mantissa(rng) * powf(10.0f, (float)exponent(rng));
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    writeCsvRows(filename, names, data);
+    std::ifstream sized(filename, std::ios::binary | std::ios::ate);
+    size_t bytes = (size_t)sized.tellg();
+    printf("%d rows of %d values, %.1f MB\n", rows, columns, bytes / 1e6);
+    reportPass("writeCsvRows", start, bytes);
+
+    // Streaming pass: touch every value without keeping the rows
+    start = std::chrono::steady_clock::now();
+    CsvReader reader;
+    double checksum = 0.0;
+    int mismatches = 0;
+    if (openCsv(reader, filename) != 0)
+    {
+        return (-1);
+    }
+    for (int i = 0; nextCsvRow(reader); i++)
+    {
+        for (size_t k = 0; k < reader.values.size(); k++)
+        {
+            checksum += reader.values[k];
+            mismatches += i >= rows || k >= data[i].size() || reader.values[k] != data[i][k];
+        }
+    }
+    closeCsv(reader);
+    reportPass("CsvReader", start, bytes);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<std::string> read_names;
+    std::vector<std::vector<float>> read_data;
+    readCsvRows(filename, read_names, read_data);
+    reportPass("readCsvRows", start, bytes);
+
+    // Line-by-line parsing with a string per field, for comparison
+    start = std::chrono::steady_clock::now();
+    std::ifstream in(filename);
+    std::string line, field;
+    double baseline = 0.0;
+    while (std::getline(in, line))
+    {
+        std::stringstream fields(line);
+        std::getline(fields, field, ',');
+        while (std::getline(fields, field, ','))
+        {
+            baseline += std::stof(field);
+        }
+    }
+    reportPass("getline + stof", start, bytes);
+
+    printf("checksum %.6g (baseline %.6g), %d values changed in the round trip, %zu rows read back\n", checksum, baseline, mismatches,
+           read_data.size());
+
+    return (mismatches == 0 && (int)read_data.size() == rows ? 0 : -1);
+}
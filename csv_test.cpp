@@ -0,0 +1,199 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+main() CPP function for checking the CSV reader and writer against the files they meet in practice:
+blank lines, CRLF line endings and trailing commas, malformed fields, empty and missing files,
+and an exact round trip of float values through writeCsvRows and CsvReader.
+It prints every failed check and returns -1 when there was one.
+
+Usage: csv_test [directory]
+*/
+
+#include <iostream>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string.h>
+#include <unistd.h>
+
+// User-defined headers
+#include "csv_util.h"
+
+static int failures = 0;
+
+/*
+ Given the outcome of a check and its description, this function counts and prints the check when it failed.
+ */
+static int check(bool passed, const char *what)
+{
+    if (!passed)
+    {
+        failures++;
+        printf("FAIL: %s\n", what);
+    }
+
+    return (0);
+}
+
+/*
+ Given a file name and its contents, this function writes the file as-is.
+ */
+static int writeFile(const std::string &filename, const std::string &contents)
+{
+    FILE *fp = fopen(filename.c_str(), "wb");
+    if (!fp)
+    {
+        return (-1);
+    }
+    fwrite(contents.data(), 1, contents.size(), fp);
+    fclose(fp);
+
+    return (0);
+}
+
+/*
+ Given two vectors of floats, this function returns whether they hold the same values bit for bit.
+ */
+static bool sameBits(const std::vector<float> &a, const std::vector<float> &b)
+{
+    return (a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0));
+}
+
+/*
+ Given a scratch directory, this function checks that blank lines are skipped, CRLF endings are stripped
+ and a trailing comma adds no value, with and without a newline at the end of the file.
+ */
+static int testLayout(const std::string &dir)
+{
+    std::string filename = dir + "/csv_test_layout.csv";
+    writeFile(filename, "a,1,2\r\n\r\n\nb,3,\r\n\r\nc,4.5");
+
+    CsvReader reader;
+    check(openCsv(reader, filename) == 0, "layout: file opens");
+    check(nextCsvRow(reader) && reader.name == "a" && sameBits(reader.values, {1.0f, 2.0f}), "layout: CRLF row a is [1, 2]");
+    check(nextCsvRow(reader) && reader.name == "b" && sameBits(reader.values, {3.0f}), "layout: trailing comma after b adds no value");
+    check(nextCsvRow(reader) && reader.name == "c" && sameBits(reader.values, {4.5f}), "layout: last row without newline is read");
+    check(!nextCsvRow(reader), "layout: nothing after the last row");
+    check(reader.rows == 3 && reader.bad_fields == 0, "layout: 3 rows, no bad fields");
+    closeCsv(reader);
+    unlink(filename.c_str());
+
+    return (0);
+}
+
+/*
+ Given a scratch directory, this function checks that fields which are empty, not numbers or numbers followed by other characters
+ are each read as 0 and counted, while surrounding blanks are allowed.
+ */
+static int testMalformed(const std::string &dir)
+{
+    std::string filename = dir + "/csv_test_malformed.csv";
+    writeFile(filename, "m,1.5abc,x, 2 ,,7,0x10,1e3\nn,-0.25\t,+1\n");
+
+    CsvReader reader;
+    check(openCsv(reader, filename) == 0, "malformed: file opens");
+    check(nextCsvRow(reader), "malformed: row m is read");
+    // 1.5abc, x, the empty field, 0x10 (hexadecimal is not accepted) and +1 (no leading plus) are bad
+    check(sameBits(reader.values, {0.0f, 0.0f, 2.0f, 0.0f, 7.0f, 0.0f, 1000.0f}), "malformed: row m is [0, 0, 2, 0, 7, 0, 1000]");
+    check(reader.bad_fields == 4, "malformed: 4 bad fields in row m");
+    check(nextCsvRow(reader) && sameBits(reader.values, {-0.25f, 0.0f}), "malformed: row n is [-0.25, 0]");
+    check(reader.bad_fields == 5, "malformed: 5 bad fields in total");
+    closeCsv(reader);
+    unlink(filename.c_str());
+
+    return (0);
+}
+
+/*
+ Given a scratch directory, this function checks that an empty file has no rows and a missing file is reported.
+ */
+static int testEmptyAndMissing(const std::string &dir)
+{
+    std::string filename = dir + "/csv_test_empty.csv";
+    writeFile(filename, "");
+
+    CsvReader reader;
+    check(openCsv(reader, filename) == 0, "empty: file opens");
+    check(!nextCsvRow(reader) && reader.rows == 0, "empty: no rows");
+    closeCsv(reader);
+
+    std::vector<std::string> names = {"stale"};
+    std::vector<std::vector<float>> data = {{1.0f}};
+    check(readCsvRows(filename, names, data) == 0 && names.empty() && data.empty(), "empty: readCsvRows clears its outputs");
+    unlink(filename.c_str());
+
+    std::string missing = dir + "/csv_test_missing.csv";
+    unlink(missing.c_str());
+    check(openCsv(reader, missing) == -1, "missing: openCsv returns -1");
+    check(!nextCsvRow(reader), "missing: a failed reader has no rows");
+    check(readCsvRows(missing, names, data) == -1, "missing: readCsvRows returns -1");
+
+    return (0);
+}
+
+/*
+ Given a scratch directory, this function writes rows of awkward and random floats with writeCsvRows and appendCsvRow
+ and checks that CsvReader reads every value back bit for bit.
+ */
+static int testRoundTrip(const std::string &dir)
+{
+    std::string filename = dir + "/csv_test_roundtrip.csv";
+    std::vector<std::string> names = {"limits", "random"};
+    std::vector<std::vector<float>> data = {{0.0f, -0.0f, 1.0f, -1.0f, 0.1f, 1.0f / 3.0f, FLT_MIN, FLT_MAX, -FLT_MAX, std::numeric_limits<float>::denorm_min(),
+                                             std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), 16777217.0f, 1e-30f},
+                                            {}};
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<uint32_t> bits;
+    while (data[1].size() < 10000)
+    {
+        uint32_t word = bits(rng);
+        float value;
+        memcpy(&value, &word, sizeof(value));
+        if (std::isfinite(value))
+        {
+            data[1].push_back(value);
+        }
+    }
+    writeCsvRows(filename, names, data);
+    appendCsvRow(filename, "appended", {2.5f, -7e-8f});
+    names.push_back("appended");
+    data.push_back({2.5f, -7e-8f});
+
+    CsvReader reader;
+    check(openCsv(reader, filename) == 0, "round trip: file opens");
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        std::string what = "round trip: row " + names[i] + " reads back exactly";
+        check(nextCsvRow(reader) && reader.name == names[i] && sameBits(reader.values, data[i]), what.c_str());
+    }
+    check(!nextCsvRow(reader) && reader.bad_fields == 0, "round trip: no extra rows or bad fields");
+    closeCsv(reader);
+
+    // reset replaces the file
+    appendCsvRow(filename, "only", {1.0f}, true);
+    std::vector<std::string> read_names;
+    std::vector<std::vector<float>> read_data;
+    check(readCsvRows(filename, read_names, read_data) == 0 && read_names.size() == 1 && read_names[0] == "only", "round trip: reset replaces the file");
+    unlink(filename.c_str());
+
+    return (0);
+}
+
+// Main function
+int main(int argc, char *argv[])
+{
+    std::string dir = argc > 1 ? argv[1] : ".";
+
+    testLayout(dir);
+    testMalformed(dir);
+    testEmptyAndMissing(dir);
+    testRoundTrip(dir);
+
+    printf("csv_test: %s\n", failures == 0 ? "all checks passed" : (std::to_string(failures) + " checks failed").c_str());
+
+    return (failures == 0 ? 0 : -1);
+}
@@ -0,0 +1,268 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for reading and writing the calibration and feature-vector CSV files.
+*/
+
+#include <charconv>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "csv_util.h"
+
+/*
+ Given a line buffer, a row name and its values, this function formats the row, ending in a newline, into the buffer.
+ */
+static int formatCsvRow(std::string &line, std::string_view name, const std::vector<float> &values)
+{
+    line.assign(name);
+    char field[32];
+    for (float value : values)
+    {
+        line += ',';
+        std::to_chars_result result = std::to_chars(field, field + sizeof(field), value);
+        line.append(field, result.ptr);
+    }
+    line += '\n';
+
+    return (0);
+}
+
+/*
+ Given the reader and a file name, this function maps the file for reading.
+ It returns -1 when the file cannot be opened.
+ */
+int openCsv(CsvReader &reader, const std::string &filename)
+{
+    reader = CsvReader();
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+        printf("Unable to open %s\n", filename.c_str());
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return (-1);
+    }
+
+    // An empty file has no rows, and cannot be mapped
+    if (info.st_size > 0)
+    {
+        void *base = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED)
+        {
+            printf("Unable to map %s\n", filename.c_str());
+            close(fd);
+            return (-1);
+        }
+        madvise(base, info.st_size, MADV_SEQUENTIAL);
+        reader.data = (const char *)base;
+        reader.size = info.st_size;
+    }
+    close(fd); // The mapping stays valid without the descriptor
+
+    return (0);
+}
+
+/*
+ Given an open reader, this function parses the next non-empty row into its name and values and returns true,
+ or returns false at the end of the file.
+ */
+bool nextCsvRow(CsvReader &reader)
+{
+    while (reader.offset < reader.size)
+    {
+        const char *line = reader.data + reader.offset;
+        const char *end = (const char *)memchr(line, '\n', reader.size - reader.offset);
+        end = end ? end : reader.data + reader.size;
+        reader.offset = end - reader.data + 1;
+
+        const char *stop = end > line && end[-1] == '\r' ? end - 1 : end;
+        if (stop == line)
+        {
+            continue; // Blank line
+        }
+
+        const char *comma = (const char *)memchr(line, ',', stop - line);
+        comma = comma ? comma : stop;
+        reader.name = std::string_view(line, comma - line);
+
+        // Every field after the name is a float; anything else, including a number followed by other characters, is read as 0 and counted
+        reader.values.clear();
+        const char *field = comma;
+        while (field < stop)
+        {
+            field++; // Skip the comma
+            while (field < stop && (*field == ' ' || *field == '\t'))
+            {
+                field++;
+            }
+            if (field == stop)
+            {
+                break; // Trailing comma
+            }
+            const char *next = (const char *)memchr(field, ',', stop - field);
+            next = next ? next : stop;
+            const char *last = next;
+            while (last > field && (last[-1] == ' ' || last[-1] == '\t'))
+            {
+                last--;
+            }
+
+            float value = 0.0f;
+            std::from_chars_result result = std::from_chars(field, last, value);
+            if (result.ec != std::errc() || result.ptr != last)
+            {
+                reader.bad_fields++;
+                value = 0.0f;
+            }
+            reader.values.push_back(value);
+            field = next;
+        }
+
+        reader.rows++;
+        return (true);
+    }
+
+    return (false);
+}
+
+/*
+ Given the reader, this function unmaps the file.
+ */
+int closeCsv(CsvReader &reader)
+{
+    if (reader.data)
+    {
+        munmap((void *)reader.data, reader.size);
+    }
+    reader = CsvReader();
+
+    return (0);
+}
+
+/*
+ Given a file name, this function reads every row of the file into names and data, replacing their contents.
+ It returns -1 when the file cannot be opened.
+ */
+int readCsvRows(const std::string &filename, std::vector<std::string> &names, std::vector<std::vector<float>> &data)
+{
+    names.clear();
+    data.clear();
+
+    CsvReader reader;
+    if (openCsv(reader, filename) != 0)
+    {
+        return (-1);
+    }
+    while (nextCsvRow(reader))
+    {
+        names.emplace_back(reader.name);
+        data.push_back(reader.values);
+    }
+    if (reader.bad_fields > 0)
+    {
+        printf("%s: %d fields were not numbers and were read as 0\n", filename.c_str(), reader.bad_fields);
+    }
+    closeCsv(reader);
+
+    return (0);
+}
+
+/*
+ Given a file name, a row name and its values, this function appends the row to the file,
+ or truncates the file first when reset is set. Values are written in their shortest exact form.
+ */
+int appendCsvRow(const std::string &filename, std::string_view name, const std::vector<float> &values, bool reset)
+{
+    FILE *fp = fopen(filename.c_str(), reset ? "w" : "a");
+    if (!fp)
+    {
+        printf("Unable to open %s for writing\n", filename.c_str());
+        return (-1);
+    }
+
+    std::string line;
+    formatCsvRow(line, name, values);
+    fwrite(line.data(), 1, line.size(), fp);
+    fclose(fp);
+
+    return (0);
+}
+
+/*
+ Given a file name and rows of names and values, this function writes the rows to the file, replacing its contents.
+ */
+int writeCsvRows(const std::string &filename, const std::vector<std::string> &names, const std::vector<std::vector<float>> &data)
+{
+    FILE *fp = fopen(filename.c_str(), "w");
+    if (!fp)
+    {
+        printf("Unable to open %s for writing\n", filename.c_str());
+        return (-1);
+    }
+
+    // One line buffer is reused for every row
+    std::string line;
+    for (size_t i = 0; i < names.size() && i < data.size(); i++)
+    {
+        formatCsvRow(line, names[i], data[i]);
+        fwrite(line.data(), 1, line.size(), fp);
+    }
+    fclose(fp);
+
+    return (0);
+}
+
+/*
+ Given a CSV file name, a row name, its values and whether to truncate the file first,
+ this function appends the row. Kept for code written against the course's csv_util interface.
+ */
+int append_image_data_csv(char *filename, char *image_filename, std::vector<float> &image_data, int reset_file)
+{
+    return (appendCsvRow(filename, image_filename, image_data, reset_file != 0));
+}
+
+/*
+ Given a CSV file name, this function reads every row into filenames and data, printing them when echo_file is set.
+ Each name is allocated with new[] and owned by the caller. Kept for code written against the course's csv_util interface;
+ new code should use readCsvRows or CsvReader.
+ */
+int read_image_data_csv(char *filename, std::vector<char *> &filenames, std::vector<std::vector<float>> &data, int echo_file)
+{
+    CsvReader reader;
+    if (openCsv(reader, filename) != 0)
+    {
+        return (-1);
+    }
+    while (nextCsvRow(reader))
+    {
+        char *name = new char[reader.name.size() + 1];
+        memcpy(name, reader.name.data(), reader.name.size());
+        name[reader.name.size()] = '\0';
+        filenames.push_back(name);
+        data.push_back(reader.values);
+
+        if (echo_file)
+        {
+            printf("%s", name);
+            for (float value : reader.values)
+            {
+                printf(",%.4f", value);
+            }
+            printf("\n");
+        }
+    }
+    closeCsv(reader);
+
+    return (0);
+}
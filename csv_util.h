@@ -0,0 +1,82 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for reading and writing the CSV files that hold calibrations and feature vectors: one row per record,
+a name followed by its float values. Files are mapped and parsed in place, one row at a time, without allocating per field.
+*/
+
+#ifndef csv_util_hpp
+#define csv_util_hpp
+
+#include <stdio.h>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ A CSV file open for reading. The file is mapped read-only and nextCsvRow parses it in place:
+ name points into the mapping and values is reused from row to row, so both are only valid until the next row.
+ */
+struct CsvReader
+{
+    const char *data = nullptr;   // Mapped file
+    size_t size = 0;              // Size of the file in bytes
+    size_t offset = 0;            // Start of the next row
+    std::string_view name;        // Name of the current row
+    std::vector<float> values;    // Values of the current row
+    int rows = 0;                 // Rows read so far
+    int bad_fields = 0;           // Fields that were empty or not entirely a number, read as 0
+};
+
+/*
+ Given the reader and a file name, this function maps the file for reading.
+ It returns -1 when the file cannot be opened.
+ */
+int openCsv(CsvReader &reader, const std::string &filename);
+
+/*
+ Given an open reader, this function parses the next non-empty row into its name and values and returns true,
+ or returns false at the end of the file.
+ */
+bool nextCsvRow(CsvReader &reader);
+
+/*
+ Given the reader, this function unmaps the file.
+ */
+int closeCsv(CsvReader &reader);
+
+/*
+ Given a file name, this function reads every row of the file into names and data, replacing their contents.
+ It returns -1 when the file cannot be opened.
+ */
+int readCsvRows(const std::string &filename, std::vector<std::string> &names, std::vector<std::vector<float>> &data);
+
+/*
+ Given a file name, a row name and its values, this function appends the row to the file,
+ or truncates the file first when reset is set. Values are written in their shortest exact form.
+ */
+int appendCsvRow(const std::string &filename, std::string_view name, const std::vector<float> &values, bool reset = false);
+
+/*
+ Given a file name and rows of names and values, this function writes the rows to the file, replacing its contents.
+ */
+int writeCsvRows(const std::string &filename, const std::vector<std::string> &names, const std::vector<std::vector<float>> &data);
+
+/*
+ Given a CSV file name, a row name, its values and whether to truncate the file first,
+ this function appends the row. Kept for code written against the course's csv_util interface.
+ */
+int append_image_data_csv(char *filename, char *image_filename, std::vector<float> &image_data, int reset_file = 0);
+
+/*
+ Given a CSV file name, this function reads every row into filenames and data, printing them when echo_file is set.
+ Each name is allocated with new[] and owned by the caller. Kept for code written against the course's csv_util interface;
+ new code should use readCsvRows or CsvReader.
+ */
+int read_image_data_csv(char *filename, std::vector<char *> &filenames, std::vector<std::vector<float>> &data, int echo_file = 0);
+
+#endif /* csv_util_hpp */
@@ -0,0 +1,398 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for watching a loaded calibration for drift while the AR modes run.
+A low-priority thread measures the reprojection residual of sampled detections against the loaded intrinsics,
+keeps a small reservoir of diverse views and periodically recalibrates from it, starting from the loaded intrinsics,
+to flag drift or propose an update. Its busy time is held to a fraction of one core.
+*/
+
+#include <chrono>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+#include "driftmon.h"
+
+/*
+ Given the world points, image points, camera matrix, distortion coefficients and pose of a view,
+ this function returns the sum of the squared reprojection errors of its points.
+ */
+static double squaredResidual(const std::vector<cv::Vec3f> &points, const std::vector<cv::Point2f> &corners, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff,
+                              const cv::Mat &rot, const cv::Mat &trans)
+{
+    std::vector<cv::Point2f> projected;
+    cv::projectPoints(points, rot, trans, camera_matrix, dist_coeff, projected);
+
+    double sum = 0.0;
+    for (size_t i = 0; i < projected.size() && i < corners.size(); i++)
+    {
+        cv::Point2f d = projected[i] - corners[i];
+        sum += d.x * d.x + d.y * d.y;
+    }
+
+    return (sum);
+}
+
+/*
+ Given the image points, the pose of a view and the frame size, this function returns the view's cell:
+ the tilt of the target about both image axes and the position of its centre, each split in three.
+ */
+static int viewBucket(const std::vector<cv::Point2f> &corners, const cv::Mat &rot, cv::Size image_size)
+{
+    cv::Mat R;
+    cv::Rodrigues(rot, R);
+    cv::Point2f centre(0.0f, 0.0f);
+    for (const cv::Point2f &corner : corners)
+    {
+        centre += corner;
+    }
+    centre *= 1.0f / std::max<size_t>(1, corners.size());
+
+    // The target's normal in camera coordinates is the third column of the rotation
+    auto third = [](double value, double low, double high) { return value < low ? 0 : value > high ? 2 : 1; };
+    int tilt_x = third(R.at<double>(0, 2), -0.25, 0.25);
+    int tilt_y = third(R.at<double>(1, 2), -0.25, 0.25);
+    int cell_x = third(centre.x, image_size.width / 3.0, 2.0 * image_size.width / 3.0);
+    int cell_y = third(centre.y, image_size.height / 3.0, 2.0 * image_size.height / 3.0);
+
+    return (((tilt_x * 3 + tilt_y) * 3 + cell_x) * 3 + cell_y);
+}
+
+/*
+ Given the monitor and a measured view, this function keeps the view in the reservoir: it replaces the view of the same cell,
+ fills an empty slot, or replaces the oldest view when the reservoir is full.
+ */
+static int keepView(DriftMonitor &monitor, const std::vector<cv::Point2f> &corners, int bucket)
+{
+    size_t slot = monitor.reservoir.size();
+    for (size_t i = 0; i < monitor.reservoir.size(); i++)
+    {
+        if (monitor.reservoir[i].bucket == bucket)
+        {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == monitor.reservoir.size() && (int)monitor.reservoir.size() >= monitor.capacity)
+    {
+        slot = 0;
+        for (size_t i = 1; i < monitor.reservoir.size(); i++)
+        {
+            slot = monitor.reservoir[i].arrival < monitor.reservoir[slot].arrival ? i : slot;
+        }
+    }
+    if (slot == monitor.reservoir.size())
+    {
+        monitor.reservoir.emplace_back();
+    }
+
+    DriftView &view = monitor.reservoir[slot];
+    view.corners = corners;
+    view.bucket = bucket;
+    view.arrival = monitor.arrivals++;
+
+    return ((int)slot);
+}
+
+/*
+ Given the monitor and a snapshot of the reference, this function recalibrates from the reservoir starting at the reference,
+ compares the result with the reference on the same views and, when the intrinsics moved and fit the views better,
+ stores them as the proposal. It returns true when an update was proposed.
+ */
+static bool recalibrateReservoir(DriftMonitor &monitor, const std::vector<cv::Vec3f> &points, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff,
+                                 cv::Size image_size, int generation)
+{
+    std::vector<std::vector<cv::Vec3f>> points_list(monitor.reservoir.size(), points);
+    std::vector<std::vector<cv::Point2f>> corners_list;
+    for (const DriftView &view : monitor.reservoir)
+    {
+        corners_list.push_back(view.corners);
+    }
+
+    // Error of the reference on the reservoir, each view posed with the reference intrinsics
+    double sum = 0.0;
+    size_t count = 0;
+    cv::Mat rot, trans;
+    for (const std::vector<cv::Point2f> &corners : corners_list)
+    {
+        cv::solvePnP(points, corners, camera_matrix, dist_coeff, rot, trans);
+        sum += squaredResidual(points, corners, camera_matrix, dist_coeff, rot, trans);
+        count += corners.size();
+    }
+    double reference_error = sqrt(sum / std::max<size_t>(1, count));
+
+    // The reference is a good starting point, so a few iterations are enough
+    cv::Mat K = camera_matrix.clone();
+    cv::Mat D = dist_coeff.clone();
+    std::vector<cv::Mat> rots, transs;
+    double error = cv::calibrateCamera(points_list, corners_list, image_size, K, D, rots, transs, cv::CALIB_USE_INTRINSIC_GUESS,
+                                       cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 10, 1e-6));
+    monitor.recalibrations++;
+
+    double change = 0.0;
+    change = std::max(change, fabs(K.at<double>(0, 0) / camera_matrix.at<double>(0, 0) - 1.0));
+    change = std::max(change, fabs(K.at<double>(1, 1) / camera_matrix.at<double>(1, 1) - 1.0));
+    change = std::max(change, fabs(K.at<double>(0, 2) - camera_matrix.at<double>(0, 2)) / image_size.width);
+    change = std::max(change, fabs(K.at<double>(1, 2) - camera_matrix.at<double>(1, 2)) / image_size.height);
+    printf("Drift monitor: %zu views, reference error %.3f px, recalibrated %.3f px, intrinsics moved %.2f%%\n", monitor.reservoir.size(),
+           reference_error, error, 100.0 * change);
+    if (change < monitor.intrinsics_tol || error >= 0.9 * reference_error)
+    {
+        return (false);
+    }
+
+    std::lock_guard<std::mutex> guard(monitor.lock);
+    if (generation != monitor.generation)
+    {
+        return (false); // The reference changed while recalibrating
+    }
+    monitor.proposal_matrix = K;
+    monitor.proposal_dist = D;
+    monitor.proposal_error = error;
+    monitor.has_proposal = true;
+    printf("Drift monitor: proposing fx %.1f fy %.1f cx %.1f cy %.1f (%.3f px), press 'k' to adopt\n", K.at<double>(0, 0), K.at<double>(1, 1),
+           K.at<double>(0, 2), K.at<double>(1, 2), error);
+
+    return (true);
+}
+
+/*
+ Given the monitor, this function runs the monitor thread: it measures each sample against the reference, keeps the reservoir,
+ recalibrates every interval, and after each piece of work sleeps long enough to stay within the budget.
+ */
+static void monitorLoop(DriftMonitor *monitor)
+{
+    // Leave the frame loop's core to the frame loop; nice applies per thread on Linux, elsewhere the budget alone holds it back
+#ifdef __linux__
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19);
+#endif
+
+    auto started = std::chrono::steady_clock::now();
+    auto last_recalibration = started;
+    int seen_generation = -1;
+    std::vector<cv::Vec3f> points; // Copy of the target's world points, taken when the reference changes
+    std::unique_lock<std::mutex> guard(monitor->lock);
+    while (monitor->running)
+    {
+        monitor->ready.wait_for(guard, std::chrono::seconds(1), [monitor] { return !monitor->running || !monitor->inbox.empty(); });
+        if (!monitor->running)
+        {
+            break;
+        }
+
+        // A new reference invalidates everything measured against the old one
+        if (seen_generation != monitor->generation)
+        {
+            seen_generation = monitor->generation;
+            points = monitor->points;
+            monitor->reservoir.clear();
+            monitor->baseline = monitor->residual = 0.0;
+            monitor->measured = 0;
+            last_recalibration = std::chrono::steady_clock::now();
+        }
+
+        // Snapshot the reference; the matrices are replaced, never written in place, so the headers stay valid unlocked
+        cv::Mat camera_matrix = monitor->camera_matrix;
+        cv::Mat dist_coeff = monitor->dist_coeff;
+        cv::Size image_size = monitor->image_size;
+        int generation = monitor->generation;
+        bool has_sample = !monitor->inbox.empty();
+        DriftSample sample;
+        if (has_sample)
+        {
+            sample = std::move(monitor->inbox.front());
+            monitor->inbox.pop_front();
+        }
+        guard.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        if (has_sample && sample.corners.size() == points.size())
+        {
+            monitor->samples++;
+            double rms = sqrt(squaredResidual(points, sample.corners, camera_matrix, dist_coeff, sample.rot, sample.trans) / points.size());
+            monitor->measured++;
+            if (monitor->measured <= monitor->baseline_samples)
+            {
+                monitor->baseline += (rms - monitor->baseline) / monitor->measured;
+                monitor->residual = monitor->baseline;
+            }
+            else
+            {
+                monitor->residual += 0.05 * (rms - monitor->residual);
+            }
+            keepView(*monitor, sample.corners, viewBucket(sample.corners, sample.rot, image_size));
+        }
+
+        bool due = std::chrono::duration<double>(start - last_recalibration).count() >= monitor->interval;
+        if (due && (int)monitor->reservoir.size() >= monitor->min_views)
+        {
+            recalibrateReservoir(*monitor, points, camera_matrix, dist_coeff, image_size, generation);
+            last_recalibration = std::chrono::steady_clock::now();
+        }
+        double busy = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        monitor->busy_ms += busy;
+
+        guard.lock();
+        if (generation == monitor->generation && monitor->measured > monitor->baseline_samples)
+        {
+            bool drifted = monitor->residual > std::max((double)monitor->min_residual, monitor->residual_ratio * monitor->baseline);
+            if (drifted && !monitor->drifted)
+            {
+                printf("Drift monitor: residual %.3f px against a baseline of %.3f px, the calibration no longer fits the lens\n", monitor->residual,
+                       monitor->baseline);
+            }
+            monitor->drifted = drifted;
+        }
+
+        // Idle for long enough that the busy time stays within the budget; samples arriving meanwhile wait or are dropped
+        double idle = busy * (1.0 / monitor->budget - 1.0);
+        monitor->ready.wait_for(guard, std::chrono::duration<double, std::milli>(idle), [monitor] { return !monitor->running; });
+    }
+
+    monitor->wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+}
+
+/*
+ Given the monitor and a command line argument, this function applies the argument when it is a drift option
+ (--drift[=SECONDS] or --drift-budget=FRACTION) and returns true, or returns false for any other argument.
+ */
+bool parseDriftArg(DriftMonitor &monitor, const std::string &arg)
+{
+    if (arg == "--drift" || arg.rfind("--drift=", 0) == 0)
+    {
+        monitor.enabled = true;
+        monitor.interval = arg.size() > 8 ? std::max(1.0, atof(arg.c_str() + 8)) : monitor.interval;
+        return (true);
+    }
+    if (arg.rfind("--drift-budget=", 0) == 0)
+    {
+        monitor.budget = std::min(1.0, std::max(0.01, atof(arg.c_str() + 15)));
+        return (true);
+    }
+
+    return (false);
+}
+
+/*
+ Given the monitor, the target's world points, the loaded camera matrix and distortion coefficients and the frame size,
+ this function makes the intrinsics the monitor's reference, clearing what was measured against the previous one,
+ and starts the monitor thread if it is not running. It does nothing unless the monitor is enabled.
+ */
+int startDriftMonitor(DriftMonitor &monitor, const std::vector<cv::Vec3f> &points, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff, cv::Size image_size)
+{
+    if (!monitor.enabled)
+    {
+        return (0);
+    }
+
+    std::unique_lock<std::mutex> guard(monitor.lock);
+    monitor.points = points;
+    monitor.image_size = image_size;
+    // Fresh matrices, never written in place: the monitor thread may still be reading the previous ones unlocked
+    cv::Mat reference;
+    camera_matrix.convertTo(reference, CV_64F);
+    monitor.camera_matrix = reference;
+    monitor.dist_coeff = dist_coeff.clone();
+    monitor.generation++;
+    monitor.inbox.clear();
+    monitor.drifted = false;
+    monitor.has_proposal = false;
+    monitor.offered = 0;
+    if (monitor.running)
+    {
+        return (0);
+    }
+
+    monitor.running = true;
+    guard.unlock();
+    monitor.worker = std::thread(monitorLoop, &monitor);
+
+    return (0);
+}
+
+/*
+ Given the monitor, the detected image points and the pose solved for them, this function hands every N-th detection
+ to the monitor thread. It never blocks: the sample is dropped when the monitor is busy or its inbox is full.
+ */
+int offerDriftSample(DriftMonitor &monitor, const std::vector<cv::Point2f> &corners, const cv::Mat &rot, const cv::Mat &trans)
+{
+    // running is only written by the frame loop, so it can be read here without the lock
+    if (!monitor.running || rot.empty() || trans.empty() || monitor.offered++ % monitor.every != 0)
+    {
+        return (-1);
+    }
+
+    std::unique_lock<std::mutex> guard(monitor.lock, std::try_to_lock);
+    if (!guard.owns_lock() || monitor.inbox.size() >= 4)
+    {
+        monitor.dropped++;
+        return (-1);
+    }
+
+    monitor.inbox.emplace_back();
+    DriftSample &sample = monitor.inbox.back();
+    sample.corners = corners;
+    rot.convertTo(sample.rot, CV_64F);
+    trans.convertTo(sample.trans, CV_64F);
+    guard.unlock();
+    monitor.ready.notify_one();
+
+    return (0);
+}
+
+/*
+ Given the monitor, a camera matrix and distortion coefficients, this function copies the proposed intrinsics into them,
+ makes them the new reference and returns true, or returns false, leaving the matrices alone, when nothing is proposed.
+ */
+bool takeDriftProposal(DriftMonitor &monitor, cv::Mat &camera_matrix, cv::Mat &dist_coeff)
+{
+    std::lock_guard<std::mutex> guard(monitor.lock);
+    if (!monitor.has_proposal)
+    {
+        return (false);
+    }
+
+    camera_matrix = monitor.proposal_matrix.clone();
+    dist_coeff = monitor.proposal_dist.clone();
+    monitor.camera_matrix = monitor.proposal_matrix;
+    monitor.dist_coeff = monitor.proposal_dist;
+    monitor.generation++;
+    monitor.inbox.clear();
+    monitor.drifted = false;
+    monitor.has_proposal = false;
+
+    return (true);
+}
+
+/*
+ Given the monitor, this function stops the monitor thread and prints what it measured.
+ */
+int stopDriftMonitor(DriftMonitor &monitor)
+{
+    if (!monitor.running)
+    {
+        return (0);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(monitor.lock);
+        monitor.running = false;
+    }
+    monitor.ready.notify_one();
+    if (monitor.worker.joinable())
+    {
+        monitor.worker.join();
+    }
+
+    printf("Drift monitor: %d samples, %d dropped, %d recalibrations, residual %.3f px (baseline %.3f px), %.1f%% of a core\n", monitor.samples,
+           monitor.dropped, monitor.recalibrations, monitor.residual, monitor.baseline,
+           monitor.wall_ms > 0.0 ? 100.0 * monitor.busy_ms / monitor.wall_ms : 0.0);
+
+    return (0);
+}
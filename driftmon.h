@@ -0,0 +1,124 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for watching a loaded calibration for drift while the AR modes run.
+A low-priority thread measures the reprojection residual of sampled detections against the loaded intrinsics,
+keeps a small reservoir of diverse views and periodically recalibrates from it, starting from the loaded intrinsics,
+to flag drift or propose an update. Its busy time is held to a fraction of one core.
+*/
+
+#ifndef driftmon_hpp
+#define driftmon_hpp
+
+#include <stdio.h>
+#include <iostream>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/calib3d.hpp>
+
+/*
+ One detection handed to the monitor: the image points of the target and the pose the frame loop solved for them.
+ */
+struct DriftSample
+{
+    std::vector<cv::Point2f> corners;
+    cv::Mat rot, trans;
+};
+
+/*
+ A view kept in the reservoir, with the pose and coverage cell it stands for.
+ */
+struct DriftView
+{
+    std::vector<cv::Point2f> corners;
+    int bucket = 0;   // Tilt and image-position cell of the view; one view is kept per cell
+    long arrival = 0; // Order the view arrived in, to replace the oldest when the reservoir is full
+};
+
+/*
+ State of the drift monitor. The frame loop only copies a sample into the inbox, and never waits for the lock;
+ the measuring, the reservoir and the recalibrations belong to the monitor thread.
+ */
+struct DriftMonitor
+{
+    bool enabled = false;               // Set by --drift
+    double interval = 30.0;             // Seconds between recalibrations of the reservoir, e.g. --drift=60
+    double budget = 0.1;                // Share of one core the monitor may keep busy, e.g. --drift-budget=0.05
+    int every = 15;                     // Every N-th posed frame is offered to the monitor
+    int capacity = 40;                  // Views kept in the reservoir
+    int min_views = 10;                 // Views needed before a recalibration is run
+    int baseline_samples = 30;          // Samples whose mean residual becomes the baseline of the loaded calibration
+    float residual_ratio = 1.5f;        // Residual over the baseline at which the calibration is flagged
+    float min_residual = 0.3f;          // Residual in pixels below which nothing is flagged, whatever the baseline
+    double intrinsics_tol = 0.01;       // Relative change of fx, fy, cx or cy at which an update is proposed
+
+    std::vector<cv::Vec3f> points;      // World points of the target, in detection order
+    cv::Size image_size;                // Frame size the reference intrinsics are for
+    cv::Mat camera_matrix, dist_coeff;  // Reference intrinsics, copied from the frame loop
+
+    std::thread worker;                 // Measures, keeps the reservoir and recalibrates
+    std::mutex lock;                    // Guards the inbox, the reference, the proposal and the flags below
+    std::condition_variable ready;      // Signalled when a sample arrives or the monitor stops
+    std::deque<DriftSample> inbox;      // Samples waiting for the monitor thread, at most 4
+    bool running = false;               // Cleared to stop the monitor thread
+    int generation = 0;                 // Bumped whenever the reference changes, so the thread starts over
+    int offered = 0;                    // Posed frames seen by offerDriftSample
+
+    std::vector<DriftView> reservoir;   // Diverse recent views, owned by the monitor thread
+    long arrivals = 0;                  // Views that entered the reservoir
+    double baseline = 0.0;              // Mean residual of the first samples after the reference was set
+    double residual = 0.0;              // Running average of the residual in pixels
+    int measured = 0;                   // Samples measured against the current reference
+
+    bool drifted = false;               // Residual rose above residual_ratio times the baseline
+    bool has_proposal = false;          // proposal holds intrinsics that differ from the reference
+    cv::Mat proposal_matrix, proposal_dist;
+    double proposal_error = 0.0;        // Reprojection error of the proposal on the reservoir
+
+    int samples = 0;                    // Statistics printed when the monitor stops
+    int dropped = 0;                    // Samples the frame loop dropped instead of waiting
+    int recalibrations = 0;
+    double busy_ms = 0.0;               // Time the monitor thread spent working
+    double wall_ms = 0.0;               // Time the monitor thread ran for
+};
+
+/*
+ Given the monitor and a command line argument, this function applies the argument when it is a drift option
+ (--drift[=SECONDS] or --drift-budget=FRACTION) and returns true, or returns false for any other argument.
+ */
+bool parseDriftArg(DriftMonitor &monitor, const std::string &arg);
+
+/*
+ Given the monitor, the target's world points, the loaded camera matrix and distortion coefficients and the frame size,
+ this function makes the intrinsics the monitor's reference, clearing what was measured against the previous one,
+ and starts the monitor thread if it is not running. It does nothing unless the monitor is enabled.
+ */
+int startDriftMonitor(DriftMonitor &monitor, const std::vector<cv::Vec3f> &points, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff, cv::Size image_size);
+
+/*
+ Given the monitor, the detected image points and the pose solved for them, this function hands every N-th detection
+ to the monitor thread. It never blocks: the sample is dropped when the monitor is busy or its inbox is full.
+ */
+int offerDriftSample(DriftMonitor &monitor, const std::vector<cv::Point2f> &corners, const cv::Mat &rot, const cv::Mat &trans);
+
+/*
+ Given the monitor, a camera matrix and distortion coefficients, this function copies the proposed intrinsics into them,
+ makes them the new reference and returns true, or returns false, leaving the matrices alone, when nothing is proposed.
+ */
+bool takeDriftProposal(DriftMonitor &monitor, cv::Mat &camera_matrix, cv::Mat &dist_coeff);
+
+/*
+ Given the monitor, this function stops the monitor thread and prints what it measured.
+ */
+int stopDriftMonitor(DriftMonitor &monitor);
+
+#endif /* driftmon_hpp */
@@ -0,0 +1,69 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for a focus and motion-blur gate that keeps blurred frames away from the corner detector and the calibration views.
+*/
+
+#include <chrono>
+
+#include "focus.h"
+
+/*
+ Given a grayscale frame and a sampling step, this function returns the variance of the 4-neighbour Laplacian
+ over every step-th pixel. Defocus and motion blur both remove the high frequencies it responds to.
+ */
+double focusMeasure(const cv::Mat &gray, int step)
+{
+    CV_Assert(gray.type() == CV_8UC1);
+    step = std::max(1, step);
+
+    // Integer sums are exact; a 960x540 frame stays far below the range of int64
+    int64_t sum = 0, sum_sq = 0, count = 0;
+    for (int y = 1; y < gray.rows - 1; y += step)
+    {
+        const uchar *up = gray.ptr<uchar>(y - 1);
+        const uchar *row = gray.ptr<uchar>(y);
+        const uchar *down = gray.ptr<uchar>(y + 1);
+        for (int x = 1; x < gray.cols - 1; x += step)
+        {
+            int lap = 4 * row[x] - row[x - 1] - row[x + 1] - up[x] - down[x];
+            sum += lap;
+            sum_sq += lap * lap;
+        }
+        count += (gray.cols - 2 + step - 1) / step;
+    }
+
+    if (count == 0)
+    {
+        return (0.0);
+    }
+    double mean = (double)sum / count;
+
+    return ((double)sum_sq / count - mean * mean);
+}
+
+/*
+ Given the gate and the grayscale frame, this function measures the frame and returns whether it is sharp enough for detection.
+ It always returns true when the gate is disabled.
+ */
+bool frameSharp(FocusGate &gate, const cv::Mat &gray)
+{
+    if (!gate.enabled)
+    {
+        gate.sharp = true;
+        return (true);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    gate.score = focusMeasure(gray, gate.step);
+    gate.ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    gate.sharp = gate.score >= gate.threshold;
+    gate.frames++;
+    gate.blurred += !gate.sharp;
+
+    return (gate.sharp);
+}
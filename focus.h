@@ -0,0 +1,46 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for a focus and motion-blur gate that keeps blurred frames away from the corner detector and the calibration views.
+*/
+
+#ifndef focus_hpp
+#define focus_hpp
+
+#include <stdio.h>
+#include <iostream>
+
+#include <opencv2/core.hpp>
+
+/*
+ Settings and statistics of the focus gate.
+ */
+struct FocusGate
+{
+    bool enabled = false;    // Frames are only gated when enabled
+    double threshold = 50.0; // Smallest Laplacian variance of a usable frame, e.g. --focus=80
+    int step = 2;            // Only every step-th row and column is sampled
+    double score = 0.0;      // Focus measure of the last frame
+    bool sharp = true;       // Whether the last frame passed the gate
+    int frames = 0;          // Frames measured
+    int blurred = 0;         // Frames that failed the gate and skipped detection
+    int refused = 0;         // Calibration captures refused because the frame was blurred
+    double ms = 0.0;         // Total time spent measuring
+};
+
+/*
+ Given a grayscale frame and a sampling step, this function returns the variance of the 4-neighbour Laplacian
+ over every step-th pixel. Defocus and motion blur both remove the high frequencies it responds to.
+ */
+double focusMeasure(const cv::Mat &gray, int step);
+
+/*
+ Given the gate and the grayscale frame, this function measures the frame and returns whether it is sharp enough for detection.
+ It always returns true when the gate is disabled.
+ */
+bool frameSharp(FocusGate &gate, const cv::Mat &gray);
+
+#endif /* focus_hpp */
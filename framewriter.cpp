@@ -0,0 +1,278 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for saving snapshots and recording the composited output stream from a background writer thread,
+so image encoding and file I/O never run inside the frame loop.
+*/
+
+#include <chrono>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "framewriter.h"
+
+/*
+ Given the writer and a command line argument, this function applies the argument when it is one of the writer's options
+ (--snapshot-format=, --snapshot-quality=, --video-out=, --video-codec=, --video-quality=, --video-fps=) and returns true,
+ or returns false for any other argument.
+ */
+bool parseFrameWriterArg(FrameWriter &writer, std::string arg)
+{
+    if (arg.rfind("--snapshot-format=", 0) == 0)
+    {
+        writer.snapshot_format = arg.substr(18) == "png" ? "png" : "jpg";
+    }
+    else if (arg.rfind("--snapshot-quality=", 0) == 0)
+    {
+        writer.snapshot_quality = std::max(0, std::min(100, atoi(arg.c_str() + 19)));
+    }
+    else if (arg.rfind("--video-out=", 0) == 0)
+    {
+        writer.video_file = arg.substr(12);
+    }
+    else if (arg.rfind("--video-codec=", 0) == 0)
+    {
+        writer.video_codec = (arg.substr(14) + "    ").substr(0, 4); // FourCCs are padded with spaces
+    }
+    else if (arg.rfind("--video-quality=", 0) == 0)
+    {
+        writer.video_quality = std::max(0, std::min(100, atoi(arg.c_str() + 16)));
+    }
+    else if (arg.rfind("--video-fps=", 0) == 0)
+    {
+        writer.video_fps = std::max(1.0, atof(arg.c_str() + 12));
+    }
+    else
+    {
+        return (false);
+    }
+
+    return (true);
+}
+
+/*
+ Given the writer and a snapshot job, this function encodes the image with the configured format and quality.
+ */
+static int writeSnapshot(FrameWriter &writer, WriteJob &job)
+{
+    std::vector<int> params;
+    if (writer.snapshot_format == "png")
+    {
+        params = {cv::IMWRITE_PNG_COMPRESSION, std::min(9, (100 - writer.snapshot_quality) / 10)};
+    }
+    else
+    {
+        params = {cv::IMWRITE_JPEG_QUALITY, writer.snapshot_quality};
+    }
+
+    if (!cv::imwrite(job.filename, job.image, params))
+    {
+        printf("Unable to write %s\n", job.filename.c_str());
+        return (-1);
+    }
+
+    return (0);
+}
+
+/*
+ Given the writer and a video frame job, this function appends the frame to the video, opening the video on the first frame.
+ The video keeps the size of its first frame, so later frames of another size are resized to it.
+ */
+static int writeVideoFrame(FrameWriter &writer, WriteJob &job, bool &failed)
+{
+    if (failed)
+    {
+        return (-1);
+    }
+
+    if (!writer.video.isOpened())
+    {
+        const char *c = writer.video_codec.c_str();
+        int fourcc = cv::VideoWriter::fourcc(c[0], c[1], c[2], c[3]);
+        if (!writer.video.open(writer.video_file, fourcc, writer.video_fps, job.image.size(), job.image.channels() == 3))
+        {
+            printf("Unable to open %s with codec %s, the output stream is not recorded\n", writer.video_file.c_str(), writer.video_codec.c_str());
+            failed = true;
+            return (-1);
+        }
+        writer.video_size = job.image.size();
+        if (writer.video_quality >= 0)
+        {
+            writer.video.set(cv::VIDEOWRITER_PROP_QUALITY, writer.video_quality);
+        }
+    }
+
+    if (job.image.size() != writer.video_size)
+    {
+        cv::Mat resized;
+        cv::resize(job.image, resized, writer.video_size);
+        writer.video.write(resized);
+    }
+    else
+    {
+        writer.video.write(job.image);
+    }
+
+    return (0);
+}
+
+/*
+ Given the writer, this function runs on the writer thread: it takes jobs off the queue until the writer is stopped
+ and the queue is empty, encodes them outside the lock and hands the buffers back to the pool.
+ */
+static void writerLoop(FrameWriter *writer)
+{
+    bool failed = false;
+    while (true)
+    {
+        WriteJob job;
+        {
+            std::unique_lock<std::mutex> guard(writer->lock);
+            writer->ready.wait(guard, [writer]
+                               { return !writer->queue.empty() || !writer->running; });
+            if (writer->queue.empty())
+            {
+                break; // Stopped and drained
+            }
+            job = std::move(writer->queue.front());
+            writer->queue.pop_front();
+            writer->video_queued -= job.filename.empty();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        int status = job.filename.empty() ? writeVideoFrame(*writer, job, failed) : writeSnapshot(*writer, job);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> guard(writer->lock);
+        writer->encode_ms += ms;
+        if (status == 0)
+        {
+            writer->snapshots += !job.filename.empty();
+            writer->frames += job.filename.empty();
+        }
+        if ((int)writer->pool.size() < writer->capacity)
+        {
+            writer->pool.push_back(job.image);
+        }
+    }
+}
+
+/*
+ Given the writer, this function starts the writer thread. It returns 0 on success.
+ */
+int startFrameWriter(FrameWriter &writer)
+{
+    writer.running = true;
+    writer.worker = std::thread(writerLoop, &writer);
+
+    return (0);
+}
+
+/*
+ Given the writer, a job without its image and the image, this function copies the image into a pooled buffer
+ and appends the job to the queue. The copy happens outside the lock so the writer is never held up by it.
+ */
+static int enqueue(FrameWriter &writer, WriteJob &job, cv::Mat &image)
+{
+    {
+        std::lock_guard<std::mutex> guard(writer.lock);
+        if (!writer.pool.empty())
+        {
+            job.image = writer.pool.back();
+            writer.pool.pop_back();
+        }
+    }
+    image.copyTo(job.image);
+
+    {
+        std::lock_guard<std::mutex> guard(writer.lock);
+        writer.video_queued += job.filename.empty();
+        writer.queue.push_back(std::move(job));
+        writer.high_water = std::max(writer.high_water, (int)writer.queue.size());
+    }
+    writer.ready.notify_one();
+
+    return (0);
+}
+
+/*
+ Given the writer, a file name without its extension and an image, this function copies the image and queues it
+ to be saved with the configured format and quality. It returns the full file name the snapshot will be written to.
+ */
+std::string queueSnapshot(FrameWriter &writer, std::string basename, cv::Mat &image)
+{
+    WriteJob job;
+    job.filename = basename + "." + writer.snapshot_format;
+
+    // Without a writer thread, fall back to saving in place
+    if (!writer.running)
+    {
+        job.image = image;
+        writeSnapshot(writer, job);
+        return (job.filename);
+    }
+
+    std::string filename = job.filename;
+    enqueue(writer, job, image);
+
+    return (filename);
+}
+
+/*
+ Given the writer and the composited output frame, this function copies the frame into the video queue when --video-out was given.
+ It never blocks; it returns -1 when recording is off or the frame was dropped because the writer is behind.
+ */
+int queueVideoFrame(FrameWriter &writer, cv::Mat &frame)
+{
+    if (writer.video_file.empty() || !writer.running || frame.empty())
+    {
+        return (-1);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(writer.lock);
+        if (writer.video_queued >= writer.capacity)
+        {
+            writer.dropped++;
+            return (-1);
+        }
+    }
+
+    WriteJob job;
+    enqueue(writer, job, frame);
+
+    return (0);
+}
+
+/*
+ Given the writer, this function writes out everything still queued, stops the writer thread, closes the video
+ and prints the backpressure statistics.
+ */
+int stopFrameWriter(FrameWriter &writer)
+{
+    if (!writer.running)
+    {
+        return (0);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(writer.lock);
+        writer.running = false;
+    }
+    writer.ready.notify_one();
+    writer.worker.join();
+    writer.video.release();
+
+    int jobs = writer.snapshots + writer.frames;
+    if (jobs > 0 || writer.dropped > 0)
+    {
+        printf("Frame writer: %d snapshots, %d video frames, %d video frames dropped, queue high water %d, %.2f ms per write\n",
+               writer.snapshots, writer.frames, writer.dropped, writer.high_water, jobs > 0 ? writer.encode_ms / jobs : 0.0);
+    }
+
+    return (0);
+}
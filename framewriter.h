@@ -0,0 +1,95 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for saving snapshots and recording the composited output stream from a background writer thread,
+so image encoding and file I/O never run inside the frame loop.
+*/
+
+#ifndef framewriter_hpp
+#define framewriter_hpp
+
+#include <stdio.h>
+#include <iostream>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+/*
+ One image waiting for the writer thread. An empty file name marks a frame of the video stream.
+ */
+struct WriteJob
+{
+    std::string filename; // Snapshot file, empty for a video frame
+    cv::Mat image;        // Pixels, owned by the job until the writer hands the buffer back
+};
+
+/*
+ Bounded queue between the frame loop and the writer thread, the snapshot and video settings, and backpressure statistics.
+ Snapshots are always queued; video frames are dropped and counted when the queue is full rather than blocking the frame loop.
+ */
+struct FrameWriter
+{
+    std::string snapshot_format = "jpg"; // Extension of snapshots, jpg or png, e.g. --snapshot-format=png
+    int snapshot_quality = 95;           // JPEG quality, or 100 - 10 * PNG compression level, e.g. --snapshot-quality=90
+    std::string video_file;              // Destination of the output stream, e.g. --video-out=session.avi
+    std::string video_codec = "MJPG";    // FourCC of the video codec, e.g. --video-codec=mp4v
+    int video_quality = -1;              // Encoder quality 0-100 where the backend supports it, e.g. --video-quality=80
+    double video_fps = 30.0;             // Frame rate written to the video header, e.g. --video-fps=15
+    int capacity = 8;                    // Video frames the queue holds before new ones are dropped
+
+    std::deque<WriteJob> queue;          // Images waiting to be encoded
+    std::vector<cv::Mat> pool;           // Buffers handed back by the writer, reused to avoid an allocation per frame
+    std::mutex lock;                     // Guards queue, pool and the counters below
+    std::condition_variable ready;       // Signalled when a job is queued or the writer is stopped
+    std::thread worker;                  // Encodes and writes the queued images
+    bool running = false;                // Cleared to stop the writer once the queue is drained
+    cv::VideoWriter video;               // Opened by the writer on the first video frame
+    cv::Size video_size;                 // Frame size the video was opened with
+
+    int video_queued = 0;                // Video frames in the queue
+    int snapshots = 0;                   // Snapshots written
+    int frames = 0;                      // Video frames written
+    int dropped = 0;                     // Video frames dropped because the queue was full
+    int high_water = 0;                  // Largest queue length seen
+    double encode_ms = 0.0;              // Time the writer spent encoding and writing
+};
+
+/*
+ Given the writer and a command line argument, this function applies the argument when it is one of the writer's options
+ (--snapshot-format=, --snapshot-quality=, --video-out=, --video-codec=, --video-quality=, --video-fps=) and returns true,
+ or returns false for any other argument.
+ */
+bool parseFrameWriterArg(FrameWriter &writer, std::string arg);
+
+/*
+ Given the writer, this function starts the writer thread. It returns 0 on success.
+ */
+int startFrameWriter(FrameWriter &writer);
+
+/*
+ Given the writer, a file name without its extension and an image, this function copies the image and queues it
+ to be saved with the configured format and quality. It returns the full file name the snapshot will be written to.
+ */
+std::string queueSnapshot(FrameWriter &writer, std::string basename, cv::Mat &image);
+
+/*
+ Given the writer and the composited output frame, this function copies the frame into the video queue when --video-out was given.
+ It never blocks; it returns -1 when recording is off or the frame was dropped because the writer is behind.
+ */
+int queueVideoFrame(FrameWriter &writer, cv::Mat &frame);
+
+/*
+ Given the writer, this function writes out everything still queued, stops the writer thread, closes the video
+ and prints the backpressure statistics.
+ */
+int stopFrameWriter(FrameWriter &writer);
+
+#endif /* framewriter_hpp */
@@ -14,218 +14,147 @@ main() CPP function for looking at an input video stream, detecting feature poin
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
-#include "virtual.h"
-#include "csv_util.h"
-
-// Task 1- Detect and Extract Target Corners
+#include "core.h"
+#include "autocapture.h"
+#include "calibquality.h"
+#include "resolution.h"
+#include "scheduler.h"
+#include "poselog.h"
+#include "shmring.h"
+#include "recorder.h"
+#include "viewstore.h"
+#include "framewriter.h"
+#include "preview.h"
+#include "driftmon.h"
 
 /*
- Description: Detects corners in the 9x6 checkerboard grid of an image frame and draws them.
- Parameters:
-     src: Input image frame
-     dst: Output image frame with corners drawn
-     corners: Vector to store the pixel coordinates of detected corners
-     drawCorners: Flag indicating whether to draw corners on the output image
- Returns:
-     bool: True if corners are found, false otherwise
- Given a cv::Mat of the image frame, cv::Mat for the output and vector of points
+ main function
  */
-
-// Function to extract corners from an input image and optionally draw them on the output image.
-bool CornersExtract(cv::Mat &src, cv::Mat &dst, std::vector<cv::Point2f> &corners, bool drawCorners)
-{
-    // Make a copy of the source image.
-    dst = src.clone();
-
-    // Attempt to find chessboard corners in the source image.
-    bool found = cv::findChessboardCorners(src, cv::Size(9, 6), corners);
-
-    // Convert the source image to grayscale.
-    cv::Mat gray;
-    cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
-
-    // Refine corner locations if chessboard corners are found.
-    if (found == true)
-    {
-        cv::cornerSubPix(gray, corners, cv::Size(5, 5), cv::Size(-1, -1), cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 30, 0.1));
-    }
-
-    // Draw chessboard corners on the output image if requested.
-    if (drawCorners)
-    {
-        cv::drawChessboardCorners(dst, cv::Size(6, 9), corners, found);
-    }
-
-    // Return whether chessboard corners are found in the image.
-    return found;
-}
-
-// Task 2- Select Calibration Images
-/*
- Function: selectCalibrationImg
- Description: Populates vectors with the pixel coordinates of detected corners and their corresponding world coordinates.
- Parameters:
-     corners: Vector containing pixel coordinates of detected corners
-     corners_list: Vector to store multiple sets of corner coordinates
-     points: Vector to store world coordinates of the checkerboard target
-     points_list: Vector to store multiple sets of world coordinates
- Returns:
-     int: 0 indicating success
-*/
-
-// Function to select calibration images, compute grid points and corner locations, and store them.
-int selectCalibrationImg(std::vector<cv::Point2f> &corners, std::vector<std::vector<cv::Point2f>> &corners_list,
-                         std::vector<cv::Vec3f> &points, std::vector<std::vector<cv::Vec3f>> &points_list)
+int main(int argc, char *argv[])
 {
-    // Number of columns in the chessboard grid.
-    int cols = 9;
+    cv::VideoCapture *capdev; // Pointer to a VideoCapture object
 
-    // Loop through detected corners and compute corresponding grid points.
-    for (int k = 0; k < corners.size(); k++)
+    // Read the requested capture resolution and scheduling from the command line, e.g. --size=1280x720
+    cv::Size capture_size(960, 540);
+    double target_fps = 0.0; // Display rate held by the frame scheduler in AR modes, e.g. --target-fps=30
+    std::string pose_log;    // Destination of the pose stream in AR modes, e.g. --pose-log=poses.csv
+    ShmPublisher shm;        // Shared-memory ring for local consumers, e.g. --shm=/calib_ar --shm-frames
+    std::string record_file; // Session file the capture is recorded to, e.g. --record=session.rec [--record-png]
+    std::string replay_file; // Session file replayed instead of the camera, e.g. --replay=session.rec [--replay-fast]
+    std::string views_file;  // Store the calibration views are kept in across runs, e.g. --views=calib.views [--camera-id=N]
+    int camera_id = 0;       // Camera the stored views are tagged with
+    BundleParams solver;     // Calibration solver, e.g. --solver=sparse --loss=huber:1.5 --fix=k3
+    FrameWriter writer;      // Saves snapshots and the output stream off the frame loop, e.g. --video-out=ar.avi --video-codec=mp4v
+    PreviewServer preview;   // MJPEG stream on localhost in place of the window, e.g. --preview=8080 --preview-width=640
+    DriftMonitor drift;      // Watches the loaded calibration for drift in AR modes, e.g. --drift=60 --drift-budget=0.05
+    CoreContext core;        // Target, calibration views and detector state of this session, e.g. --focus --prefilter
+    FrameEncoding record_encoding = ENCODE_RAW;
+    bool replay_realtime = true;
+    for (int i = 1; i < argc; i++)
     {
-        // Calculate the column index of the current corner.
-        float i = (float)(k % cols);
-        // Calculate the row index of the current corner.
-        float j = (float)(-1 * k / cols);
-        // Create a 3D point corresponding to the grid location of the corner.
-        cv::Vec3f point(i, j, 0);
-        // Store the 3D point in the list of points.
-        points.push_back(point);
+        std::string arg = argv[i];
+        if (arg.rfind("--size=", 0) == 0)
+        {
+            sscanf(arg.c_str(), "--size=%dx%d", &capture_size.width, &capture_size.height);
+        }
+        else if (arg.rfind("--target-fps=", 0) == 0)
+        {
+            target_fps = atof(arg.c_str() + 13);
+        }
+        else if (arg.rfind("--pose-log=", 0) == 0)
+        {
+            pose_log = arg.substr(11);
+        }
+        else if (arg == "--shm" || arg.rfind("--shm=", 0) == 0)
+        {
+            shm.name = arg.size() > 6 ? arg.substr(6) : "/calib_ar";
+        }
+        else if (arg == "--shm-frames")
+        {
+            shm.with_frames = true;
+            shm.name = shm.name.empty() ? "/calib_ar" : shm.name;
+        }
+        else if (arg.rfind("--record=", 0) == 0)
+        {
+            record_file = arg.substr(9);
+        }
+        else if (arg == "--record-png")
+        {
+            record_encoding = ENCODE_PNG;
+        }
+        else if (arg.rfind("--replay=", 0) == 0)
+        {
+            replay_file = arg.substr(9);
+        }
+        else if (arg == "--replay-fast")
+        {
+            replay_realtime = false;
+        }
+        else if (arg.rfind("--views=", 0) == 0)
+        {
+            views_file = arg.substr(8);
+        }
+        else if (arg.rfind("--camera-id=", 0) == 0)
+        {
+            camera_id = atoi(arg.c_str() + 12);
+        }
+        else if (arg == "--prefilter" || arg.rfind("--prefilter=", 0) == 0)
+        {
+            core.prefilter.enabled = true;
+            core.prefilter.min_saddles = arg.size() > 12 ? atoi(arg.c_str() + 12) : core.prefilter.min_saddles;
+        }
+        else if (arg == "--focus" || arg.rfind("--focus=", 0) == 0)
+        {
+            core.focus.enabled = true;
+            core.focus.threshold = arg.size() > 8 ? atof(arg.c_str() + 8) : core.focus.threshold;
+        }
+        else
+        {
+            parseFrameWriterArg(writer, arg) || parseBundleArg(solver, arg) || parsePreviewArg(preview, arg) || parseDriftArg(drift, arg); // Snapshot, video, solver, preview and drift options
+        }
     }
 
-    // Store the detected corner locations and computed grid points.
-    corners_list.push_back(corners);
-    points_list.push_back(points);
-
-    // Return 0 to indicate successful execution.
-    return 0;
-}
-
-// Task 3- Calibrate the Camera
-
-/*
- Function: calibrateCamera
- Description: Performs camera calibration and calculates the camera matrix and distortion coefficients.
- Parameters:
-     points_list: Vector containing sets of world coordinates
-     corners_list: Vector containing sets of pixel coordinates of detected corners
-     camera_matrix: Output parameter to store the calibrated camera matrix
-     dist_coeff: Output parameter to store the distortion coefficients
- Returns:
-     float: Reprojection error
-*/
-
-// Function to calibrate the camera using the provided grid points and detected corner locations.
-float calibrateCamera(std::vector<std::vector<cv::Vec3f>> &points_list, std::vector<std::vector<cv::Point2f>> &corners_list,
-                      cv::Mat &camera_matrix, cv::Mat &dist_coeff)
-{
-    // Vectors to store rotation and translation vectors for each calibration image.
-    std::vector<cv::Mat> rot, trans;
-
-    // Perform camera calibration and compute reprojection error.
-    float error = cv::calibrateCamera(points_list,                                                                            // List of 3D points for each calibration image.
-                                      corners_list,                                                                           // List of 2D corner points for each calibration image.
-                                      cv::Size(1280, 720),                                                                    // Size of the calibration images.
-                                      camera_matrix,                                                                          // Output camera matrix.
-                                      dist_coeff,                                                                             // Output distortion coefficients.
-                                      rot,                                                                                    // Output rotation vectors.
-                                      trans,                                                                                  // Output translation vectors.
-                                      cv::CALIB_FIX_ASPECT_RATIO,                                                             // Fix the aspect ratio during calibration.
-                                      cv::TermCriteria(cv::TermCriteria::MAX_ITER + cv::TermCriteria::EPS, 30, DBL_EPSILON)); // Termination criteria for the iterative optimization algorithm.
-
-    // Return the computed reprojection error.
-    return error;
-}
-
-/*
- Function: saveCalibration
- Description: Saves the camera calibration data to a CSV file.
- Parameters:
-     camera_matrix: Camera matrix containing intrinsic parameters
-     dist_coeff: Distortion coefficients
- Returns:
-     int: 0 indicating success
-*/
-// Function to save camera calibration data to a CSV file.
-int saveCalibration(cv::Mat &camera_matrix, cv::Mat &dist_coeff)
-{
-    // Define the filename for the CSV file.
-    std::string fileName = "checker_data.csv";
-    // Convert the filename to a C-style string.
-    char *fileName_char = new char[fileName.length() + 1];
-    strcpy(fileName_char, fileName.c_str());
-
-    // Define the label for the camera matrix data in the CSV file.
-    std::string columnName = "camera_matrix";
-    // Convert the label to a C-style string.
-    char *labelName_char = new char[columnName.length() + 1];
-    strcpy(labelName_char, columnName.c_str());
-
-    // Vector to store camera matrix data.
-    std::vector<float> camVector;
-    // Iterate over each element in the camera matrix.
-    for (int i = 0; i < camera_matrix.rows; i++)
+    // Replay a recorded session instead of the camera when requested
+    SessionReplay replay;
+    bool replaying = !replay_file.empty();
+    cv::Size refS;
+    if (replaying)
     {
-        for (int j = 0; j < camera_matrix.cols; j++)
+        if (openReplay(replay, replay_file, replay_realtime) != 0)
         {
-            // Convert each double value to float and push it to the vector.
-            float f_val = (float)camera_matrix.at<double>(i, j);
-            camVector.push_back(f_val);
+            return (-1);
         }
+        capdev = NULL;
+        refS = replayFrameSize(replay);
     }
-    // Write camera matrix data to the CSV file.
-    append_image_data_csv(fileName_char, labelName_char, camVector);
-
-    // Define the label for the distortion coefficient data in the CSV file.
-    columnName = "distortion_coefficient";
-    // Convert the label to a C-style string.
-    char *label_char = new char[columnName.length() + 1];
-    strcpy(label_char, columnName.c_str());
-
-    // Vector to store distortion coefficient data.
-    std::vector<float> distVector;
-    // Iterate over each element in the distortion coefficients matrix.
-    for (int i = 0; i < dist_coeff.rows; i++)
+    else
     {
-        for (int j = 0; j < dist_coeff.cols; j++)
+        // Open the video device
+        capdev = new cv::VideoCapture("/dev/video1"); // Dynamically allocate a VideoCapture object
+        if (!capdev->isOpened())                      // Check if the video capture is open
         {
-            // Convert each double value to float and push it to the vector.
-            float f_val = (float)dist_coeff.at<double>(i, j);
-            distVector.push_back(f_val);
+            printf("Unable to open video frame\n"); // Print error message
+            return (-1);                            // Return -1 to indicate failure
         }
-    }
-    // Write distortion coefficient data to the CSV file.
-    append_image_data_csv(fileName_char, label_char, distVector);
 
-    // Return 0 to indicate successful execution.
-    return 0;
-}
+        // Set properties of the video capture
+        capdev->set(cv::CAP_PROP_FRAME_WIDTH, capture_size.width);   // Set frame width
+        capdev->set(cv::CAP_PROP_FRAME_HEIGHT, capture_size.height); // Set frame height
+        // Get the expected frame size
+        refS = cv::Size((int)capdev->get(cv::CAP_PROP_FRAME_WIDTH), (int)capdev->get(cv::CAP_PROP_FRAME_HEIGHT)); // Get frame size
+    }
+    printf("Expected size: %d %d\n", static_cast<int>(refS.width), static_cast<int>(refS.height)); // Print expected frame size
 
-/*
- main function
- */
-int main(int argc, char *argv[])
-{
-    cv::VideoCapture *capdev; // Pointer to a VideoCapture object
+    // The preview page offers the keys this frontend binds
+    preview.buttons = {{'s', "save view"}, {'c', "save calibration"}, {'r', "drop outliers"}, {'a', "auto-capture"}, {'u', "undistort"},
+                       {'x', "axes"}, {'d', "object"}, {'k', "adopt drift update"}, {'q', "quit"}};
 
-    // Open the video device
-    capdev = new cv::VideoCapture("/dev/video1"); // Dynamically allocate a VideoCapture object
-    if (!capdev->isOpened())                      // Check if the video capture is open
+    // Create a named window, unless the output is served as a preview stream instead
+    if (startPreview(preview) != 0)
     {
-        printf("Unable to open video frame\n"); // Print error message
-        return (-1);                            // Return -1 to indicate failure
+        cv::namedWindow("Video", 1); // Create a window to display video
     }
 
-    // Set properties of the video capture
-    capdev->set(cv::CAP_PROP_FRAME_WIDTH, 960);  // Set frame width
-    capdev->set(cv::CAP_PROP_FRAME_HEIGHT, 540); // Set frame height
-    // Get the expected frame size
-    cv::Size refS((int)capdev->get(cv::CAP_PROP_FRAME_WIDTH), (int)capdev->get(cv::CAP_PROP_FRAME_HEIGHT)); // Get frame size
-    printf("Expected size: %d %d\n", static_cast<int>(refS.width), static_cast<int>(refS.height));          // Print expected frame size
-
-    // Create a named window
-    cv::namedWindow("Video", 1); // Create a window to display video
-
     // Initialize global variables for different tasks
     cv::Mat frame;    // Matrix to store each frame
     int frameNo = 1;  // Variable to keep track of frame number
@@ -233,25 +162,57 @@ int main(int argc, char *argv[])
     cv::Mat output;   // Matrix for output
 
     // Flags for different functionalities
-    bool drawCorners = true; // Flag to draw corners
-    bool DispAxes = false;   // Flag to display axes
-    bool DispObject = false; // Flag to display object
-    bool robust = false;     // Flag for robustness
-
-    // Lists for storing points and corners
-    std::vector<std::vector<cv::Vec3f>> points_list;    // Vector of vectors to store points
-    std::vector<std::vector<cv::Point2f>> corners_list; // Vector of vectors to store corners
-
-    // Camera matrix and distortion coefficients
-    double cammat[] = {1, 0, (double)frame.cols / 2, 0, 1, (double)frame.rows / 2, 0, 0, 1}; // Define camera matrix
-    cv::Mat camera_matrix(cv::Size(3, 3), CV_64FC1, &cammat);                                // Initialize camera matrix
-    cv::Mat dist_coeff;                                                                      // Matrix for distortion coefficients
-    cv::Mat rot, trans;                                                                      // Matrices for rotation and translation
+    bool drawCorners = true;  // Flag to draw corners
+    bool DispAxes = false;    // Flag to display axes
+    bool DispObject = false;  // Flag to display object
+    bool robust = false;      // Flag for robustness
+    bool autoCapture = false; // Flag for automatic calibration view capture
+
+    // The chessboard, the lists of points and corners, and the camera matrix and distortion coefficients live in the core context
+    initCoreContext(core, TARGET_CHESSBOARD, refS);
+    std::vector<std::vector<cv::Vec3f>> &points_list = core.points_list;                       // Vector of vectors to store points
+    std::vector<std::vector<cv::Point2f>> &corners_list = core.corners_list;                   // Vector of vectors to store corners
+    cv::Mat &camera_matrix = core.camera_matrix;                                               // Camera matrix
+    cv::Mat &dist_coeff = core.dist_coeff;                                                     // Matrix for distortion coefficients
+    cv::Mat rot, trans;                                                                        // Matrices for rotation and translation
+    ViewSelector selector;                                                                     // Coverage and pose diversity of auto-captured views
+    OverlayCompositor overlays;                                                                // Axes and virtual objects, each cached in its own tile
+    int axes_layer = addLineLayer(overlays, core.target.axes);
+    int object_layer = addLineLayer(overlays, core.target.objects);
+    cv::Size calib_size;                                                                       // Frame size the loaded calibration was made at
+    cv::Mat map_x, map_y;                                                                      // Undistortion remap tables for the current frame size
+    uint64_t map_calibration = 0;                                                              // calibrationId of the calibration the remap tables were built from
+    bool DispUndistort = false;                                                                // Flag to display the undistorted stream
+    FrameScheduler scheduler;                                                                  // Chooses detection, tracking or prediction per frame
+    initScheduler(scheduler, target_fps);
+    SessionRecorder recorder;                                                                  // Records the capture session to record_file
+    if (!record_file.empty())
+    {
+        startRecording(recorder, record_file, record_encoding);
+    }
+    PoseLogger poses;                                                                          // Streams the pose of every AR frame to pose_log
+    startPoseLog(poses, pose_log);
+    startFrameWriter(writer);
+    ViewStore view_store;                                                                      // Calibration views kept across runs in views_file
+    if (!views_file.empty() && openViewStore(view_store, views_file) == 0)
+    {
+        printf("Resumed %d calibration views from %s\n", viewStoreCount(view_store, camera_id, refS), views_file.c_str());
+    }
 
     // Start live feed from the video device
     while (true) // Infinite loop for live video feed
     {
-        *capdev >> frame;  // Get a new frame from the camera, treat as a stream
+        int recorded_key = -1; // Key pressed on this frame when the session was recorded
+        if (!replaying)
+        {
+            *capdev >> frame; // Get a new frame from the camera, treat as a stream
+        }
+        else if (!replayFrame(replay, frame, recorded_key))
+        {
+            frame.release(); // End of the recorded session
+        }
+        recordFrame(recorder, frame);
+
         if (frame.empty()) // Check if the frame is empty
         {
             printf("Frame is empty\n"); // Print error message
@@ -263,76 +224,122 @@ int main(int argc, char *argv[])
         // Vector to store detected points
         std::vector<cv::Vec3f> points; // Vector to store detected points
 
-        // Task 1 - Extract corners from chessboard
-        bool found = CornersExtract(frame, output, corners, drawCorners);
+        // Task 1 - Extract corners from chessboard, and in AR modes Task 4 - calculate the camera position and Task 5 - draw the overlays
+        // This is the step soak runs for hours, so the frame path it measures is the one shipped here
+        overlays.layers[axes_layer].visible = DispAxes;
+        overlays.layers[object_layer].visible = DispObject;
+        bool found = processArFrame(core, scheduler, drift, overlays, frame, output, corners, rot, trans, DispAxes || DispObject, drawCorners);
 
-        // Display axes if enabled and corners are found
-        if (DispAxes && found)
+        // Hand the pose to the pose stream; formatting and I/O happen on its writer thread
+        if ((DispAxes || DispObject) && found)
         {
-            // Task 2 - Select calibration image
-            selectCalibrationImg(corners, corners_list, points, points_list);
-
-            // Task 4 - Calculate current position of the camera
-            cameraCalcPosition(points, corners, camera_matrix, dist_coeff, rot, trans);
-            // Display rotation matrix
-            std::cout << std::endl
-                      << "rotation_matrix: " << rot << std::endl;
-            // Display translation matrix
-            std::cout << std::endl
-                      << "translation_matrix: " << trans << std::endl;
-
-            // Task 5 - Project 3D axes
-            draw3dAxes(output, camera_matrix, dist_coeff, rot, trans);
+            pushPose(poses, rot, trans);
         }
 
-        // Check if displaying a virtual object is enabled and corners were found in the frame
-        if (DispObject && found)
+        // Publish the frame's corners and pose to local consumers
+        if (!shm.name.empty() && !shm.failed)
         {
-            // Select the current frame as a calibration image based on detected corners, updating lists of corners and 3D points
-            selectCalibrationImg(corners, corners_list, points, points_list);
+            cv::Mat no_pose;
+            bool posed = (DispAxes || DispObject) && found;
+            shmPublish(shm, output, corners, found, posed ? rot : no_pose, posed ? trans : no_pose, calibrationId(camera_matrix, dist_coeff));
+        }
 
-            // Calculate the current position (pose) of the camera relative to the chessboard
-            // This involves computing the rotation and translation matrices
-            cameraCalcPosition(points, corners, camera_matrix, dist_coeff, rot, trans);
-            // Print the rotation matrix to the console for debugging or information purposes
-            std::cout << std::endl
-                      << "rotation_matrix: " << rot << std::endl;
-            // Print the translation matrix to the console for debugging or information purposes
-            std::cout << std::endl
-                      << "translation_matrix: " << trans << std::endl;
+        // Keep only the views that add coverage or pose diversity while auto-capture is enabled
+        if (autoCapture && found && !DispAxes && !DispObject)
+        {
+            float score = scoreCalibrationView(selector, corners, Chessboard9x6::size());
+            if (score >= selector.min_score)
+            {
+                // Task 2 - Select calibration image
+                selectCalibrationImg(core, corners, points);
+                appendView(view_store, points, corners, camera_id, frame.size());
+                acceptCalibrationView(selector, corners, Chessboard9x6::size());
+                frameCal = (int)corners_list.size() + 1;
+                std::cout << "Auto-captured calibration view " << corners_list.size() << " (score " << score << ")" << std::endl;
+
+                if ((int)corners_list.size() >= selector.min_views)
+                {
+                    // Task 3 - Calibrate the camera and check how well the intrinsics are constrained
+                    float reprojErr = calibrateWithUncertainty(selector, points_list, corners_list, camera_matrix, dist_coeff);
+                    std::cout << "calibrated camera matrix:" << std::endl;
+                    std::cout << camera_matrix << std::endl;
+                    std::cout << "re-projection error: " << reprojErr << "\t relative uncertainty: " << selector.uncertainty << std::endl;
+
+                    // Stop capturing once more views would no longer change the intrinsics
+                    if (selector.converged)
+                    {
+                        autoCapture = false;
+                        std::cout << "Calibration converged with " << corners_list.size() << " views, press 'c' to save" << std::endl;
+                    }
+                }
+            }
+        }
 
-            // Create and display a virtual object in the output frame
-            // The object's position and orientation are determined by the camera's pose
-            draw3dObject(output, camera_matrix, dist_coeff, rot, trans);
+        // Undistort the displayed frame, rebuilding the remap tables whenever the stream size or the calibration changes
+        // (calibrating with s, r or auto-capture, loading with x or d, adopting with k)
+        if (DispUndistort && !dist_coeff.empty())
+        {
+            uint64_t calibration = calibrationId(camera_matrix, dist_coeff);
+            if (map_x.empty() || map_x.size() != output.size() || map_calibration != calibration)
+            {
+                buildUndistortMaps(camera_matrix, dist_coeff, output.size(), map_x, map_y);
+                map_calibration = calibration;
+            }
+            cv::Mat undistorted;
+            cv::remap(output, undistorted, map_x, map_y, cv::INTER_LINEAR);
+            output = undistorted;
         }
 
-        // Display the current frame (with any overlays like the virtual object) in the "Video" window
-        cv::imshow("Video", output);
+        // Display the current frame (with any overlays like the virtual object) in the "Video" window, or hand it to the preview encoder
+        if (preview.running)
+        {
+            publishPreview(preview, output);
+        }
+        else
+        {
+            cv::imshow("Video", output);
+        }
+        queueVideoFrame(writer, output);
 
         // Wait for a keystroke with a short delay (10 milliseconds)
         // This function also processes window events, allowing the displayed image to update
-        char key = cv::waitKey(10);
+        // With the preview on, keys arrive as /key commands and the capture paces the loop
+        char key = preview.running ? (char)previewKey(preview) : cv::waitKey(replaying && !replay_realtime ? 1 : 10);
+        if (replaying && key != 'q')
+        {
+            key = (char)recorded_key; // Replay the recorded keypresses so the session takes the same path
+        }
+        recordKey(recorder, key);
+
+        // Close the frame timing so the scheduler can measure the per-frame overhead
+        if (target_fps > 0 && (DispAxes || DispObject))
+        {
+            finishFrame(scheduler);
+        }
 
         // Check if the 'q' key was pressed, which is designated to quit the loop/program
         if (key == 'q')
         {
             break; // Exit the loop, leading to the termination of the program or moving to the next block of code
         }
+        // Refuse to save a blurred frame; its corners were not searched, and would not be accurate anyway
+        else if (key == 's' && !core.focus.sharp && !DispAxes && !DispObject)
+        {
+            core.focus.refused++;
+            printf("Frame too blurred for calibration (focus %.1f, threshold %.1f), hold the camera still\n", core.focus.score, core.focus.threshold);
+        }
         // Press 's' to save current calibration frame and perform calibration if frames >= 5
         else if (key == 's' && found && !DispAxes && !DispObject && drawCorners)
         {
             // Task 2 - Select calibration images
-            selectCalibrationImg(corners, corners_list, points, points_list);
+            selectCalibrationImg(core, corners, points);
+            appendView(view_store, points, corners, camera_id, frame.size());
 
             // Print message indicating saving of calibration image
             printf("Saving calibration image...\n");
 
-            // Generate filename for calibration image
-            std::string fname = "calibration-frame-";
-            fname += std::to_string(frameCal) + ".jpg";
-
-            // Save the calibration frame
-            imwrite(fname, output);
+            // Queue the calibration frame for the writer thread
+            queueSnapshot(writer, "calibration-frame-" + std::to_string(frameCal), output);
 
             // Print information about the saved calibration image
             std::cout << "---------------------------------------------------------------------------" << std::endl;
@@ -354,17 +361,19 @@ int main(int argc, char *argv[])
         // Print a separator line
         std::cout << "---------------------------------------------------------------------------" << std::endl;
 
-        // Require at least 5 frames for calibration
-        if (frameCal >= 5)
+        // Require at least 5 frames for calibration, counting the views resumed from the view store
+        int stored = viewStoreCount(view_store, camera_id, frame.size());
+        if (frameCal >= 5 || stored >= 5)
         {
             // Task 3 - Calibrate the camera
-            std::cout << "Performing calibration with " << frameCal << " frames..." << std::endl;
+            std::cout << "Performing calibration with " << (stored >= 5 ? stored : frameCal) << " frames..." << std::endl;
             // Print initial camera matrix
             std::cout << "initial camera matrix:" << std::endl;
             std::cout << camera_matrix << std::endl;
 
-            // Calibrate the camera and calculate reprojection error
-            float reprojErr = calibrateCamera(points_list, corners_list, camera_matrix, dist_coeff);
+            // Calibrate the camera and calculate reprojection error; a view store is calibrated in place, without copying its views
+            float reprojErr = stored >= 5 ? calibrateViewStore(view_store, camera_id, frame.size(), camera_matrix, dist_coeff, solver)
+                                         : calibrateCamera(core, frame.size(), solver);
 
             // Print the calibration statistics for the user
             std::cout << "calibrated camera matrix:" << std::endl;
@@ -382,12 +391,72 @@ int main(int argc, char *argv[])
             // Save current calibration in a csv file
             std::cout << std::endl
                       << "Saving performed calibration..." << std::endl;
-            saveCalibration(camera_matrix, dist_coeff);
+            saveCalibration("checker_data.csv", camera_matrix, dist_coeff, frame.size());
+        }
+
+        // Press 'r' to recalibrate without the outlier views and write a quality report
+        else if (key == 'r' && corners_list.size() >= 5 && !DispAxes && !DispObject && drawCorners)
+        {
+            CalibrationReport report;
+            float reprojErr = calibrateWithOutlierRejection(points_list, corners_list, frame.size(), camera_matrix, dist_coeff, 1.0, 5, report);
+
+            // Keep only the views used by the final calibration
+            std::vector<std::vector<cv::Vec3f>> kept_points;
+            std::vector<std::vector<cv::Point2f>> kept_corners;
+            for (int index : report.kept_views)
+            {
+                kept_points.push_back(points_list[index]);
+                kept_corners.push_back(corners_list[index]);
+            }
+            points_list = kept_points;
+            corners_list = kept_corners;
+            frameCal = (int)corners_list.size() + 1;
+
+            writeCalibrationReport(report, "calibration-report");
+            std::cout << "Dropped " << report.dropped_views.size() << " views in " << report.rounds << " rounds, kept " << corners_list.size() << std::endl;
+            std::cout << "calibrated camera matrix:" << std::endl;
+            std::cout << camera_matrix << std::endl;
+            std::cout << "re-projection error: " << reprojErr << std::endl;
+            std::cout << "Report written to calibration-report.txt and calibration-report-heatmap.png" << std::endl;
+        }
+
+        // Press 'a' to toggle automatic capture of calibration views
+        else if (key == 'a' && !DispAxes && !DispObject)
+        {
+            autoCapture = !autoCapture;
+            if (autoCapture)
+            {
+                // Views saved by hand already count towards coverage
+                initViewSelector(selector, frame.size());
+                for (auto &saved : corners_list)
+                {
+                    acceptCalibrationView(selector, saved, Chessboard9x6::size());
+                }
+            }
+            std::cout << "Auto-capture " << (autoCapture ? "enabled" : "disabled") << std::endl;
+        }
+
+        // Press 'u' to toggle the undistorted view with the current calibration
+        else if (key == 'u' && !dist_coeff.empty())
+        {
+            DispUndistort = !DispUndistort;
+            map_x.release(); // Rebuild the tables from the current calibration
+        }
+
+        // Press 'k' to adopt the intrinsics proposed by the drift monitor and save them in place of the loaded calibration
+        else if (key == 'k' && takeDriftProposal(drift, camera_matrix, dist_coeff))
+        {
+            saveCalibration("checker_data.csv", camera_matrix, dist_coeff, frame.size());
+            std::cout << std::endl
+                      << "adopted camera matrix:" << std::endl;
+            std::cout << camera_matrix << std::endl;
+            std::cout << "distortion coefficients: " << dist_coeff << std::endl;
         }
 
         // Press 'x' to display 3d axes at the origin of world coordinates
         else if (key == 'x' && found)
         {
+            bool was_posing = DispAxes || DispObject; // An AR mode was already on, watched against the same calibration
             // Toggle the display of axes
             DispAxes = !DispAxes;
             if (DispObject)
@@ -399,15 +468,23 @@ int main(int argc, char *argv[])
 
             // Read calibration to display axes
             std::string fileName = "checker_data.csv";
-            readCalibration(fileName, camera_matrix, dist_coeff);
+            bool loaded = readCalibration(fileName, camera_matrix, dist_coeff, calib_size) == 0;
+            rescaleIntrinsics(camera_matrix, calib_size, frame.size()); // Match the calibration to the stream resolution
             std::cout << std::endl
                       << "retrieved calibrated camera matrix:" << std::endl;
             std::cout << camera_matrix << std::endl;
             std::cout << "distortion coefficients: " << dist_coeff << std::endl;
+
+            // Watch the loaded calibration for drift once an AR mode is switched on; switching modes or turning them off keeps what was measured
+            if (loaded && !was_posing && (DispAxes || DispObject))
+            {
+                startDriftMonitor(drift, core.target.points, camera_matrix, dist_coeff, frame.size());
+            }
         }
         // press 'd' to display 3d objects
         else if (key == 'd' && found)
         {
+            bool was_posing = DispAxes || DispObject; // An AR mode was already on, watched against the same calibration
             if (DispAxes)
             {
                 DispAxes = !DispAxes;
@@ -417,14 +494,43 @@ int main(int argc, char *argv[])
 
             // read calibration to display virtual object
             std::string fileName = "checker_data.csv";
-            readCalibration(fileName, camera_matrix, dist_coeff);
+            bool loaded = readCalibration(fileName, camera_matrix, dist_coeff, calib_size) == 0;
+            rescaleIntrinsics(camera_matrix, calib_size, frame.size()); // Match the calibration to the stream resolution
             std::cout << std::endl
                       << "retrieved calibrated camera matrix:" << std::endl;
             std::cout << camera_matrix << std::endl;
             std::cout << "distortion coefficients: " << dist_coeff << std::endl;
+
+            // Watch the loaded calibration for drift once an AR mode is switched on; switching modes or turning them off keeps what was measured
+            if (loaded && !was_posing && (DispAxes || DispObject))
+            {
+                startDriftMonitor(drift, core.target.points, camera_matrix, dist_coeff, frame.size());
+            }
         }
     }
 
+    stopPoseLog(poses);
+    shmClosePublisher(shm);
+    stopRecording(recorder);
+    closeReplay(replay);
+    closeViewStore(view_store);
+    stopFrameWriter(writer);
+    stopPreview(preview);
+    stopDriftMonitor(drift);
+    if (overlays.renders > 0)
+    {
+        printf("Overlays: %d tiles rendered, %d reused, %d shifted\n", overlays.renders, overlays.reuses, overlays.shifts);
+    }
+    if (core.focus.enabled && core.focus.frames > 0)
+    {
+        printf("Focus gate: %d of %d frames blurred, %d captures refused, %.3f ms per measure\n", core.focus.blurred, core.focus.frames,
+               core.focus.refused, core.focus.ms / core.focus.frames);
+    }
+    if (core.prefilter.enabled && core.prefilter.frames > 0)
+    {
+        printf("Pre-filter: rejected %d of %d tested frames, %.3f ms per test\n", core.prefilter.rejected, core.prefilter.frames,
+               core.prefilter.test_ms / core.prefilter.frames);
+    }
     delete capdev;
 
     return (0);
@@ -16,30 +16,133 @@ main() CPP function for extensions to the AR system.
 #include <opencv2/imgproc/imgproc.hpp>
 
 // User-defined header
-#include "extension.h"
+#include "core.h"
+#include "calibquality.h"
+#include "resolution.h"
+#include "scheduler.h"
+#include "poselog.h"
+#include "shmring.h"
+#include "recorder.h"
+#include "viewstore.h"
+#include "framewriter.h"
+#include "preview.h"
+#include "driftmon.h"
 
 // Main function
 int main(int argc, char *argv[])
 {
     cv::VideoCapture *capdev; // Pointer to VideoCapture object
 
-    // Open the video device
-    capdev = new cv::VideoCapture("/dev/video1");
-    if (!capdev->isOpened())
+    // Read the requested capture resolution and scheduling from the command line, e.g. --size=1280x720
+    cv::Size capture_size(960, 540);
+    double target_fps = 0.0; // Display rate held by the frame scheduler in AR modes, e.g. --target-fps=30
+    std::string pose_log;    // Destination of the pose stream in AR modes, e.g. --pose-log=poses.csv
+    ShmPublisher shm;        // Shared-memory ring for local consumers, e.g. --shm=/calib_ar --shm-frames
+    std::string record_file; // Session file the capture is recorded to, e.g. --record=session.rec [--record-png]
+    std::string replay_file; // Session file replayed instead of the camera, e.g. --replay=session.rec [--replay-fast]
+    std::string views_file;  // Store the calibration views are kept in across runs, e.g. --views=calib.views [--camera-id=N]
+    int camera_id = 0;       // Camera the stored views are tagged with
+    BundleParams solver;     // Calibration solver, e.g. --solver=sparse --loss=huber:1.5 --fix=k3
+    FrameWriter writer;      // Saves snapshots and the output stream off the frame loop, e.g. --video-out=ar.avi --video-codec=mp4v
+    PreviewServer preview;   // MJPEG stream on localhost in place of the window, e.g. --preview=8080 --preview-width=640
+    DriftMonitor drift;      // Watches the loaded calibration for drift in AR modes, e.g. --drift=60 --drift-budget=0.05
+    CoreContext core;        // Target, calibration views and detector state of this session
+    FrameEncoding record_encoding = ENCODE_RAW;
+    bool replay_realtime = true;
+    for (int i = 1; i < argc; i++)
     {
-        printf("Unable to open video device\n");
-        return (-1);
+        std::string arg = argv[i];
+        if (arg.rfind("--size=", 0) == 0)
+        {
+            sscanf(arg.c_str(), "--size=%dx%d", &capture_size.width, &capture_size.height);
+        }
+        else if (arg.rfind("--target-fps=", 0) == 0)
+        {
+            target_fps = atof(arg.c_str() + 13);
+        }
+        else if (arg.rfind("--pose-log=", 0) == 0)
+        {
+            pose_log = arg.substr(11);
+        }
+        else if (arg == "--shm" || arg.rfind("--shm=", 0) == 0)
+        {
+            shm.name = arg.size() > 6 ? arg.substr(6) : "/calib_ar";
+        }
+        else if (arg == "--shm-frames")
+        {
+            shm.with_frames = true;
+            shm.name = shm.name.empty() ? "/calib_ar" : shm.name;
+        }
+        else if (arg.rfind("--record=", 0) == 0)
+        {
+            record_file = arg.substr(9);
+        }
+        else if (arg == "--record-png")
+        {
+            record_encoding = ENCODE_PNG;
+        }
+        else if (arg.rfind("--replay=", 0) == 0)
+        {
+            replay_file = arg.substr(9);
+        }
+        else if (arg == "--replay-fast")
+        {
+            replay_realtime = false;
+        }
+        else if (arg.rfind("--views=", 0) == 0)
+        {
+            views_file = arg.substr(8);
+        }
+        else if (arg.rfind("--camera-id=", 0) == 0)
+        {
+            camera_id = atoi(arg.c_str() + 12);
+        }
+        else
+        {
+            parseFrameWriterArg(writer, arg) || parseBundleArg(solver, arg) || parsePreviewArg(preview, arg) || parseDriftArg(drift, arg); // Snapshot, video, solver, preview and drift options
+        }
     }
 
-    // Set properties of the image
-    capdev->set(cv::CAP_PROP_FRAME_WIDTH, 960);
-    capdev->set(cv::CAP_PROP_FRAME_HEIGHT, 540);
-    cv::Size refS((int)capdev->get(cv::CAP_PROP_FRAME_WIDTH),
-                  (int)capdev->get(cv::CAP_PROP_FRAME_HEIGHT));
+    // Replay a recorded session instead of the camera when requested
+    SessionReplay replay;
+    bool replaying = !replay_file.empty();
+    cv::Size refS;
+    if (replaying)
+    {
+        if (openReplay(replay, replay_file, replay_realtime) != 0)
+        {
+            return (-1);
+        }
+        capdev = NULL;
+        refS = replayFrameSize(replay);
+    }
+    else
+    {
+        // Open the video device
+        capdev = new cv::VideoCapture("/dev/video1");
+        if (!capdev->isOpened())
+        {
+            printf("Unable to open video device\n");
+            return (-1);
+        }
+
+        // Set properties of the image
+        capdev->set(cv::CAP_PROP_FRAME_WIDTH, capture_size.width);
+        capdev->set(cv::CAP_PROP_FRAME_HEIGHT, capture_size.height);
+        refS = cv::Size((int)capdev->get(cv::CAP_PROP_FRAME_WIDTH),
+                        (int)capdev->get(cv::CAP_PROP_FRAME_HEIGHT));
+    }
     printf("Expected size: %d %d\n", refS.width, refS.height);
 
-    // Create a window to display video
-    cv::namedWindow("Video", 1);
+    // The preview page offers the keys this frontend binds
+    preview.buttons = {{'s', "save view"}, {'c', "save calibration"}, {'r', "drop outliers"}, {'x', "axes"}, {'o', "object"},
+                       {'t', "canvas"}, {'p', "snapshot"}, {'k', "adopt drift update"}, {'q', "quit"}};
+
+    // Create a window to display video, unless the output is served as a preview stream instead
+    if (startPreview(preview) != 0)
+    {
+        cv::namedWindow("Video", 1);
+    }
 
     // Initialize variables
     cv::Mat frame;    // Matrix to hold each frame
@@ -47,24 +150,58 @@ int main(int argc, char *argv[])
     int frameCal = 1; // Calibration frame number
     cv::Mat output;   // Output image
 
-    bool drawCenters = true;                            // Boolean flag for drawing centers
-    std::vector<std::vector<cv::Vec3f>> points_list;    // List to store points
-    std::vector<std::vector<cv::Point2f>> centers_list; // List to store centers
+    bool drawCenters = true; // Boolean flag for drawing centers
 
-    // Camera matrix initialization
-    double cammat[] = {1, 0, (double)frame.cols / 2, 0, 1, (double)frame.rows / 2, 0, 0, 1};
-    cv::Mat camera_matrix(cv::Size(3, 3), CV_64FC1, &cammat);
-    cv::Mat dist_coefficient; // Distortion coefficients
-    cv::Mat rot, trans;       // Rotation and translation matrices
-    bool DispAxes = false;    // Boolean flag for displaying axes
-    bool DispObject = false;  // Boolean flag for displaying object
+    // The circle grid, the lists of points and centers, and the camera matrix and distortion coefficients live in the core context
+    initCoreContext(core, TARGET_CIRCLES, refS);
+    std::vector<std::vector<cv::Vec3f>> &points_list = core.points_list;    // List to store points
+    std::vector<std::vector<cv::Point2f>> &centers_list = core.corners_list; // List to store centers
+    cv::Mat &camera_matrix = core.camera_matrix;                             // Camera matrix
+    cv::Mat &dist_coefficient = core.dist_coeff;                             // Distortion coefficients
+
+    cv::Size calib_size;     // Frame size the loaded calibration was made at
+    cv::Mat rot, trans;      // Rotation and translation matrices
+    bool DispAxes = false;   // Boolean flag for displaying axes
+    bool DispObject = false; // Boolean flag for displaying object
 
     bool canvas = false; // Boolean flag for canvas mode
 
+    OverlayCompositor overlays;                     // Target artwork, axes and virtual object, each cached in its own tile
+    cv::Mat artwork = cv::imread("nature.jpeg", 1); // Image placed on the target in canvas mode, read once
+    int target_layer = addImageLayer(overlays, artwork, core.target.quad);
+    int axes_layer = addLineLayer(overlays, core.target.axes);
+    int object_layer = addLineLayer(overlays, core.target.objects);
+
+    FrameScheduler scheduler; // Chooses detection, tracking or prediction per frame
+    initScheduler(scheduler, target_fps);
+    SessionRecorder recorder; // Records the capture session to record_file
+    if (!record_file.empty())
+    {
+        startRecording(recorder, record_file, record_encoding);
+    }
+    PoseLogger poses; // Streams the pose of every AR frame to pose_log
+    startPoseLog(poses, pose_log);
+    startFrameWriter(writer);
+    ViewStore view_store; // Calibration views kept across runs in views_file
+    if (!views_file.empty() && openViewStore(view_store, views_file) == 0)
+    {
+        printf("Resumed %d calibration views from %s\n", viewStoreCount(view_store, camera_id, refS), views_file.c_str());
+    }
+
     // Start live feed from the video device
     while (true)
     {
-        *capdev >> frame; // Get a new frame from the camera, treat as a stream
+        int recorded_key = -1; // Key pressed on this frame when the session was recorded
+        if (!replaying)
+        {
+            *capdev >> frame; // Get a new frame from the camera, treat as a stream
+        }
+        else if (!replayFrame(replay, frame, recorded_key))
+        {
+            frame.release(); // End of the recorded session
+        }
+        recordFrame(recorder, frame);
+
         if (frame.empty())
         {                               // Check if the frame is empty
             printf("frame is empty\n"); // Print message indicating the frame is empty
@@ -74,63 +211,51 @@ int main(int argc, char *argv[])
         std::vector<cv::Point2f> centers; // Vector to store detected centers
         std::vector<cv::Vec3f> points;    // Vector to store detected points
 
-        // Extracting corners from circle-grid
-        bool found = circleExtractCenters(frame, output, centers, drawCenters);
+        // Extract centers from the circle grid, and in AR modes calculate the camera position and draw the overlays
+        // This is the step soak runs for hours, so the frame path it measures is the one shipped here
+        overlays.layers[target_layer].visible = canvas;
+        overlays.layers[axes_layer].visible = DispAxes;
+        overlays.layers[object_layer].visible = DispObject;
+        bool found = processArFrame(core, scheduler, drift, overlays, frame, output, centers, rot, trans, DispAxes || DispObject || canvas, drawCenters);
 
-        // Display axes
-        if (DispAxes && found)
+        // Hand the pose to the pose stream; formatting and I/O happen on its writer thread
+        if ((DispAxes || DispObject || canvas) && found)
         {
-            selectCalibrationImg(centers, centers_list, points, points_list); // Select calibration images
-
-            // Calculate current position of the camera
-            calcCameraPosition(points, centers, camera_matrix, dist_coefficient, rot, trans);
-            std::cout << std::endl
-                      << "rotation matrix: " << rot << std::endl; // Print rotation matrix
-            std::cout << std::endl
-                      << "translation matrix: " << trans << std::endl; // Print translation matrix
-
-            // Project 3D axes
-            draw3dAxes(output, camera_matrix, dist_coefficient, rot, trans);
+            pushPose(poses, rot, trans);
         }
 
-        // Display virtual object
-        if (DispObject && found)
+        // Publish the frame's corners and pose to local consumers
+        if (!shm.name.empty() && !shm.failed)
         {
-            selectCalibrationImg(centers, centers_list, points, points_list); // Select calibration images
-
-            // Calculate current position of the camera
-            calcCameraPosition(points, centers, camera_matrix, dist_coefficient, rot, trans);
-            std::cout << std::endl
-                      << "rotation matrix: " << rot << std::endl; // Print rotation matrix
-            std::cout << std::endl
-                      << "translation matrix: " << trans << std::endl; // Print translation matrix
-
-            // Create a virtual object
-            draw3dObject(output, camera_matrix, dist_coefficient, rot, trans);
+            cv::Mat no_pose;
+            bool posed = (DispAxes || DispObject || canvas) && found;
+            shmPublish(shm, output, centers, found, posed ? rot : no_pose, posed ? trans : no_pose, calibrationId(camera_matrix, dist_coefficient));
         }
 
-        // Transform target into image canvas if canvas mode is enabled and circles are found
-        if (canvas && found)
+        // Display the current frame
+        if (preview.running)
         {
-            selectCalibrationImg(centers, centers_list, points, points_list); // Select calibration images
-
-            // Calculate current position of the camera
-            calcCameraPosition(points, centers, camera_matrix, dist_coefficient, rot, trans);
-            std::cout << std::endl
-                      << "Rotation matrix: " << rot << std::endl; // Print rotation matrix
-            std::cout << std::endl
-                      << "Translation matrix: " << trans << std::endl; // Print translation matrix
-
-            std::string imageFilename = "nature.jpeg"; // Define filename for the image to be placed on the target
-            // Draw image contents on the target
-            drawOnTarget(frame, output, camera_matrix, dist_coefficient, rot, trans, imageFilename);
+            publishPreview(preview, output); // Hand the frame to the preview encoder when --preview was given
         }
+        else
+        {
+            cv::imshow("Video", output);     // Show the current frame on a window titled "Video"
+        }
+        queueVideoFrame(writer, output);     // Record the composited frame when --video-out was given
 
-        // Display the current frame
-        cv::imshow("Video", output); // Show the current frame on a window titled "Video"
+        // Check if there is a waiting keystroke, or a key command sent to the preview
+        char key = preview.running ? (char)previewKey(preview) : cv::waitKey(replaying && !replay_realtime ? 1 : 10);
+        if (replaying && key != 'q')
+        {
+            key = (char)recorded_key; // Replay the recorded keypresses so the session takes the same path
+        }
+        recordKey(recorder, key);
 
-        // Check if there is a waiting keystroke
-        char key = cv::waitKey(10);
+        // Close the frame timing so the scheduler can measure the per-frame overhead
+        if (target_fps > 0 && (DispAxes || DispObject || canvas))
+        {
+            finishFrame(scheduler);
+        }
 
         // Press 'q' to quit
         if (key == 'q')
@@ -142,12 +267,11 @@ int main(int argc, char *argv[])
         else if (key == 's' && found && !DispAxes && !DispObject && drawCenters)
         {
             // Select calibration images
-            selectCalibrationImg(centers, centers_list, points, points_list);
+            selectCalibrationImg(core, centers, points);
+            appendView(view_store, points, centers, camera_id, frame.size());
 
-            printf("Saving calibration image...\n");    // Print message indicating saving of calibration image
-            std::string fname = "calibration-frame-";   // Create filename prefix for calibration frame
-            fname += std::to_string(frameCal) + ".jpg"; // Append frame number to filename prefix
-            imwrite(fname, output);                     // Save calibration frame as an image
+            printf("Saving calibration image...\n");                                         // Print message indicating saving of calibration image
+            queueSnapshot(writer, "calibration-frame-" + std::to_string(frameCal), output); // Save calibration frame from the writer thread
 
             // Print the corner points in world coordinates with corresponding image coordinates
             std::cout << "---------------------------------------------------------------------------" << std::endl;
@@ -162,15 +286,18 @@ int main(int argc, char *argv[])
             }
             std::cout << "---------------------------------------------------------------------------" << std::endl;
 
-            // Require at least 5 frames for calibration
-            if (frameCal >= 5)
+            // Require at least 5 frames for calibration, counting the views resumed from the view store
+            int stored = viewStoreCount(view_store, camera_id, frame.size());
+            if (frameCal >= 5 || stored >= 5)
             {
                 // Calibrate the camera
-                std::cout << "Performing calibration with " << frameCal << " frames..." << std::endl;
+                std::cout << "Performing calibration with " << (stored >= 5 ? stored : frameCal) << " frames..." << std::endl;
                 std::cout << "Initial camera matrix:" << std::endl;
                 std::cout << camera_matrix << std::endl;
 
-                float reprojErr = calibrateCamera(points_list, centers_list, camera_matrix, dist_coefficient);
+                // A view store is calibrated in place, without copying its views
+                float reprojErr = stored >= 5 ? calibrateViewStore(view_store, camera_id, frame.size(), camera_matrix, dist_coefficient, solver)
+                                             : calibrateCamera(core, frame.size(), solver);
 
                 // Print the calibration stats for the user
                 std::cout << "Calibrated camera matrix:" << std::endl;
@@ -187,12 +314,39 @@ int main(int argc, char *argv[])
             // Save current calibration in a csv file
             std::cout << std::endl
                       << "Saving performed calibration..." << std::endl;
-            saveCalibration(camera_matrix, dist_coefficient);
+            saveCalibration("circlegrid.csv", camera_matrix, dist_coefficient, frame.size());
+        }
+
+        // Press 'r' to recalibrate without the outlier views and write a quality report
+        else if (key == 'r' && centers_list.size() >= 5 && !DispAxes && !DispObject && drawCenters)
+        {
+            CalibrationReport report;
+            float reprojErr = calibrateWithOutlierRejection(points_list, centers_list, frame.size(), camera_matrix, dist_coefficient, 1.0, 5, report);
+
+            // Keep only the views used by the final calibration
+            std::vector<std::vector<cv::Vec3f>> kept_points;
+            std::vector<std::vector<cv::Point2f>> kept_centers;
+            for (int index : report.kept_views)
+            {
+                kept_points.push_back(points_list[index]);
+                kept_centers.push_back(centers_list[index]);
+            }
+            points_list = kept_points;
+            centers_list = kept_centers;
+            frameCal = (int)centers_list.size() + 1;
+
+            writeCalibrationReport(report, "calibration-report");
+            std::cout << "Dropped " << report.dropped_views.size() << " views in " << report.rounds << " rounds, kept " << centers_list.size() << std::endl;
+            std::cout << "calibrated camera matrix:" << std::endl;
+            std::cout << camera_matrix << std::endl;
+            std::cout << "re-projection error: " << reprojErr << std::endl;
+            std::cout << "Report written to calibration-report.txt and calibration-report-heatmap.png" << std::endl;
         }
 
         // Press 'x' to display 3D axes at the origin of world coordinates
         else if (key == 'x' && found)
         {
+            bool was_posing = DispAxes || DispObject || canvas; // An AR mode was already on, watched against the same calibration
             DispAxes = !DispAxes; // Toggle display of axes
             if (DispObject)
             {
@@ -206,16 +360,22 @@ int main(int argc, char *argv[])
 
             // Read calibration to display axes
             std::string fileName = "circlegrid.csv";                    // File containing calibration data
-            readCalibration(fileName, camera_matrix, dist_coefficient); // Read calibration data from file
+            bool loaded = readCalibration(fileName, camera_matrix, dist_coefficient, calib_size) == 0; // Read calibration data from file
+            rescaleIntrinsics(camera_matrix, calib_size, frame.size());                                // Match the calibration to the stream resolution
             std::cout << std::endl
                       << "Retrieved calibrated camera matrix:" << std::endl;
             std::cout << camera_matrix << std::endl;                                   // Print retrieved camera matrix
             std::cout << "Distortion coefficients: " << dist_coefficient << std::endl; // Print distortion coefficients
+            if (loaded && !was_posing && (DispAxes || DispObject || canvas))
+            {
+                startDriftMonitor(drift, core.target.points, camera_matrix, dist_coefficient, frame.size()); // Watch the calibration once an AR mode is switched on
+            }
         }
 
         // Press 'o' to display 3D objects
         else if (key == 'o' && found)
         {
+            bool was_posing = DispAxes || DispObject || canvas; // An AR mode was already on, watched against the same calibration
             if (DispAxes)
             {
                 DispAxes = !DispAxes; // Disable display of axes if enabled
@@ -229,16 +389,22 @@ int main(int argc, char *argv[])
 
             // Read calibration to display virtual object
             std::string fileName = "circlegrid.csv";                    // File containing calibration data
-            readCalibration(fileName, camera_matrix, dist_coefficient); // Read calibration data from file
+            bool loaded = readCalibration(fileName, camera_matrix, dist_coefficient, calib_size) == 0; // Read calibration data from file
+            rescaleIntrinsics(camera_matrix, calib_size, frame.size());                                // Match the calibration to the stream resolution
             std::cout << std::endl
                       << "Retrieved calibrated camera matrix:" << std::endl;
             std::cout << camera_matrix << std::endl;                                   // Print retrieved camera matrix
             std::cout << "Distortion coefficients: " << dist_coefficient << std::endl; // Print distortion coefficients
+            if (loaded && !was_posing && (DispAxes || DispObject || canvas))
+            {
+                startDriftMonitor(drift, core.target.points, camera_matrix, dist_coefficient, frame.size()); // Watch the calibration once an AR mode is switched on
+            }
         }
 
         // Press 't' to place image canvas on target
         else if (key == 't' && found)
         {
+            bool was_posing = DispAxes || DispObject || canvas; // An AR mode was already on, watched against the same calibration
             canvas = !canvas; // Toggle canvas transformation
             if (DispAxes)
             {
@@ -252,24 +418,49 @@ int main(int argc, char *argv[])
 
             // Read calibration to transform target
             std::string fileName = "circlegrid.csv";                    // File containing calibration data
-            readCalibration(fileName, camera_matrix, dist_coefficient); // Read calibration data from file
+            bool loaded = readCalibration(fileName, camera_matrix, dist_coefficient, calib_size) == 0; // Read calibration data from file
+            rescaleIntrinsics(camera_matrix, calib_size, frame.size());                                // Match the calibration to the stream resolution
             std::cout << std::endl
                       << "Retrieved calibrated camera matrix:" << std::endl;
             std::cout << camera_matrix << std::endl;                                   // Print retrieved camera matrix
             std::cout << "Distortion coefficients: " << dist_coefficient << std::endl; // Print distortion coefficients
+            if (loaded && !was_posing && (DispAxes || DispObject || canvas))
+            {
+                startDriftMonitor(drift, core.target.points, camera_matrix, dist_coefficient, frame.size()); // Watch the calibration once an AR mode is switched on
+            }
+        }
+
+        // Press 'k' to adopt the intrinsics proposed by the drift monitor and save them in place of the loaded calibration
+        else if (key == 'k' && takeDriftProposal(drift, camera_matrix, dist_coefficient))
+        {
+            saveCalibration("circlegrid.csv", camera_matrix, dist_coefficient, frame.size()); // Replace the drifted calibration
+            std::cout << std::endl
+                      << "Adopted camera matrix:" << std::endl;
+            std::cout << camera_matrix << std::endl;                                   // Print adopted camera matrix
+            std::cout << "Distortion coefficients: " << dist_coefficient << std::endl; // Print distortion coefficients
         }
 
         // Press 'p' to take a snapshot of the current frame
         else if (key == 'p')
         {
-            printf("Saving image\n");                  // Print message indicating image saving
-            std::string fname = "frame-";              // File name prefix
-            fname += std::to_string(frameNo) + ".jpg"; // Append frame number to file name
-            imwrite(fname, output);                    // Save the current frame as an image
-            frameNo++;                                 // Increment frame number
+            printf("Saving image\n");                                          // Print message indicating image saving
+            queueSnapshot(writer, "frame-" + std::to_string(frameNo), output); // Save the current frame from the writer thread
+            frameNo++;                                                         // Increment frame number
         }
     }
 
-    delete capdev; // Delete the video capture device object
-    return (0);    // Return 0 to indicate successful execution
+    stopPoseLog(poses);         // Write out the queued poses and close the pose stream
+    shmClosePublisher(shm);     // Remove the shared-memory ring
+    stopRecording(recorder);    // Close the recorded session
+    closeReplay(replay);        // Unmap the replayed session
+    closeViewStore(view_store); // Flush the calibration views to views_file
+    stopFrameWriter(writer);    // Write out the queued snapshots and close the output video
+    stopPreview(preview);       // Disconnect the preview clients and close the port
+    stopDriftMonitor(drift);    // Stop the drift monitor and print what it measured
+    if (overlays.renders > 0)
+    {
+        printf("Overlays: %d tiles rendered, %d reused, %d shifted\n", overlays.renders, overlays.reuses, overlays.shifts);
+    }
+    delete capdev;              // Delete the video capture device object
+    return (0);                 // Return 0 to indicate successful execution
 }
@@ -0,0 +1,230 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+main() CPP function for calibration and AR with ChArUco boards. Boards are found from any part that is visible,
+so a hand over some squares no longer drops the overlay, and every board in view gets its own pose.
+
+Usage: main_charuco [device] [boards] [calibration.csv] [--size=WxH] [--print]
+*/
+
+#include <iostream>
+
+// OpenCV headers
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+// User-defined headers
+#include "charuco.h"
+#include "core.h"
+#include "resolution.h"
+
+// Main function
+int main(int argc, char *argv[])
+{
+    std::string device = "/dev/video1";          // Video device
+    int board_count = 1;                         // Number of printed boards
+    std::string calib_file = "charuco_data.csv"; // Calibration read for AR and written by 'c'
+    cv::Size capture_size(960, 540);             // Requested capture resolution, e.g. --size=1280x720
+    bool print_boards = false;                   // Write the board images for printing and exit
+
+    int positional = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--size=", 0) == 0)
+        {
+            sscanf(arg.c_str(), "--size=%dx%d", &capture_size.width, &capture_size.height);
+        }
+        else if (arg == "--print")
+        {
+            print_boards = true;
+        }
+        else if (positional == 0)
+        {
+            device = arg;
+            positional++;
+        }
+        else if (positional == 1)
+        {
+            board_count = std::max(1, atoi(arg.c_str()));
+            positional++;
+        }
+        else
+        {
+            calib_file = arg;
+        }
+    }
+
+    CharucoBoardSet boards;
+    initCharucoBoards(boards, board_count);
+
+    if (print_boards)
+    {
+        for (int k = 0; k < (int)boards.boards.size(); k++)
+        {
+            cv::Mat image;
+            renderCharucoBoard(boards, k, image);
+            std::string fname = "charuco-board-" + std::to_string(k) + ".png";
+            cv::imwrite(fname, image);
+            printf("Wrote %s\n", fname.c_str());
+        }
+        return (0);
+    }
+
+    // Open the video device
+    cv::VideoCapture capdev(device);
+    if (!capdev.isOpened())
+    {
+        printf("Unable to open video device\n");
+        return (-1);
+    }
+
+    // Set properties of the image
+    capdev.set(cv::CAP_PROP_FRAME_WIDTH, capture_size.width);
+    capdev.set(cv::CAP_PROP_FRAME_HEIGHT, capture_size.height);
+    cv::Size refS((int)capdev.get(cv::CAP_PROP_FRAME_WIDTH),
+                  (int)capdev.get(cv::CAP_PROP_FRAME_HEIGHT));
+    printf("Expected size: %d %d\n", refS.width, refS.height);
+
+    // Create a window to display video
+    cv::namedWindow("Video", 1);
+
+    // Initialize variables
+    cv::Mat frame, gray; // Matrices to hold each frame and its grayscale version
+    cv::Mat output;      // Output image
+    int frameNo = 1;     // Frame number
+    int frameCal = 1;    // Calibration frame number
+
+    std::vector<std::vector<cv::Vec3f>> points_list;    // List to store points
+    std::vector<std::vector<cv::Point2f>> corners_list; // List to store corners
+
+    // Camera matrix initialization
+    double cammat[] = {1, 0, (double)refS.width / 2, 0, 1, (double)refS.height / 2, 0, 0, 1};
+    cv::Mat camera_matrix(cv::Size(3, 3), CV_64FC1, &cammat);
+    cv::Mat dist_coefficient; // Distortion coefficients
+    cv::Mat no_camera;        // Passed to the detector when no pose is needed
+    bool drawCorners = true;  // Boolean flag for drawing detections
+    bool DispAxes = false;    // Boolean flag for displaying axes
+    bool DispObject = false;  // Boolean flag for displaying object
+    TargetModel model = makeTargetModel(TARGET_CHESSBOARD); // Axes and virtual objects drawn on every board
+
+    // Start live feed from the video device
+    while (true)
+    {
+        capdev >> frame; // Get a new frame from the camera, treat as a stream
+        if (frame.empty())
+        {
+            printf("frame is empty\n");
+            break;
+        }
+        output = frame.clone();
+
+        // Find the visible part of every board; poses are only solved in the AR modes
+        std::vector<CharucoView> views;
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+        bool ar = DispAxes || DispObject;
+        detectCharucoBoards(boards, gray, ar ? camera_matrix : no_camera, dist_coefficient, views);
+
+        if (drawCorners)
+        {
+            drawCharucoViews(output, views);
+        }
+
+        // Draw on every board that has a pose, however much of it is covered
+        for (auto &view : views)
+        {
+            if (DispAxes && view.posed)
+            {
+                draw3dAxes(output, model, camera_matrix, dist_coefficient, view.rot, view.trans);
+            }
+            if (DispObject && view.posed)
+            {
+                draw3dObject(output, model, camera_matrix, dist_coefficient, view.rot, view.trans);
+            }
+        }
+
+        // Display the current frame
+        cv::imshow("Video", output);
+
+        // Check if there is a waiting keystroke
+        char key = cv::waitKey(10);
+
+        // Press 'q' to quit
+        if (key == 'q')
+        {
+            break;
+        }
+
+        // Press 's' to save the visible boards as calibration views and perform calibration if views >= 5
+        else if (key == 's' && !views.empty() && !ar)
+        {
+            for (auto &view : views)
+            {
+                points_list.push_back(view.points);
+                corners_list.push_back(view.corners);
+                std::cout << "Calibration view " << points_list.size() << ": board " << view.board << ", " << view.ids.size() << " corners" << std::endl;
+            }
+
+            printf("Saving calibration image...\n");
+            cv::imwrite("charuco-calibration-frame-" + std::to_string(frameCal) + ".jpg", output);
+
+            // Require at least 5 views for calibration
+            if (points_list.size() >= 5)
+            {
+                std::cout << "Performing calibration with " << points_list.size() << " views..." << std::endl;
+                float reprojErr = calibrateCharuco(points_list, corners_list, frame.size(), camera_matrix, dist_coefficient);
+
+                // Print the calibration stats for the user
+                std::cout << "Calibrated camera matrix:" << std::endl;
+                std::cout << camera_matrix << std::endl;
+                std::cout << "Re-projection error: " << reprojErr << std::endl;
+                std::cout << "Distortion coefficients: " << dist_coefficient << std::endl;
+            }
+
+            frameCal++;
+        }
+
+        // Press 'c' to save current calibration in a csv file to be read later
+        else if (key == 'c' && points_list.size() >= 5)
+        {
+            std::cout << std::endl
+                      << "Saving performed calibration..." << std::endl;
+            saveCalibration(calib_file, camera_matrix, dist_coefficient, frame.size()); // Replaces the file, so x and o load this calibration
+        }
+
+        // Press 'x' to display 3D axes on every board, or 'o' to display 3D objects
+        else if (key == 'x' || key == 'o')
+        {
+            DispAxes = key == 'x' ? !DispAxes : false;
+            DispObject = key == 'o' ? !DispObject : false;
+            drawCorners = !(DispAxes || DispObject);
+
+            // Read calibration unless one was just performed in this session
+            if ((DispAxes || DispObject) && points_list.size() < 5)
+            {
+                cv::Size calib_size;
+                readCalibration(calib_file, camera_matrix, dist_coefficient, calib_size);
+                rescaleIntrinsics(camera_matrix, calib_size, frame.size());
+                std::cout << std::endl
+                          << "Retrieved calibrated camera matrix:" << std::endl;
+                std::cout << camera_matrix << std::endl;
+                std::cout << "Distortion coefficients: " << dist_coefficient << std::endl;
+            }
+        }
+
+        // Press 'p' to take a snapshot of the current frame
+        else if (key == 'p')
+        {
+            printf("Saving image\n");
+            cv::imwrite("charuco-frame-" + std::to_string(frameNo) + ".jpg", output);
+            frameNo++;
+        }
+    }
+
+    return (0);
+}
@@ -0,0 +1,201 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+main() CPP function for calibrating a stereo rig from two synchronised video streams and displaying rectified pairs and disparity.
+
+Usage: main_stereo [left_device] [right_device] [chessboard|circles] [left_calibration.csv] [right_calibration.csv]
+*/
+
+#include <iostream>
+
+// OpenCV headers
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+// User-defined headers
+#include "stereo.h"
+#include "core.h"
+#include "resolution.h"
+
+// Main function
+int main(int argc, char *argv[])
+{
+    std::string left_device = argc > 1 ? argv[1] : "/dev/video1";    // Device of the left camera
+    std::string right_device = argc > 2 ? argv[2] : "/dev/video2";   // Device of the right camera
+    std::string target_name = argc > 3 ? argv[3] : "chessboard";     // Calibration target
+    std::string left_calib = argc > 4 ? argv[4] : "left_data.csv";   // Saved intrinsics of the left camera
+    std::string right_calib = argc > 5 ? argv[5] : "right_data.csv"; // Saved intrinsics of the right camera
+    StereoTarget target = target_name == "circles" ? STEREO_CIRCLEGRID : STEREO_CHESSBOARD;
+
+    // Open both video devices
+    cv::VideoCapture capdev[2] = {cv::VideoCapture(left_device), cv::VideoCapture(right_device)};
+    if (!capdev[0].isOpened() || !capdev[1].isOpened())
+    {
+        printf("Unable to open video devices\n");
+        return (-1);
+    }
+
+    // Set properties of the image
+    for (int i = 0; i < 2; i++)
+    {
+        capdev[i].set(cv::CAP_PROP_FRAME_WIDTH, 960);
+        capdev[i].set(cv::CAP_PROP_FRAME_HEIGHT, 540);
+    }
+    cv::Size refS((int)capdev[0].get(cv::CAP_PROP_FRAME_WIDTH),
+                  (int)capdev[0].get(cv::CAP_PROP_FRAME_HEIGHT));
+    printf("Expected size: %d %d\n", refS.width, refS.height);
+
+    // Seed the rig with the intrinsics saved by the single camera calibration, rescaled to the stream resolution
+    StereoRig rig;
+    std::string calib_files[2] = {left_calib, right_calib};
+    for (int i = 0; i < 2; i++)
+    {
+        cv::Size calib_size;
+        rig.camera_matrix[i] = cv::Mat::eye(3, 3, CV_64FC1);
+        if (readCalibration(calib_files[i], rig.camera_matrix[i], rig.dist_coeff[i], calib_size) != 0)
+        {
+            // The stereo calibration refines the seeded intrinsics, so an identity matrix would not converge
+            printf("Unable to read the %s camera calibration from %s; calibrate the camera with main or main_ar first\n", i == 0 ? "left" : "right",
+                   calib_files[i].c_str());
+            return (-1);
+        }
+        rescaleIntrinsics(rig.camera_matrix[i], calib_size, refS);
+    }
+
+    // Create a window to display video
+    cv::namedWindow("Video", 1);
+
+    // Initialize variables
+    cv::Mat frame[2];  // Matrices to hold each frame pair
+    cv::Mat output[2]; // Output images
+    cv::Mat display;   // Side by side view shown in the window
+    int frameCal = 1;  // Calibration frame number
+
+    std::vector<std::vector<cv::Vec3f>> points_list;  // List to store points
+    std::vector<std::vector<cv::Point2f>> left_list;  // List to store left corners
+    std::vector<std::vector<cv::Point2f>> right_list; // List to store right corners
+
+    bool drawCorners = true;    // Boolean flag for drawing detections
+    bool DispRectify = false;   // Boolean flag for displaying rectified pairs
+    bool DispDisparity = false; // Boolean flag for displaying the disparity map
+
+    // Start live feed from both video devices
+    while (true)
+    {
+        // Grab both frames first and decode afterwards so that the pair is captured as close together as possible
+        if (!capdev[0].grab() || !capdev[1].grab())
+        {
+            printf("frame is empty\n");
+            break;
+        }
+        capdev[0].retrieve(frame[0]);
+        capdev[1].retrieve(frame[1]);
+        if (frame[0].empty() || frame[1].empty())
+        {
+            printf("frame is empty\n");
+            break;
+        }
+
+        std::vector<cv::Point2f> left_corners, right_corners; // Vectors to store detected corners
+        bool found = false;
+
+        if (DispRectify || DispDisparity)
+        {
+            // Rectify the pair with the precomputed remap tables
+            rectifyPair(rig, frame[0], frame[1], output[0], output[1]);
+
+            if (DispRectify)
+            {
+                // Draw horizontal epipolar lines to check the row alignment
+                cv::hconcat(output[0], output[1], display);
+                for (int y = 0; y < display.rows; y += 40)
+                {
+                    cv::line(display, cv::Point(0, y), cv::Point(display.cols, y), cv::Scalar(0, 255, 0), 1);
+                }
+            }
+            else
+            {
+                cv::Mat disparity, disparity_8u;
+                computeDisparity(output[0], output[1], disparity, 96, 15);
+                disparity.convertTo(disparity_8u, CV_8U, 255.0 / (96 * 16.0));
+                cv::applyColorMap(disparity_8u, display, cv::COLORMAP_JET);
+            }
+        }
+        else
+        {
+            // Extract corners from both frames
+            found = stereoExtractCorners(frame[0], frame[1], output[0], output[1], left_corners, right_corners, target, drawCorners);
+            cv::hconcat(output[0], output[1], display);
+        }
+
+        // Display the current frame pair
+        cv::imshow("Video", display);
+
+        // Check if there is a waiting keystroke
+        char key = cv::waitKey(10);
+
+        // Press 'q' to quit
+        if (key == 'q')
+        {
+            break;
+        }
+
+        // Press 's' to save the current pair and perform stereo calibration if pairs >= 5
+        else if (key == 's' && found)
+        {
+            std::vector<cv::Vec3f> points;
+            stereoTargetPoints(target, points);
+            points_list.push_back(points);
+            left_list.push_back(left_corners);
+            right_list.push_back(right_corners);
+
+            printf("Saving calibration pair...\n");
+            cv::imwrite("stereo-left-" + std::to_string(frameCal) + ".jpg", output[0]);
+            cv::imwrite("stereo-right-" + std::to_string(frameCal) + ".jpg", output[1]);
+
+            // Require at least 5 pairs for calibration
+            if (frameCal >= 5)
+            {
+                std::cout << "Performing stereo calibration with " << frameCal << " pairs..." << std::endl;
+                float reprojErr = stereoCalibrateRig(points_list, left_list, right_list, frame[0].size(), rig);
+                stereoRectifyRig(rig);
+
+                // Print the calibration stats for the user
+                std::cout << "Rotation between cameras: " << rig.R << std::endl;
+                std::cout << "Translation between cameras: " << rig.T << std::endl;
+                std::cout << "Re-projection error: " << reprojErr << std::endl;
+            }
+
+            frameCal++;
+        }
+
+        // Press 'c' to save current stereo calibration in a csv file
+        else if (key == 'c' && rig.rectified)
+        {
+            std::cout << std::endl
+                      << "Saving performed stereo calibration..." << std::endl;
+            saveStereoCalibration(rig, "stereo_data.csv");
+        }
+
+        // Press 'r' to toggle the rectified pair view
+        else if (key == 'r' && rig.rectified)
+        {
+            DispRectify = !DispRectify;
+            DispDisparity = false;
+        }
+
+        // Press 'd' to toggle the disparity view
+        else if (key == 'd' && rig.rectified)
+        {
+            DispDisparity = !DispDisparity;
+            DispRectify = false;
+        }
+    }
+
+    return (0);
+}
@@ -0,0 +1,357 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for compositing the AR overlays into per-layer tiles that are only re-rendered when their projection changes.
+*/
+
+#include "overlay.h"
+
+/*
+ Given a frame or tile, line segments, their projected end points and the position of the frame or tile,
+ this function draws the segments. Points are rounded the same way whatever the offset, so a tile matches drawing on the frame.
+ */
+static int drawProjectedSegments(cv::Mat &dst, const std::vector<OverlaySegment> &segments, const std::vector<cv::Point2f> &projected, cv::Point2f offset, double alpha)
+{
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        const OverlaySegment &segment = segments[i];
+        cv::Scalar color(segment.color[0], segment.color[1], segment.color[2], alpha);
+        cv::Point2f from = projected[2 * i] - offset;
+        cv::Point2f to = projected[2 * i + 1] - offset;
+        if (segment.arrow)
+        {
+            cv::arrowedLine(dst, from, to, color, segment.thickness);
+        }
+        else
+        {
+            cv::line(dst, from, to, color, segment.thickness);
+        }
+    }
+
+    return (0);
+}
+
+/*
+ Given projected points, a margin, the frame size and a flag, this function returns the box around the points grown by the margin,
+ clipped to the frame, and sets the flag when the clipping cut the box. Points far outside the frame, as projected from behind the camera, are clamped first.
+ */
+static cv::Rect projectedBounds(std::vector<cv::Point2f> &projected, int margin, cv::Size frame_size, bool &clipped)
+{
+    std::vector<cv::Point> points;
+    for (auto &point : projected)
+    {
+        points.push_back(cv::Point(cvRound(std::max(-1e6f, std::min(1e6f, point.x))), cvRound(std::max(-1e6f, std::min(1e6f, point.y)))));
+    }
+    cv::Rect bounds = cv::boundingRect(points);
+    bounds = cv::Rect(bounds.x - margin, bounds.y - margin, bounds.width + 2 * margin, bounds.height + 2 * margin);
+
+    cv::Rect visible = bounds & cv::Rect(0, 0, frame_size.width, frame_size.height);
+    clipped = visible != bounds;
+
+    return (visible);
+}
+
+/*
+ Given a line layer, this function renders its segments into a tile covering their bounding box.
+ */
+static int renderLineTile(OverlayLayer &layer)
+{
+    // Lines spread by their thickness and arrow heads by a tenth of the arrow's length
+    int margin = 2;
+    for (size_t i = 0; i < layer.segments.size(); i++)
+    {
+        OverlaySegment &segment = layer.segments[i];
+        cv::Point2f span = layer.projected[2 * i + 1] - layer.projected[2 * i];
+        double tip = segment.arrow ? 0.1 * std::min(1e6, (double)cv::norm(span)) : 0.0;
+        margin = std::max(margin, segment.thickness + 2 + (int)ceil(tip));
+    }
+
+    layer.rect = projectedBounds(layer.projected, margin, layer.frame_size, layer.clipped);
+    if (layer.rect.empty())
+    {
+        layer.tile.release();
+        return (0);
+    }
+    layer.tile.create(layer.rect.size(), CV_8UC4);
+    layer.tile.setTo(cv::Scalar::all(0));
+    drawProjectedSegments(layer.tile, layer.segments, layer.projected, cv::Point2f((float)layer.rect.x, (float)layer.rect.y), 255);
+
+    return (0);
+}
+
+/*
+ Given an image layer, this function warps its image into a tile covering the projected quad, with alpha set inside the quad.
+ Only the pixels of the tile are warped, and the buffers of the previous render are reused when the size allows.
+ */
+static int renderImageTile(OverlayLayer &layer)
+{
+    layer.rect = projectedBounds(layer.projected, 1, layer.frame_size, layer.clipped);
+    if (layer.rect.empty() || layer.artwork.empty())
+    {
+        layer.tile.release();
+        return (0);
+    }
+
+    // Centres of the image's corner pixels, mapped to the quad relative to the tile
+    cv::Point2f offset((float)layer.rect.x, (float)layer.rect.y);
+    float right = (float)(layer.artwork.cols - 1), bottom = (float)(layer.artwork.rows - 1);
+    cv::Point2f inputQuad[4] = {cv::Point2f(0, 0), cv::Point2f(right, 0), cv::Point2f(right, bottom), cv::Point2f(0, bottom)};
+    cv::Point2f outputQuad[4];
+    std::vector<cv::Point> polygon;
+    for (int i = 0; i < 4; i++)
+    {
+        outputQuad[i] = layer.projected[i] - offset;
+        polygon.push_back(outputQuad[i]);
+    }
+
+    cv::Mat lambda = cv::getPerspectiveTransform(inputQuad, outputQuad);
+    cv::warpPerspective(layer.artwork, layer.warped, lambda, layer.rect.size());
+
+    layer.mask.create(layer.rect.size(), CV_8UC1);
+    layer.mask.setTo(cv::Scalar(0));
+    std::vector<std::vector<cv::Point>> pts{polygon};
+    cv::fillPoly(layer.mask, pts, cv::Scalar(255));
+
+    // Interleave the warped colours and the mask into the BGRA tile in one pass
+    layer.tile.create(layer.rect.size(), CV_8UC4);
+    cv::Mat sources[] = {layer.warped, layer.mask};
+    int from_to[] = {0, 0, 1, 1, 2, 2, 3, 3};
+    cv::mixChannels(sources, 2, &layer.tile, 1, from_to, 4);
+
+    return (0);
+}
+
+/*
+ Given a layer and its new projection, this function returns whether the cached tile would come out the same.
+ Line tiles are drawn from rounded points, so they only depend on the pixel each end point falls on;
+ image tiles are kept while no corner has moved by more than the layer's tolerance.
+ */
+static bool sameProjection(OverlayLayer &layer, std::vector<cv::Point2f> &projected)
+{
+    if (layer.projected.size() != projected.size())
+    {
+        return (false);
+    }
+    for (size_t i = 0; i < projected.size(); i++)
+    {
+        cv::Point2f &old_point = layer.projected[i];
+        bool same = layer.kind == OVERLAY_LINES ? cvRound(old_point.x) == cvRound(projected[i].x) && cvRound(old_point.y) == cvRound(projected[i].y)
+                                                : cv::norm(projected[i] - old_point) <= layer.tolerance;
+        if (!same)
+        {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+/*
+ Given a layer, its new projection and a point, this function returns whether the new projection is the cached one
+ moved by a whole number of pixels, and sets the point to that movement. The tile can then be moved instead of re-rendered,
+ as happens when the camera pans without turning.
+ */
+static bool shiftedProjection(OverlayLayer &layer, std::vector<cv::Point2f> &projected, cv::Point &shift)
+{
+    if (layer.projected.size() != projected.size() || projected.empty() || layer.clipped)
+    {
+        return (false);
+    }
+
+    shift = cv::Point(cvRound(projected[0].x) - cvRound(layer.projected[0].x), cvRound(projected[0].y) - cvRound(layer.projected[0].y));
+    for (size_t i = 0; i < projected.size(); i++)
+    {
+        cv::Point2f &old_point = layer.projected[i];
+        bool same = layer.kind == OVERLAY_LINES ? cvRound(old_point.x) + shift.x == cvRound(projected[i].x) && cvRound(old_point.y) + shift.y == cvRound(projected[i].y)
+                                                : cv::norm(projected[i] - (old_point + cv::Point2f((float)shift.x, (float)shift.y))) <= layer.tolerance;
+        if (!same)
+        {
+            return (false);
+        }
+    }
+
+    // The whole tile must still fit in the frame
+    cv::Rect moved = layer.rect + shift;
+
+    return ((moved & cv::Rect(0, 0, layer.frame_size.width, layer.frame_size.height)) == moved);
+}
+
+/*
+ Given a frame, line segments, calibrated camera matrix, distortion coefficients, rotation and translation data,
+ this function projects the segments and draws them straight onto the frame.
+ */
+int drawOverlaySegments(cv::Mat &dst, const std::vector<OverlaySegment> &segments, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff, const cv::Mat &rot, const cv::Mat &trans)
+{
+    std::vector<cv::Vec3f> points;
+    for (const auto &segment : segments)
+    {
+        points.push_back(segment.from);
+        points.push_back(segment.to);
+    }
+
+    std::vector<cv::Point2f> projected;
+    cv::projectPoints(points, rot, trans, camera_matrix, dist_coeff, projected);
+    drawProjectedSegments(dst, segments, projected, cv::Point2f(0, 0), 0);
+
+    return (0);
+}
+
+/*
+ Given the compositor and line segments, this function adds a hidden line layer on top and returns its index.
+ */
+int addLineLayer(OverlayCompositor &compositor, const std::vector<OverlaySegment> &segments)
+{
+    OverlayLayer layer;
+    layer.kind = OVERLAY_LINES;
+    layer.segments = segments;
+    for (const auto &segment : segments)
+    {
+        layer.vertices.push_back(segment.from);
+        layer.vertices.push_back(segment.to);
+    }
+    compositor.layers.push_back(layer);
+
+    return ((int)compositor.layers.size() - 1);
+}
+
+/*
+ Given the compositor, a BGR image and the world quad its corners map to (top left, top right, bottom right, bottom left),
+ this function adds a hidden image layer on top and returns its index.
+ */
+int addImageLayer(OverlayCompositor &compositor, const cv::Mat &artwork, const std::vector<cv::Vec3f> &quad)
+{
+    OverlayLayer layer;
+    layer.kind = OVERLAY_IMAGE;
+    layer.artwork = artwork;
+    layer.vertices = quad;
+    compositor.layers.push_back(layer);
+
+    return ((int)compositor.layers.size() - 1);
+}
+
+/*
+ Given the compositor, the frame size, calibrated camera matrix, distortion coefficients, rotation and translation data,
+ this function projects every visible layer and re-renders the tiles whose projection changed.
+ A line tile is reused until an end point moves to another pixel, and an image tile until a corner moves by more than
+ the layer's tolerance. A projection that only moved by whole pixels moves the tile instead of re-rendering it.
+ */
+int updateOverlays(OverlayCompositor &compositor, cv::Size frame_size, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff, const cv::Mat &rot, const cv::Mat &trans)
+{
+    for (auto &layer : compositor.layers)
+    {
+        if (!layer.visible)
+        {
+            continue;
+        }
+
+        std::vector<cv::Point2f> projected;
+        cv::projectPoints(layer.vertices, rot, trans, camera_matrix, dist_coeff, projected);
+        if (layer.frame_size == frame_size && sameProjection(layer, projected))
+        {
+            compositor.reuses++;
+            continue;
+        }
+
+        // The cached projection moves with the tile, so the tolerance keeps comparing against what is on screen
+        cv::Point shift;
+        if (layer.frame_size == frame_size && shiftedProjection(layer, projected, shift))
+        {
+            layer.rect = layer.rect + shift;
+            for (auto &point : layer.projected)
+            {
+                point += cv::Point2f((float)shift.x, (float)shift.y);
+            }
+            compositor.shifts++;
+            continue;
+        }
+
+        layer.projected = projected;
+        layer.frame_size = frame_size;
+        if (layer.kind == OVERLAY_LINES)
+        {
+            renderLineTile(layer);
+        }
+        else
+        {
+            renderImageTile(layer);
+        }
+        compositor.renders++;
+    }
+
+    return (0);
+}
+
+/*
+ Given the compositor and the frame, this function blends the tile of every visible layer onto the frame, in layer order.
+ Each pixel covered by a tile is read and written once, with the layers above it blended in turn, so overlapping tiles
+ cost no extra pass over the frame. Only the pixels inside the tiles are touched.
+ */
+int compositeOverlays(OverlayCompositor &compositor, cv::Mat &dst)
+{
+    CV_Assert(dst.type() == CV_8UC3);
+
+    // Layers with a tile for this frame, bottom first
+    compositor.active.clear();
+    cv::Rect bounds;
+    for (auto &layer : compositor.layers)
+    {
+        if (layer.visible && !layer.tile.empty() && layer.frame_size == dst.size())
+        {
+            compositor.active.push_back(&layer);
+            bounds = bounds.empty() ? layer.rect : bounds | layer.rect;
+        }
+    }
+
+    for (int y = bounds.y; y < bounds.y + bounds.height; y++)
+    {
+        // Span of the tiles crossing this row
+        int x0 = INT_MAX, x1 = INT_MIN;
+        for (const OverlayLayer *layer : compositor.active)
+        {
+            if (y >= layer->rect.y && y < layer->rect.y + layer->rect.height)
+            {
+                x0 = std::min(x0, layer->rect.x);
+                x1 = std::max(x1, layer->rect.x + layer->rect.width);
+            }
+        }
+
+        cv::Vec3b *out = dst.ptr<cv::Vec3b>(y);
+        for (int x = x0; x < x1; x++)
+        {
+            int b = out[x][0], g = out[x][1], r = out[x][2];
+            bool touched = false;
+            for (const OverlayLayer *layer : compositor.active)
+            {
+                if (!layer->rect.contains(cv::Point(x, y)))
+                {
+                    continue;
+                }
+                const cv::Vec4b &src = layer->tile.ptr<cv::Vec4b>(y - layer->rect.y)[x - layer->rect.x];
+                int alpha = src[3];
+                if (alpha == 255)
+                {
+                    b = src[0];
+                    g = src[1];
+                    r = src[2];
+                    touched = true;
+                }
+                else if (alpha > 0)
+                {
+                    b = (src[0] * alpha + b * (255 - alpha) + 127) / 255;
+                    g = (src[1] * alpha + g * (255 - alpha) + 127) / 255;
+                    r = (src[2] * alpha + r * (255 - alpha) + 127) / 255;
+                    touched = true;
+                }
+            }
+            if (touched)
+            {
+                out[x] = cv::Vec3b((uchar)b, (uchar)g, (uchar)r);
+            }
+        }
+    }
+
+    return (0);
+}
@@ -0,0 +1,105 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for compositing the AR overlays. Each overlay renders into its own small BGRA tile covering only its bounding box,
+the tile is re-rendered only when the overlay's projection changes shape, and the tiles are blended onto the camera frame inside their rectangles.
+*/
+
+#ifndef overlay_hpp
+#define overlay_hpp
+
+#include <stdio.h>
+#include <iostream>
+#include <climits>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/calib3d.hpp>
+
+/*
+ One straight line of a line overlay, in world coordinates.
+ */
+struct OverlaySegment
+{
+    cv::Vec3f from, to; // End points
+    cv::Scalar color;   // BGR colour
+    int thickness;      // Line thickness in pixels
+    bool arrow;         // Draw an arrow head at to
+};
+
+/*
+ Kinds of overlay.
+ */
+enum OverlayKind
+{
+    OVERLAY_LINES, // Projected line segments, such as the axes and the virtual objects
+    OVERLAY_IMAGE  // An image warped onto a world quad, such as the artwork replacing the target
+};
+
+/*
+ One overlay and its cached tile.
+ */
+struct OverlayLayer
+{
+    OverlayKind kind = OVERLAY_LINES;
+    bool visible = false;                 // Hidden layers are neither rendered nor composited
+    std::vector<OverlaySegment> segments; // Geometry of a line layer
+    std::vector<cv::Vec3f> vertices;      // World points projected each frame: segment end points, or the quad of an image layer
+    cv::Mat artwork;                      // Image of an image layer, its corners mapped to the quad in order
+    float tolerance = 0.25f;              // Largest movement of an image corner, in pixels, for which the tile is kept
+    std::vector<cv::Point2f> projected;   // Projection the tile was rendered from, moved with the tile when it is shifted
+    cv::Size frame_size;                  // Frame size the tile was rendered for
+    cv::Rect rect;                        // Position of the tile in the frame
+    bool clipped = false;                 // Whether the tile was cut at the frame edge, so shifting it would not show the rest
+    cv::Mat tile;                         // Rendered overlay (CV_8UC4), alpha 0 where the frame shows through
+    cv::Mat warped, mask;                 // Scratch buffers of an image layer, kept so re-rendering does not allocate
+};
+
+/*
+ The overlays of a frame, drawn in order, and how often their tiles were reused.
+ */
+struct OverlayCompositor
+{
+    std::vector<OverlayLayer> layers;   // Bottom layer first
+    int renders = 0;                    // Tiles rendered
+    int reuses = 0;                     // Tiles reused because the projection did not change
+    int shifts = 0;                     // Tiles moved whole because the projection only moved by whole pixels
+    std::vector<OverlayLayer *> active; // Layers composited this frame, kept so compositing does not allocate
+};
+
+/*
+ Given a frame, line segments, calibrated camera matrix, distortion coefficients, rotation and translation data,
+ this function projects the segments and draws them straight onto the frame.
+ */
+int drawOverlaySegments(cv::Mat &dst, const std::vector<OverlaySegment> &segments, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff, const cv::Mat &rot, const cv::Mat &trans);
+
+/*
+ Given the compositor and line segments, this function adds a hidden line layer on top and returns its index.
+ */
+int addLineLayer(OverlayCompositor &compositor, const std::vector<OverlaySegment> &segments);
+
+/*
+ Given the compositor, a BGR image and the world quad its corners map to (top left, top right, bottom right, bottom left),
+ this function adds a hidden image layer on top and returns its index.
+ */
+int addImageLayer(OverlayCompositor &compositor, const cv::Mat &artwork, const std::vector<cv::Vec3f> &quad);
+
+/*
+ Given the compositor, the frame size, calibrated camera matrix, distortion coefficients, rotation and translation data,
+ this function projects every visible layer and re-renders the tiles whose projection changed.
+ A line tile is reused until an end point moves to another pixel, and an image tile until a corner moves by more than
+ the layer's tolerance. A projection that only moved by whole pixels moves the tile instead of re-rendering it.
+ */
+int updateOverlays(OverlayCompositor &compositor, cv::Size frame_size, const cv::Mat &camera_matrix, const cv::Mat &dist_coeff, const cv::Mat &rot, const cv::Mat &trans);
+
+/*
+ Given the compositor and the frame, this function blends the tile of every visible layer onto the frame, in layer order.
+ Each pixel covered by a tile is read and written once, with the layers above it blended in turn, so overlapping tiles
+ cost no extra pass over the frame. Only the pixels inside the tiles are touched.
+ */
+int compositeOverlays(OverlayCompositor &compositor, cv::Mat &dst);
+
+#endif /* overlay_hpp */
@@ -0,0 +1,231 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for streaming timestamped camera poses out of the frame loop.
+Poses are pushed into a lock-free queue and a writer thread formats them into a binary log, a CSV file or UDP datagrams.
+*/
+
+#include <chrono>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+
+#include "poselog.h"
+
+/*
+ Given the logger and a pose record, this function writes the record to the logger's destination.
+ */
+static int writePose(PoseLogger &logger, PoseRecord &record)
+{
+    if (logger.sink == POSE_BINARY)
+    {
+        fwrite(&record, sizeof(PoseRecord), 1, logger.fp);
+    }
+    else if (logger.sink == POSE_CSV)
+    {
+        fprintf(logger.fp, "%.6f,%llu,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g\n", record.timestamp, (unsigned long long)record.sequence,
+                record.rot[0], record.rot[1], record.rot[2], record.trans[0], record.trans[1], record.trans[2]);
+    }
+    else if (logger.sink == POSE_UDP)
+    {
+        sendto(logger.sock, &record, sizeof(PoseRecord), 0, (struct sockaddr *)&logger.address, sizeof(logger.address));
+    }
+
+    return (0);
+}
+
+/*
+ Given the logger, this function writes out every pose currently in the queue and returns how many were written.
+ */
+static int drainPoses(PoseLogger &logger)
+{
+    uint64_t tail = logger.tail.load(std::memory_order_relaxed);
+    uint64_t head = logger.head.load(std::memory_order_acquire); // Slots before head are fully written
+    uint64_t mask = logger.ring.size() - 1;
+
+    for (uint64_t i = tail; i < head; i++)
+    {
+        writePose(logger, logger.ring[i & mask]);
+    }
+    logger.tail.store(head, std::memory_order_release); // Hand the slots back to the frame loop
+
+    return ((int)(head - tail));
+}
+
+/*
+ Given the logger, this function runs the writer thread: it drains the queue until the logger is stopped,
+ sleeping briefly whenever the queue is empty.
+ */
+static void writerLoop(PoseLogger *logger)
+{
+    while (logger->running.load(std::memory_order_acquire))
+    {
+        if (drainPoses(*logger) == 0)
+        {
+            if (logger->fp != NULL)
+            {
+                fflush(logger->fp); // Idle moments are a good time to make the log readable by other processes
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+
+    drainPoses(*logger); // Poses pushed before the stop request
+}
+
+/*
+ Given the logger and a destination, this function opens the destination and starts the writer thread.
+ The destination is udp:<host>:<port>, a path ending in .csv or any other path for the binary log.
+ An empty destination leaves the logger off. It returns 0 on success and -1 when the destination cannot be opened.
+ */
+int startPoseLog(PoseLogger &logger, std::string destination, int capacity)
+{
+    logger.sink = POSE_OFF;
+    if (destination.empty())
+    {
+        return (0);
+    }
+
+    if (destination.rfind("udp:", 0) == 0)
+    {
+        // udp:<host>:<port>
+        size_t colon = destination.rfind(':');
+        std::string host = destination.substr(4, colon - 4);
+        std::string port = destination.substr(colon + 1);
+
+        struct addrinfo hints, *result;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        if (colon <= 4 || getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0)
+        {
+            printf("Unable to resolve pose destination %s\n", destination.c_str());
+            return (-1);
+        }
+        memcpy(&logger.address, result->ai_addr, sizeof(logger.address));
+        freeaddrinfo(result);
+
+        logger.sock = socket(AF_INET, SOCK_DGRAM, 0);
+        if (logger.sock < 0)
+        {
+            printf("Unable to open a UDP socket for %s\n", destination.c_str());
+            return (-1);
+        }
+        logger.sink = POSE_UDP;
+    }
+    else
+    {
+        bool csv = destination.size() > 4 && destination.compare(destination.size() - 4, 4, ".csv") == 0;
+        logger.fp = fopen(destination.c_str(), csv ? "w" : "wb");
+        if (logger.fp == NULL)
+        {
+            printf("Unable to open %s for writing\n", destination.c_str());
+            return (-1);
+        }
+
+        if (csv)
+        {
+            fprintf(logger.fp, "timestamp,sequence,rx,ry,rz,tx,ty,tz\n");
+            logger.sink = POSE_CSV;
+        }
+        else
+        {
+            // Magic and record size so readers can check the layout before reading the records
+            uint32_t header[2] = {0x45534f50, (uint32_t)sizeof(PoseRecord)}; // "POSE"
+            fwrite(header, sizeof(header), 1, logger.fp);
+            logger.sink = POSE_BINARY;
+        }
+    }
+
+    // Round the capacity up to a power of two so slots can be found with a mask
+    size_t size = 1;
+    while (size < (size_t)capacity)
+    {
+        size <<= 1;
+    }
+    logger.ring.assign(size, PoseRecord());
+    logger.head = 0;
+    logger.tail = 0;
+    logger.dropped = 0;
+    logger.sequence = 0;
+
+    logger.running = true;
+    logger.writer = std::thread(writerLoop, &logger);
+
+    return (0);
+}
+
+/*
+ Given the logger and the current pose, this function stamps the pose and queues it for the writer thread.
+ It never blocks and returns -1 when the logger is off or the pose was dropped.
+ */
+int pushPose(PoseLogger &logger, cv::Mat &rot, cv::Mat &trans)
+{
+    if (logger.sink == POSE_OFF || rot.total() < 3 || trans.total() < 3)
+    {
+        return (-1);
+    }
+
+    uint64_t sequence = logger.sequence++;
+    uint64_t head = logger.head.load(std::memory_order_relaxed);
+    if (head - logger.tail.load(std::memory_order_acquire) >= logger.ring.size())
+    {
+        logger.dropped.fetch_add(1, std::memory_order_relaxed); // Writer is behind; never wait for it
+        return (-1);
+    }
+
+    PoseRecord &record = logger.ring[head & (logger.ring.size() - 1)];
+    record.timestamp = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    record.sequence = sequence;
+    for (int i = 0; i < 3; i++)
+    {
+        // solvePnP returns CV_64F vectors
+        record.rot[i] = rot.ptr<double>()[i];
+        record.trans[i] = trans.ptr<double>()[i];
+    }
+
+    logger.head.store(head + 1, std::memory_order_release); // Publish the slot to the writer thread
+
+    return (0);
+}
+
+/*
+ Given the logger, this function writes out the queued poses, stops the writer thread and closes the destination.
+ */
+int stopPoseLog(PoseLogger &logger)
+{
+    if (logger.sink == POSE_OFF)
+    {
+        return (0);
+    }
+
+    logger.running = false;
+    if (logger.writer.joinable())
+    {
+        logger.writer.join();
+    }
+
+    if (logger.dropped > 0)
+    {
+        printf("Pose log dropped %llu poses\n", (unsigned long long)logger.dropped.load());
+    }
+
+    if (logger.fp != NULL)
+    {
+        fclose(logger.fp);
+        logger.fp = NULL;
+    }
+    if (logger.sock >= 0)
+    {
+        close(logger.sock);
+        logger.sock = -1;
+    }
+    logger.sink = POSE_OFF;
+
+    return (0);
+}
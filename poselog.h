@@ -0,0 +1,85 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for streaming timestamped camera poses out of the frame loop.
+Poses are pushed into a lock-free queue and a writer thread formats them into a binary log, a CSV file or UDP datagrams.
+*/
+
+#ifndef poselog_hpp
+#define poselog_hpp
+
+#include <stdio.h>
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <netinet/in.h>
+
+#include <opencv2/core.hpp>
+
+/*
+ Destinations a pose stream can be written to.
+ */
+enum PoseSink
+{
+    POSE_OFF,    // Poses are discarded
+    POSE_BINARY, // Fixed size PoseRecord structs after a short file header
+    POSE_CSV,    // One text line per pose
+    POSE_UDP     // One PoseRecord per datagram to a local consumer
+};
+
+/*
+ One pose as written to the binary log and to UDP datagrams.
+ The timestamp is in seconds on the steady clock, rot is the Rodrigues rotation vector and trans the translation vector.
+ */
+struct PoseRecord
+{
+    double timestamp;
+    uint64_t sequence;
+    double rot[3];
+    double trans[3];
+};
+
+/*
+ Single-producer single-consumer queue between the frame loop and the writer thread.
+ The frame loop only copies six numbers into a slot; all formatting and I/O happen on the writer thread.
+ When the writer falls behind, new poses are dropped and counted instead of blocking the frame loop.
+ */
+struct PoseLogger
+{
+    PoseSink sink = POSE_OFF;
+    std::vector<PoseRecord> ring;           // Slots of the queue, a power of two in size
+    std::atomic<uint64_t> head{0};          // Next slot the frame loop writes
+    std::atomic<uint64_t> tail{0};          // Next slot the writer thread reads
+    std::atomic<bool> running{false};       // Cleared to stop the writer thread
+    std::atomic<uint64_t> dropped{0};       // Poses lost because the queue was full
+    uint64_t sequence = 0;                  // Number of poses pushed so far
+    std::thread writer;                     // Drains the queue
+    FILE *fp = NULL;                        // Output file of the binary and CSV sinks
+    int sock = -1;                          // Socket of the UDP sink
+    struct sockaddr_in address;             // Destination of the UDP sink
+};
+
+/*
+ Given the logger and a destination, this function opens the destination and starts the writer thread.
+ The destination is udp:<host>:<port>, a path ending in .csv or any other path for the binary log.
+ An empty destination leaves the logger off. It returns 0 on success and -1 when the destination cannot be opened.
+ */
+int startPoseLog(PoseLogger &logger, std::string destination, int capacity = 1024);
+
+/*
+ Given the logger and the current pose, this function stamps the pose and queues it for the writer thread.
+ It never blocks and returns -1 when the logger is off or the pose was dropped.
+ */
+int pushPose(PoseLogger &logger, cv::Mat &rot, cv::Mat &trans);
+
+/*
+ Given the logger, this function writes out the queued poses, stops the writer thread and closes the destination.
+ */
+int stopPoseLog(PoseLogger &logger);
+
+#endif /* poselog_hpp */
@@ -0,0 +1,112 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for a cheap board-presence test that runs on a thumbnail of the frame and lets the chessboard detector
+skip frames that have no board in view.
+*/
+
+#include <chrono>
+
+#include "prefilter.h"
+
+/*
+ Given the pre-filter and a frame, this function counts the saddle points of the frame's thumbnail:
+ local maxima of dxy^2 - dxx dyy, which is large where two dark and two light regions meet as at chessboard corners
+ and small on edges, blobs and flat areas. Intensities are normalised by the thumbnail's contrast first.
+ */
+int countSaddlePoints(BoardPrefilter &filter, const cv::Mat &src)
+{
+    // Shrink first so the colour conversion and everything after it run on the thumbnail only
+    int width = std::min(filter.thumb_width, src.cols);
+    int height = std::max(1, src.rows * width / src.cols);
+    cv::Mat small, gray;
+    cv::resize(src, small, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+    if (small.channels() == 3)
+    {
+        cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+    }
+    else
+    {
+        gray = small;
+    }
+
+    // Unit contrast, so the threshold does not depend on exposure
+    cv::Mat f;
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(gray, mean, stddev);
+    gray.convertTo(f, CV_32F, 1.0 / std::max(stddev[0], 2.0), -mean[0] / std::max(stddev[0], 2.0));
+
+    cv::Mat dxx, dyy, dxy;
+    cv::Sobel(f, dxx, CV_32F, 2, 0, 3);
+    cv::Sobel(f, dyy, CV_32F, 0, 2, 3);
+    cv::Sobel(f, dxy, CV_32F, 1, 1, 3);
+
+    // Saddle response, and its 3x3 maxima so each corner is counted once
+    cv::Mat response = dxy.mul(dxy) - dxx.mul(dyy);
+    cv::Mat peaks;
+    cv::dilate(response, peaks, cv::Mat());
+
+    int count = 0;
+    for (int y = 1; y < response.rows - 1; y++)
+    {
+        const float *r = response.ptr<float>(y);
+        const float *p = peaks.ptr<float>(y);
+        for (int x = 1; x < response.cols - 1; x++)
+        {
+            count += r[x] > filter.saddle_threshold && r[x] >= p[x];
+        }
+    }
+
+    return (count);
+}
+
+/*
+ Given the pre-filter and a frame, this function returns false when the frame almost certainly has no board in view,
+ so the full detector can be skipped. It always returns true when the pre-filter is disabled.
+ */
+bool boardLikely(BoardPrefilter &filter, const cv::Mat &src)
+{
+    if (!filter.enabled)
+    {
+        return (true);
+    }
+
+    // The board was just seen, or the filter has been rejecting for a while: let the detector decide
+    if (filter.since_found < filter.hold_frames || filter.rejected_run >= filter.recheck_interval)
+    {
+        filter.rejected_run = 0;
+        return (true);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool likely = countSaddlePoints(filter, src) >= filter.min_saddles;
+    filter.test_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    filter.frames++;
+
+    if (!likely)
+    {
+        filter.rejected++;
+        filter.rejected_run++;
+        filter.since_found++;
+    }
+    else
+    {
+        filter.rejected_run = 0;
+    }
+
+    return (likely);
+}
+
+/*
+ Given the pre-filter and whether the detector found the board in the last frame it ran on,
+ this function updates the state that lets frames right after a detection through untested.
+ */
+int updatePrefilter(BoardPrefilter &filter, bool found)
+{
+    filter.since_found = found ? 0 : std::min(filter.since_found + 1, 1 << 30);
+
+    return (0);
+}
@@ -0,0 +1,57 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for a cheap board-presence test that runs on a thumbnail of the frame and lets the chessboard detector
+skip frames that have no board in view.
+*/
+
+#ifndef prefilter_hpp
+#define prefilter_hpp
+
+#include <stdio.h>
+#include <iostream>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+/*
+ Settings and statistics of the pre-filter.
+ */
+struct BoardPrefilter
+{
+    bool enabled = false;         // Frames are only filtered when enabled
+    int thumb_width = 320;        // Width of the thumbnail the test runs on; squares must stay a few pixels wide in it
+    float saddle_threshold = 8.0; // Smallest saddle response, in units of the thumbnail's contrast; below it noise and edges count
+    int min_saddles = 40;         // Saddle points needed to call the frame a possible board (the 9x6 board shows 60 or more)
+    int hold_frames = 15;         // Frames after a detection that skip the test, since the board is most likely still there
+    int recheck_interval = 30;    // Every this many rejected frames one is passed anyway, bounding the cost of a false reject
+    int since_found = 1 << 30;    // Frames since the last detection
+    int rejected_run = 0;         // Consecutive rejected frames
+    int frames = 0;               // Frames tested
+    int rejected = 0;             // Frames rejected
+    double test_ms = 0.0;         // Total time spent in the test
+};
+
+/*
+ Given the pre-filter and a frame, this function counts the saddle points of the frame's thumbnail:
+ local maxima of dxy^2 - dxx dyy, which is large where two dark and two light regions meet as at chessboard corners
+ and small on edges, blobs and flat areas. Intensities are normalised by the thumbnail's contrast first.
+ */
+int countSaddlePoints(BoardPrefilter &filter, const cv::Mat &src);
+
+/*
+ Given the pre-filter and a frame, this function returns false when the frame almost certainly has no board in view,
+ so the full detector can be skipped. It always returns true when the pre-filter is disabled.
+ */
+bool boardLikely(BoardPrefilter &filter, const cv::Mat &src);
+
+/*
+ Given the pre-filter and whether the detector found the board in the last frame it ran on,
+ this function updates the state that lets frames right after a detection through untested.
+ */
+int updatePrefilter(BoardPrefilter &filter, bool found);
+
+#endif /* prefilter_hpp */
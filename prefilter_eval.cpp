@@ -0,0 +1,247 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+main() CPP function for tuning the board-presence pre-filter on sessions recorded with --record. Every frame is run
+through the full chessboard detector, which gives the truth, and through the pre-filter, and the tool reports how many
+board frames the pre-filter would have lost and how much detector time it would have saved on the empty ones.
+With --synth the footage is rendered instead: N labelled views of the chessboard from synth.cpp and N frames of
+random clutter with no board, so the rates can be measured without a recorded session.
+
+Usage: prefilter_eval session.rec|--synth[=N] [--threshold=T] [--width=W] [--min-saddles=N] [--sweep]
+*/
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+
+// OpenCV headers
+#include <opencv2/core.hpp>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+
+// User-defined headers
+#include "prefilter.h"
+#include "recorder.h"
+#include "board.h"
+#include "synth.h"
+
+/*
+ Given the saddle counts and detector results of every frame, the detector time of every frame and a minimum count,
+ this function prints the false-reject rate, the share of empty frames rejected and the detector time saved.
+ */
+static int reportThreshold(std::vector<int> &counts, std::vector<char> &found, std::vector<double> &detect_ms, int min_saddles)
+{
+    int boards = 0, empty = 0, lost = 0, skipped = 0;
+    double saved_ms = 0.0, total_ms = 0.0;
+    for (size_t i = 0; i < counts.size(); i++)
+    {
+        bool rejected = counts[i] < min_saddles;
+        boards += found[i];
+        empty += !found[i];
+        lost += found[i] && rejected;
+        skipped += !found[i] && rejected;
+        saved_ms += rejected ? detect_ms[i] : 0.0;
+        total_ms += detect_ms[i];
+    }
+
+    printf("min %3d saddles: lost %d of %d board frames (%.2f%%), rejected %d of %d empty frames (%.1f%%), saved %.1f%% of detector time\n",
+           min_saddles, lost, boards, boards ? 100.0 * lost / boards : 0.0, skipped, empty, empty ? 100.0 * skipped / empty : 0.0,
+           total_ms > 0.0 ? 100.0 * saved_ms / total_ms : 0.0);
+
+    return (0);
+}
+
+/*
+ Given the frame size, a random number generator and a BGR image, this function draws a frame with no board in it:
+ a lighting gradient under 40 random rectangles, rotated boxes, ellipses and lines of random grey, degraded like the
+ synthetic board views. Overlapping shapes give the pre-filter corners and junctions to reject that are not a chessboard.
+ */
+static int renderClutter(cv::Size size, cv::RNG &rng, cv::Mat &image)
+{
+    cv::Mat gray(size, CV_32F);
+    double base = rng.uniform(60.0, 200.0), slope = rng.uniform(-80.0, 80.0) / size.width;
+    for (int y = 0; y < size.height; y++)
+    {
+        float *row = gray.ptr<float>(y);
+        for (int x = 0; x < size.width; x++)
+        {
+            row[x] = (float)(base + slope * (x - size.width / 2));
+        }
+    }
+    gray.convertTo(image, CV_8U);
+    cv::cvtColor(image, image, cv::COLOR_GRAY2BGR);
+
+    for (int i = 0; i < 40; i++)
+    {
+        int grey = rng.uniform(0, 256);
+        cv::Scalar color(grey, grey, grey);
+        cv::Point2f centre((float)rng.uniform(0, size.width), (float)rng.uniform(0, size.height));
+        cv::Size2f extent((float)rng.uniform(10, size.width / 3), (float)rng.uniform(10, size.height / 3));
+        int shape = rng.uniform(0, 4);
+        if (shape == 0)
+        {
+            cv::rectangle(image, cv::Rect(cv::Point(centre), cv::Size(extent)), color, cv::FILLED);
+        }
+        else if (shape == 1)
+        {
+            cv::Point2f box[4];
+            cv::RotatedRect(centre, extent, (float)rng.uniform(0.0, 180.0)).points(box);
+            std::vector<cv::Point> polygon(box, box + 4);
+            cv::fillConvexPoly(image, polygon, color, cv::LINE_AA);
+        }
+        else if (shape == 2)
+        {
+            cv::ellipse(image, cv::RotatedRect(centre, extent, (float)rng.uniform(0.0, 180.0)), color, cv::FILLED, cv::LINE_AA);
+        }
+        else
+        {
+            cv::Point2f end = centre + cv::Point2f(extent.width, extent.height) * (rng.uniform(0, 2) ? 1.0f : -1.0f);
+            cv::line(image, centre, end, color, rng.uniform(1, 8), cv::LINE_AA);
+        }
+    }
+
+    cv::GaussianBlur(image, image, cv::Size(), 1.0);
+    cv::Mat noisy, noise(size, CV_32FC3);
+    image.convertTo(noisy, CV_32FC3);
+    rng.fill(noise, cv::RNG::NORMAL, 0.0, 3.0);
+    noisy += noise;
+    noisy.convertTo(image, CV_8UC3);
+
+    return (0);
+}
+
+/*
+ Given the pre-filter, a frame, whether it shows the board (or -1 to take the detector's answer) and the per-frame results,
+ this function runs the frame through the detector and the pre-filter and appends the truth, the saddle count and the detector time.
+ */
+static int measureFrame(BoardPrefilter &filter, cv::Mat &frame, int board, std::vector<int> &counts, std::vector<char> &found,
+                        std::vector<double> &detect_ms, double &test_ms)
+{
+    std::vector<cv::Point2f> corners;
+    auto start = std::chrono::steady_clock::now();
+    bool detected = cv::findChessboardCorners(frame, Chessboard9x6::size(), corners);
+    auto mid = std::chrono::steady_clock::now();
+    counts.push_back(countSaddlePoints(filter, frame));
+    auto end = std::chrono::steady_clock::now();
+
+    found.push_back(board < 0 ? detected : board > 0);
+    detect_ms.push_back(std::chrono::duration<double, std::milli>(mid - start).count());
+    test_ms += std::chrono::duration<double, std::milli>(end - mid).count();
+
+    return (0);
+}
+
+// Main function
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("Usage: prefilter_eval session.rec|--synth[=N] [--threshold=T] [--width=W] [--min-saddles=N] [--sweep]\n");
+        return (-1);
+    }
+
+    BoardPrefilter filter;
+    bool sweep = false;
+    for (int i = 2; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--threshold=", 0) == 0)
+        {
+            filter.saddle_threshold = atof(arg.c_str() + 12);
+        }
+        else if (arg.rfind("--width=", 0) == 0)
+        {
+            filter.thumb_width = atoi(arg.c_str() + 8);
+        }
+        else if (arg.rfind("--min-saddles=", 0) == 0)
+        {
+            filter.min_saddles = atoi(arg.c_str() + 14);
+        }
+        else if (arg == "--sweep")
+        {
+            sweep = true;
+        }
+    }
+
+    std::vector<int> counts;
+    std::vector<char> found;
+    std::vector<double> detect_ms;
+    double test_ms = 0.0;
+    std::string source = argv[1];
+    if (source.rfind("--synth", 0) == 0)
+    {
+        // Board views with the degradations of a handheld webcam, then as many frames without a board
+        int count = source.size() > 8 ? atoi(source.c_str() + 8) : 500;
+        SynthParams params;
+        params.blur_sigma = 1.0;
+        params.noise_sigma = 3.0;
+        params.gradient = 0.3;
+        std::vector<SynthSample> samples;
+        generateSynthDataset(STEREO_CHESSBOARD, params, count, 1, samples);
+        for (auto &sample : samples)
+        {
+            measureFrame(filter, sample.image, 1, counts, found, detect_ms, test_ms);
+        }
+
+        cv::RNG rng(2);
+        cv::Mat frame;
+        for (int i = 0; i < count; i++)
+        {
+            renderClutter(params.image_size, rng, frame);
+            measureFrame(filter, frame, 0, counts, found, detect_ms, test_ms);
+        }
+    }
+    else
+    {
+        // Frames are read as fast as possible, keys are ignored
+        SessionReplay replay;
+        if (openReplay(replay, source, false) != 0)
+        {
+            return (-1);
+        }
+
+        cv::Mat frame;
+        int key;
+        while (replayFrame(replay, frame, key))
+        {
+            if (!frame.empty())
+            {
+                measureFrame(filter, frame, -1, counts, found, detect_ms, test_ms);
+            }
+        }
+        closeReplay(replay);
+    }
+    int max_count = counts.empty() ? 0 : *std::max_element(counts.begin(), counts.end());
+
+    if (counts.empty())
+    {
+        printf("No frames in %s\n", source.c_str());
+        return (-1);
+    }
+
+    double detect_total = 0.0;
+    for (double ms : detect_ms)
+    {
+        detect_total += ms;
+    }
+    printf("%zu frames, detector %.3f ms per frame, pre-filter %.3f ms per frame (thumbnail %d px, threshold %.2f)\n", counts.size(),
+           detect_total / counts.size(), test_ms / counts.size(), filter.thumb_width, filter.saddle_threshold);
+
+    if (sweep)
+    {
+        // The counts do not depend on the minimum, so one pass over the session covers every candidate
+        for (int min_saddles = 4; min_saddles <= std::min(max_count + 4, 80); min_saddles += 4)
+        {
+            reportThreshold(counts, found, detect_ms, min_saddles);
+        }
+    }
+    else
+    {
+        reportThreshold(counts, found, detect_ms, filter.min_saddles);
+    }
+
+    return (0);
+}
@@ -0,0 +1,550 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for serving the composited stream as MJPEG over HTTP on localhost, in place of the highgui window.
+*/
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <algorithm>
+#include <random>
+#include <string.h>
+#include <strings.h>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "preview.h"
+
+/*
+ Given the server, this function builds the page served at /: the stream, and a button posting each key the frontend listed.
+ Every key command carries the token of this run, which pages from other origins cannot read.
+ */
+static std::string previewPage(PreviewServer &server)
+{
+    std::string page = "<!DOCTYPE html><html><head><title>Calibration preview</title></head><body style=\"background:#222;color:#ddd;font-family:sans-serif\">"
+                       "<script>function key(k){fetch('/key?k='+encodeURIComponent(k)+'&t=" +
+                       server.token + "',{method:'POST'});}</script>"
+                       "<img src=\"/stream\" style=\"max-width:100%\"><p>";
+    for (const auto &button : server.buttons)
+    {
+        page += std::string("<button onclick=\"key('") + button.first + "')\">" + button.first + ": " + button.second + "</button> ";
+    }
+    page += "</p></body></html>";
+
+    return (page);
+}
+
+/*
+ Given the server and a command line argument, this function applies the argument when it is one of the preview's options
+ (--preview[=PORT], --preview-width=, --preview-fps=, --preview-quality=) and returns true, or returns false for any other argument.
+ */
+bool parsePreviewArg(PreviewServer &server, std::string arg)
+{
+    if (arg == "--preview")
+    {
+        server.port = 8080;
+    }
+    else if (arg.rfind("--preview=", 0) == 0)
+    {
+        server.port = std::max(0, std::min(65535, atoi(arg.c_str() + 10)));
+    }
+    else if (arg.rfind("--preview-width=", 0) == 0)
+    {
+        server.width = std::max(16, atoi(arg.c_str() + 16));
+    }
+    else if (arg.rfind("--preview-fps=", 0) == 0)
+    {
+        server.fps = std::max(0.1, atof(arg.c_str() + 14));
+    }
+    else if (arg.rfind("--preview-quality=", 0) == 0)
+    {
+        server.quality = std::max(0, std::min(100, atoi(arg.c_str() + 18)));
+    }
+    else
+    {
+        return (false);
+    }
+
+    return (true);
+}
+
+/*
+ Given a socket and a buffer, this function sends the whole buffer and returns false once the client has gone.
+ */
+static bool sendAll(int fd, const void *data, size_t size)
+{
+    const char *bytes = (const char *)data;
+    while (size > 0)
+    {
+        ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            return (false);
+        }
+        bytes += sent;
+        size -= sent;
+    }
+
+    return (true);
+}
+
+/*
+ Given a socket, a status line, a content type and a body, this function sends a complete HTTP response.
+ */
+static bool sendResponse(int fd, const char *status, const char *type, const void *body, size_t size)
+{
+    char head[256];
+    int length = snprintf(head, sizeof(head), "HTTP/1.0 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nCache-Control: no-cache\r\nConnection: close\r\n\r\n",
+                          status, type, size);
+
+    return (sendAll(fd, head, length) && sendAll(fd, body, size));
+}
+
+/*
+ Given the server and a client socket, this function sends every new JPEG as one part of a multipart response
+ until the client disconnects or the server stops. Clients that fall behind skip to the latest frame.
+ */
+static int streamFrames(PreviewServer *server, int fd)
+{
+    const char *head = "HTTP/1.0 200 OK\r\nContent-Type: multipart/x-mixed-replace; boundary=frame\r\nCache-Control: no-cache\r\nConnection: close\r\n\r\n";
+    if (!sendAll(fd, head, strlen(head)))
+    {
+        return (-1);
+    }
+
+    uint64_t seen = 0;
+    while (true)
+    {
+        std::shared_ptr<std::vector<uchar>> jpeg;
+        {
+            std::unique_lock<std::mutex> guard(server->lock);
+            server->jpeg_ready.wait(guard, [&] { return !server->running || server->sequence != seen; });
+            if (!server->running)
+            {
+                break;
+            }
+            jpeg = server->jpeg;
+            seen = server->sequence;
+        }
+
+        // The JPEG is shared and immutable, so it is sent without holding the lock
+        char part[128];
+        int length = snprintf(part, sizeof(part), "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %zu\r\n\r\n", jpeg->size());
+        if (!sendAll(fd, part, length) || !sendAll(fd, jpeg->data(), jpeg->size()) || !sendAll(fd, "\r\n", 2))
+        {
+            break;
+        }
+    }
+
+    return (0);
+}
+
+/*
+ Given the query string of a request and a parameter name, this function returns the parameter's value,
+ decoding %XX escapes, or an empty string when the parameter is absent.
+ */
+static std::string queryValue(const std::string &query, const std::string &name)
+{
+    size_t pos = 0;
+    while (pos < query.size())
+    {
+        size_t end = query.find('&', pos);
+        end = end == std::string::npos ? query.size() : end;
+        if (query.compare(pos, name.size() + 1, name + "=") == 0)
+        {
+            std::string value;
+            for (size_t i = pos + name.size() + 1; i < end; i++)
+            {
+                if (query[i] == '%' && i + 2 < end)
+                {
+                    value += (char)strtol(query.substr(i + 1, 2).c_str(), NULL, 16);
+                    i += 2;
+                }
+                else
+                {
+                    value += query[i] == '+' ? ' ' : query[i];
+                }
+            }
+            return (value);
+        }
+        pos = end + 1;
+    }
+
+    return ("");
+}
+
+/*
+ Given a request head and a header name, this function returns the header's value with surrounding spaces removed,
+ or an empty string when the header is absent. Header names are matched without regard to case.
+ */
+static std::string requestHeader(const std::string &request, const std::string &name)
+{
+    size_t line = request.find("\r\n");
+    while (line != std::string::npos && line + 2 < request.size())
+    {
+        size_t start = line + 2;
+        size_t end = request.find("\r\n", start);
+        end = end == std::string::npos ? request.size() : end;
+        if (end - start > name.size() && request[start + name.size()] == ':' && strncasecmp(request.c_str() + start, name.c_str(), name.size()) == 0)
+        {
+            size_t first = request.find_first_not_of(' ', start + name.size() + 1);
+            size_t last = request.find_last_not_of(' ', end - 1);
+            return (first == std::string::npos || first > last ? "" : request.substr(first, last - first + 1));
+        }
+        line = end;
+    }
+
+    return ("");
+}
+
+/*
+ Given the server and a request head, this function returns whether the request comes from a page of the preview itself:
+ the Host must name the loopback address and port the preview is bound to, which defeats DNS rebinding,
+ and an Origin, when the browser sends one, must be the preview's own.
+ */
+static bool sameOrigin(PreviewServer *server, const std::string &request)
+{
+    std::string port = std::to_string(server->port);
+    std::string host = requestHeader(request, "Host");
+    if (host != "127.0.0.1:" + port && host != "localhost:" + port)
+    {
+        return (false);
+    }
+    std::string origin = requestHeader(request, "Origin");
+
+    return (origin.empty() || origin == "http://" + host);
+}
+
+/*
+ Given the server and a client socket, this function reads one request and answers it:
+ GET / serves the page, GET /stream the MJPEG stream, GET /snapshot.jpg the latest frame,
+ and POST /key?k=<key>&t=<token> queues a key command. Requests from other origins are refused.
+ The socket is closed when the client thread finishes.
+ */
+static void serveClient(PreviewServer *server, int fd)
+{
+    // Read the request head; the request line, Host and Origin are used
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192)
+    {
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+        {
+            break;
+        }
+        request.append(buffer, received);
+    }
+
+    std::string method = request.substr(0, request.find(' '));
+    std::string path, query;
+    size_t start = request.find(' ');
+    if (start != std::string::npos)
+    {
+        std::string target = request.substr(start + 1, request.find(' ', start + 1) - start - 1);
+        size_t mark = target.find('?');
+        path = target.substr(0, mark);
+        query = mark == std::string::npos ? "" : target.substr(mark + 1);
+    }
+
+    if (!sameOrigin(server, request))
+    {
+        sendResponse(fd, "403 Forbidden", "text/plain", "Forbidden\n", 10);
+    }
+    else if (method == "GET" && (path == "/" || path == "/index.html"))
+    {
+        std::string page = previewPage(*server);
+        sendResponse(fd, "200 OK", "text/html", page.data(), page.size());
+    }
+    else if (method == "GET" && path == "/stream")
+    {
+        streamFrames(server, fd);
+    }
+    else if (method == "GET" && path == "/snapshot.jpg")
+    {
+        std::shared_ptr<std::vector<uchar>> jpeg;
+        {
+            std::lock_guard<std::mutex> guard(server->lock);
+            jpeg = server->jpeg;
+        }
+        if (jpeg)
+        {
+            sendResponse(fd, "200 OK", "image/jpeg", jpeg->data(), jpeg->size());
+        }
+        else
+        {
+            sendResponse(fd, "503 Service Unavailable", "text/plain", "No frame yet\n", 13);
+        }
+    }
+    else if (path == "/key")
+    {
+        // Key commands change state, so they must be posted with the token of this run
+        std::string key = queryValue(query, "k");
+        if (method != "POST")
+        {
+            sendResponse(fd, "405 Method Not Allowed", "text/plain", "Use POST\n", 9);
+        }
+        else if (queryValue(query, "t") != server->token)
+        {
+            sendResponse(fd, "403 Forbidden", "text/plain", "Forbidden\n", 10);
+        }
+        else if (key.size() != 1)
+        {
+            sendResponse(fd, "400 Bad Request", "text/plain", "Bad key\n", 8);
+        }
+        else
+        {
+            {
+                std::lock_guard<std::mutex> guard(server->lock);
+                server->keys.push_back((unsigned char)key[0]);
+            }
+            sendResponse(fd, "200 OK", "text/plain", "OK\n", 3);
+        }
+    }
+    else
+    {
+        sendResponse(fd, "404 Not Found", "text/plain", "Not found\n", 10);
+    }
+
+    // Closing under the lock keeps stopPreview from shutting down a descriptor that was reused
+    std::lock_guard<std::mutex> guard(server->lock);
+    server->client_fds.erase(std::remove(server->client_fds.begin(), server->client_fds.end(), fd), server->client_fds.end());
+    close(fd);
+    server->active--;
+    server->idle.notify_all();
+}
+
+/*
+ Given the server, this function accepts connections until the listening socket is shut down, serving each on its own thread.
+ Connections above max_clients are answered with 503 and closed. Failed accepts back off instead of spinning,
+ since errors such as running out of descriptors persist until a client goes away.
+ */
+static int acceptClients(PreviewServer *server)
+{
+    int backoff_ms = 0;
+    while (true)
+    {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        int error = errno;
+        std::unique_lock<std::mutex> guard(server->lock);
+        if (!server->running)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            break;
+        }
+        if (fd < 0)
+        {
+            if (error == EINTR || error == ECONNABORTED)
+            {
+                continue;
+            }
+            // Wait before retrying, longer each time, unless the server stops meanwhile
+            backoff_ms = std::min(1000, std::max(10, 2 * backoff_ms));
+            server->idle.wait_for(guard, std::chrono::milliseconds(backoff_ms), [&] { return !server->running; });
+            continue;
+        }
+        backoff_ms = 0;
+
+        if (server->active >= server->max_clients)
+        {
+            server->refused++;
+            guard.unlock();
+            sendResponse(fd, "503 Service Unavailable", "text/plain", "Too many clients\n", 17);
+            close(fd);
+            continue;
+        }
+        server->client_fds.push_back(fd);
+        server->active++;
+        server->connections++;
+        std::thread(serveClient, server, fd).detach();
+    }
+
+    return (0);
+}
+
+/*
+ Given the server, this function encodes each frame handed over by the frame loop, scaled to the preview width,
+ and publishes it to the clients. Frames handed over while it encodes replace each other, so only the newest is encoded.
+ */
+static int encodeFrames(PreviewServer *server)
+{
+    cv::Mat frame, scaled;
+    std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, server->quality};
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> guard(server->lock);
+            server->pending_ready.wait(guard, [&] { return !server->running || server->has_pending; });
+            if (!server->running)
+            {
+                break;
+            }
+            // Swapping hands the previous buffer back to the frame loop, so neither side allocates per frame
+            std::swap(frame, server->pending);
+            server->has_pending = false;
+        }
+
+        if (frame.cols > server->width)
+        {
+            cv::resize(frame, scaled, cv::Size(server->width, cvRound((double)frame.rows * server->width / frame.cols)), 0, 0, cv::INTER_AREA);
+        }
+        else
+        {
+            scaled = frame;
+        }
+        auto jpeg = std::make_shared<std::vector<uchar>>();
+        cv::imencode(".jpg", scaled, *jpeg, params);
+
+        {
+            std::lock_guard<std::mutex> guard(server->lock);
+            server->jpeg = jpeg;
+            server->sequence++;
+        }
+        server->jpeg_ready.notify_all();
+    }
+
+    return (0);
+}
+
+/*
+ Given the server, this function binds its port on 127.0.0.1 and starts the encoder and acceptor threads.
+ It returns 0 on success, and -1 when the preview is off or the port cannot be bound.
+ */
+int startPreview(PreviewServer &server)
+{
+    if (server.port <= 0)
+    {
+        return (-1);
+    }
+
+    server.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server.listen_fd < 0)
+    {
+        printf("Unable to open the preview socket\n");
+        return (-1);
+    }
+    int reuse = 1;
+    setsockopt(server.listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    // Only local clients are served
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(server.port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(server.listen_fd, (sockaddr *)&address, sizeof(address)) != 0 || listen(server.listen_fd, 8) != 0)
+    {
+        printf("Unable to serve the preview on port %d\n", server.port);
+        close(server.listen_fd);
+        server.listen_fd = -1;
+        return (-1);
+    }
+
+    // Key commands need this token, which only the page served by this run carries
+    std::random_device random;
+    char token[33];
+    snprintf(token, sizeof(token), "%08x%08x%08x%08x", random(), random(), random(), random());
+    server.token = token;
+
+    server.running = true;
+    server.last_frame = std::chrono::steady_clock::time_point();
+    server.encoder = std::thread(encodeFrames, &server);
+    server.acceptor = std::thread(acceptClients, &server);
+    printf("Preview at http://127.0.0.1:%d/ (%d px wide, %.0f fps)\n", server.port, server.width, server.fps);
+
+    return (0);
+}
+
+/*
+ Given the server and the composited output frame, this function hands the frame to the encoder when the preview rate allows.
+ It only copies the frame and never waits for the encoder or the clients.
+ */
+int publishPreview(PreviewServer &server, cv::Mat &frame)
+{
+    if (!server.running || frame.empty())
+    {
+        return (-1);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - server.last_frame < std::chrono::duration<double>(1.0 / server.fps))
+    {
+        server.skipped++;
+        return (0);
+    }
+    server.last_frame = now;
+
+    {
+        std::lock_guard<std::mutex> guard(server.lock);
+        frame.copyTo(server.pending);
+        server.has_pending = true;
+    }
+    server.pending_ready.notify_one();
+
+    return (0);
+}
+
+/*
+ Given the server, this function returns the oldest key command received over HTTP, or -1 when there is none.
+ */
+int previewKey(PreviewServer &server)
+{
+    std::lock_guard<std::mutex> guard(server.lock);
+    if (server.keys.empty())
+    {
+        return (-1);
+    }
+    int key = server.keys.front();
+    server.keys.pop_front();
+
+    return (key);
+}
+
+/*
+ Given the server, this function disconnects the clients, stops every thread and closes the port.
+ */
+int stopPreview(PreviewServer &server)
+{
+    if (!server.running)
+    {
+        return (0);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(server.lock);
+        server.running = false;
+        for (int fd : server.client_fds)
+        {
+            shutdown(fd, SHUT_RDWR);
+        }
+    }
+    server.pending_ready.notify_all();
+    server.jpeg_ready.notify_all();
+    server.idle.notify_all(); // Wakes the acceptor from a backoff
+
+    // Shutting the listening socket down wakes the acceptor from accept
+    shutdown(server.listen_fd, SHUT_RDWR);
+    server.acceptor.join();
+    server.encoder.join();
+    {
+        std::unique_lock<std::mutex> guard(server.lock);
+        server.idle.wait(guard, [&] { return server.active == 0; });
+    }
+    close(server.listen_fd);
+    server.listen_fd = -1;
+
+    printf("Preview: %llu frames encoded, %d skipped by the preview rate, %d connections, %d refused\n", (unsigned long long)server.sequence,
+           server.skipped, server.connections, server.refused);
+
+    return (0);
+}
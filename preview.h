@@ -0,0 +1,91 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for serving the composited stream as MJPEG over HTTP on localhost, in place of the highgui window.
+Frames are encoded on a separate thread at their own resolution and rate, and key commands are accepted on the same endpoint.
+*/
+
+#ifndef preview_hpp
+#define preview_hpp
+
+#include <stdio.h>
+#include <iostream>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+/*
+ State of the preview server. The frame loop hands frames to the encoder through a single slot, so it never waits for it;
+ the encoder publishes the latest JPEG, which every connected client thread sends as soon as it changes.
+ */
+struct PreviewServer
+{
+    int port = 0;                                          // Port on 127.0.0.1, 0 when the preview is off, e.g. --preview=8080
+    int width = 640;                                       // Width of the preview frames, e.g. --preview-width=960
+    double fps = 15.0;                                     // Largest rate frames are encoded at, e.g. --preview-fps=10
+    int quality = 80;                                      // JPEG quality, e.g. --preview-quality=70
+    int max_clients = 8;                                   // Connections served at once; more are refused
+    std::vector<std::pair<char, std::string>> buttons;     // Keys offered on the page with their labels, set by each frontend from its bindings
+
+    int listen_fd = -1;                                    // Listening socket
+    std::string token;                                     // Random per-run token every key command must carry
+    bool running = false;                                  // Cleared to stop every thread
+    std::thread acceptor;                                  // Accepts connections and starts a detached thread per client, up to max_clients
+    std::thread encoder;                                   // Encodes the pending frame
+    std::vector<int> client_fds;                           // Sockets of the open connections, shut down on stop
+    int active = 0;                                        // Client threads still running
+    std::condition_variable idle;                          // Signalled when a client thread finishes or the server stops
+    std::mutex lock;                                       // Guards everything below
+    std::condition_variable pending_ready;                 // Signalled when a frame is handed over or the server stops
+    std::condition_variable jpeg_ready;                    // Signalled when a new JPEG is published or the server stops
+    cv::Mat pending;                                       // Frame waiting for the encoder
+    bool has_pending = false;                              // Whether pending holds a frame not yet encoded
+    std::shared_ptr<std::vector<uchar>> jpeg;              // Latest encoded frame
+    uint64_t sequence = 0;                                 // Number of frames encoded
+    std::deque<int> keys;                                  // Key commands received and not yet read by the frame loop
+    std::chrono::steady_clock::time_point last_frame;      // Time the last frame was handed to the encoder
+    int skipped = 0;                                       // Frames not handed over because of the preview rate
+    int connections = 0;                                   // Connections served
+    int refused = 0;                                       // Connections refused because max_clients were open
+};
+
+/*
+ Given the server and a command line argument, this function applies the argument when it is one of the preview's options
+ (--preview[=PORT], --preview-width=, --preview-fps=, --preview-quality=) and returns true, or returns false for any other argument.
+ */
+bool parsePreviewArg(PreviewServer &server, std::string arg);
+
+/*
+ Given the server, this function binds its port on 127.0.0.1 and starts the encoder and acceptor threads.
+ It returns 0 on success, and -1 when the preview is off or the port cannot be bound.
+ */
+int startPreview(PreviewServer &server);
+
+/*
+ Given the server and the composited output frame, this function hands the frame to the encoder when the preview rate allows.
+ It only copies the frame and never waits for the encoder or the clients.
+ */
+int publishPreview(PreviewServer &server, cv::Mat &frame);
+
+/*
+ Given the server, this function returns the oldest key command received over HTTP, or -1 when there is none.
+ */
+int previewKey(PreviewServer &server);
+
+/*
+ Given the server, this function disconnects the clients, stops every thread and closes the port.
+ */
+int stopPreview(PreviewServer &server);
+
+#endif /* preview_hpp */
@@ -0,0 +1,278 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for recording capture sessions (frames, timestamps and keypresses) into a chunked container
+and replaying them through the detection pipeline at the recorded or maximum speed.
+*/
+
+#include <thread>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "recorder.h"
+
+/*
+ Given a payload size, this function returns the size rounded up to the 8-byte chunk alignment.
+ */
+static uint64_t padded(uint64_t size)
+{
+    return ((size + 7) & ~(uint64_t)7);
+}
+
+/*
+ Given the recorder, a chunk header and its payload, this function appends the chunk and its padding to the session file.
+ */
+static int writeChunk(SessionRecorder &recorder, ChunkHeader &header, const void *payload)
+{
+    static const unsigned char zeros[8] = {0};
+
+    fwrite(&header, sizeof(ChunkHeader), 1, recorder.fp);
+    if (header.size > 0)
+    {
+        fwrite(payload, 1, header.size, recorder.fp);
+    }
+    fwrite(zeros, 1, padded(header.size) - header.size, recorder.fp);
+
+    return (0);
+}
+
+/*
+ Given the recorder, a file name and the frame encoding, this function creates the session file.
+ It returns -1 when the file cannot be created.
+ */
+int startRecording(SessionRecorder &recorder, std::string filename, FrameEncoding encoding)
+{
+    recorder.fp = fopen(filename.c_str(), "wb");
+    if (recorder.fp == NULL)
+    {
+        printf("Unable to open %s for writing\n", filename.c_str());
+        return (-1);
+    }
+
+    uint32_t header[2] = {SESSION_MAGIC, SESSION_VERSION};
+    fwrite(header, sizeof(header), 1, recorder.fp);
+    recorder.encoding = encoding;
+    recorder.frames = 0;
+    recorder.start = std::chrono::steady_clock::now();
+
+    return (0);
+}
+
+/*
+ Given the recorder and a captured frame, this function appends the frame with its timestamp to the session.
+ */
+int recordFrame(SessionRecorder &recorder, cv::Mat &frame)
+{
+    if (recorder.fp == NULL || frame.empty())
+    {
+        return (-1);
+    }
+
+    ChunkHeader header = {};
+    header.type = CHUNK_FRAME;
+    header.encoding = recorder.encoding;
+    header.timestamp = std::chrono::duration<double>(std::chrono::steady_clock::now() - recorder.start).count();
+    header.rows = frame.rows;
+    header.cols = frame.cols;
+    header.mat_type = frame.type();
+    header.key = -1;
+
+    recorder.frames++;
+    if (recorder.encoding == ENCODE_PNG)
+    {
+        // Fastest compression level; PNG is lossless at every level
+        std::vector<unsigned char> png;
+        std::vector<int> params = {cv::IMWRITE_PNG_COMPRESSION, 1};
+        cv::imencode(".png", frame, png, params);
+        header.size = png.size();
+        writeChunk(recorder, header, png.data());
+    }
+    else
+    {
+        cv::Mat pixels = frame.isContinuous() ? frame : frame.clone();
+        header.size = pixels.total() * pixels.elemSize();
+        writeChunk(recorder, header, pixels.data);
+    }
+
+    return (0);
+}
+
+/*
+ Given the recorder and the key returned by cv::waitKey for the last frame, this function appends the key to the session.
+ Frames without a keypress (-1) are not recorded.
+ */
+int recordKey(SessionRecorder &recorder, int key)
+{
+    if (recorder.fp == NULL || key < 0)
+    {
+        return (-1);
+    }
+
+    ChunkHeader header = {};
+    header.type = CHUNK_KEY;
+    header.timestamp = std::chrono::duration<double>(std::chrono::steady_clock::now() - recorder.start).count();
+    header.key = key;
+    writeChunk(recorder, header, NULL);
+
+    return (0);
+}
+
+/*
+ Given the recorder, this function closes the session file.
+ */
+int stopRecording(SessionRecorder &recorder)
+{
+    if (recorder.fp == NULL)
+    {
+        return (0);
+    }
+
+    fclose(recorder.fp);
+    recorder.fp = NULL;
+    printf("Recorded %d frames\n", recorder.frames);
+
+    return (0);
+}
+
+/*
+ Given the replay state, a file name and whether to pace frames by the recorded timestamps,
+ this function maps the session file and indexes its frames and keys.
+ A torn last chunk, left by a recording that was not closed cleanly, is ignored.
+ It returns -1 when the file is missing or not a session.
+ */
+int openReplay(SessionReplay &replay, std::string filename, bool realtime)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || (size_t)info.st_size < 2 * sizeof(uint32_t))
+    {
+        printf("Unable to open session %s\n", filename.c_str());
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return (-1);
+    }
+
+    replay.size = info.st_size;
+    void *base = mmap(NULL, replay.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid without the descriptor
+    if (base == MAP_FAILED || ((uint32_t *)base)[0] != SESSION_MAGIC || ((uint32_t *)base)[1] != SESSION_VERSION)
+    {
+        printf("%s is not a session recording\n", filename.c_str());
+        if (base != MAP_FAILED)
+        {
+            munmap(base, replay.size);
+        }
+        return (-1);
+    }
+    replay.base = (unsigned char *)base;
+    madvise(replay.base, replay.size, MADV_SEQUENTIAL);
+
+    // Walk the chunk headers once to index the frames and pair every frame with the key pressed after it
+    replay.frame_offsets.clear();
+    replay.keys.clear();
+    uint64_t offset = 2 * sizeof(uint32_t);
+    while (offset + sizeof(ChunkHeader) <= replay.size)
+    {
+        ChunkHeader *header = (ChunkHeader *)(replay.base + offset);
+        if (offset + sizeof(ChunkHeader) + header->size > replay.size)
+        {
+            break;
+        }
+
+        if (header->type == CHUNK_FRAME)
+        {
+            replay.frame_offsets.push_back(offset);
+            replay.keys.push_back(-1);
+        }
+        else if (header->type == CHUNK_KEY && !replay.keys.empty())
+        {
+            replay.keys.back() = header->key;
+        }
+        offset += sizeof(ChunkHeader) + padded(header->size);
+    }
+
+    replay.next = 0;
+    replay.realtime = realtime;
+    printf("Replaying %d frames from %s\n", (int)replay.frame_offsets.size(), filename.c_str());
+
+    return (0);
+}
+
+/*
+ Given the replay state, this function decodes the next frame into frame, waiting for its recorded time when pacing,
+ and populates key with the key recorded after it. It returns false at the end of the session.
+ */
+bool replayFrame(SessionReplay &replay, cv::Mat &frame, int &key)
+{
+    if (replay.base == NULL || replay.next >= (int)replay.frame_offsets.size())
+    {
+        return (false);
+    }
+
+    ChunkHeader *header = (ChunkHeader *)(replay.base + replay.frame_offsets[replay.next]);
+    unsigned char *payload = (unsigned char *)(header + 1);
+
+    if (header->encoding == ENCODE_PNG)
+    {
+        cv::Mat encoded(1, (int)header->size, CV_8U, payload);
+        frame = cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
+    }
+    else
+    {
+        // Copy out of the mapping so the frame can be drawn on
+        cv::Mat(header->rows, header->cols, header->mat_type, payload).copyTo(frame);
+    }
+
+    if (replay.next == 0)
+    {
+        replay.start = std::chrono::steady_clock::now() - std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(header->timestamp));
+    }
+    else if (replay.realtime)
+    {
+        std::this_thread::sleep_until(replay.start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(header->timestamp)));
+    }
+
+    key = replay.keys[replay.next];
+    replay.next++;
+
+    return (true);
+}
+
+/*
+ Given the replay state, this function returns the size of the recorded frames.
+ */
+cv::Size replayFrameSize(SessionReplay &replay)
+{
+    if (replay.frame_offsets.empty())
+    {
+        return (cv::Size(0, 0));
+    }
+
+    ChunkHeader *header = (ChunkHeader *)(replay.base + replay.frame_offsets[0]);
+
+    return (cv::Size(header->cols, header->rows));
+}
+
+/*
+ Given the replay state, this function unmaps the session file.
+ */
+int closeReplay(SessionReplay &replay)
+{
+    if (replay.base != NULL)
+    {
+        munmap(replay.base, replay.size);
+        replay.base = NULL;
+    }
+
+    return (0);
+}
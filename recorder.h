@@ -0,0 +1,127 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for recording capture sessions (frames, timestamps and keypresses) into a chunked container
+and replaying them through the detection pipeline at the recorded or maximum speed.
+*/
+
+#ifndef recorder_hpp
+#define recorder_hpp
+
+#include <stdio.h>
+#include <iostream>
+#include <chrono>
+#include <stdint.h>
+
+#include <opencv2/core.hpp>
+
+#define SESSION_MAGIC 0x43455243 // "CREC"
+#define SESSION_VERSION 1
+
+/*
+ Kinds of chunk in a session file.
+ */
+enum ChunkType
+{
+    CHUNK_FRAME = 1, // A captured frame
+    CHUNK_KEY = 2    // The key returned by cv::waitKey after the previous frame
+};
+
+/*
+ Encodings of the frame payload. Both reproduce the captured pixels exactly.
+ */
+enum FrameEncoding
+{
+    ENCODE_RAW = 0, // Pixels as stored in the cv::Mat
+    ENCODE_PNG = 1  // Lossless PNG
+};
+
+/*
+ Header in front of every chunk. Chunks start on 8-byte boundaries so the mapped file can be read in place.
+ */
+struct ChunkHeader
+{
+    uint32_t type;      // ChunkType
+    uint32_t encoding;  // FrameEncoding of a frame payload
+    uint64_t size;      // Payload bytes following the header, excluding padding
+    double timestamp;   // Seconds since the start of the recording
+    int32_t rows, cols; // Size of a frame
+    int32_t mat_type;   // cv::Mat type of a frame
+    int32_t key;        // Key of a key chunk
+};
+
+/*
+ State of a recording in progress.
+ */
+struct SessionRecorder
+{
+    FILE *fp = NULL;                             // Session file being written
+    FrameEncoding encoding = ENCODE_RAW;         // Encoding of new frames
+    int frames = 0;                              // Frames written so far
+    std::chrono::steady_clock::time_point start; // Time of the first frame
+};
+
+/*
+ State of a replay. The whole session file is mapped read-only and frames are decoded from it on demand.
+ */
+struct SessionReplay
+{
+    unsigned char *base = NULL;                  // Start of the mapped file
+    size_t size = 0;                             // Bytes mapped
+    std::vector<uint64_t> frame_offsets;         // Offset of every frame chunk
+    std::vector<int> keys;                       // Key recorded after each frame, -1 for none
+    int next = 0;                                // Next frame to replay
+    bool realtime = true;                        // Pace frames by the recorded timestamps, otherwise run flat out
+    std::chrono::steady_clock::time_point start; // Wall clock time the first frame was replayed
+};
+
+/*
+ Given the recorder, a file name and the frame encoding, this function creates the session file.
+ It returns -1 when the file cannot be created.
+ */
+int startRecording(SessionRecorder &recorder, std::string filename, FrameEncoding encoding);
+
+/*
+ Given the recorder and a captured frame, this function appends the frame with its timestamp to the session.
+ */
+int recordFrame(SessionRecorder &recorder, cv::Mat &frame);
+
+/*
+ Given the recorder and the key returned by cv::waitKey for the last frame, this function appends the key to the session.
+ Frames without a keypress (-1) are not recorded.
+ */
+int recordKey(SessionRecorder &recorder, int key);
+
+/*
+ Given the recorder, this function closes the session file.
+ */
+int stopRecording(SessionRecorder &recorder);
+
+/*
+ Given the replay state, a file name and whether to pace frames by the recorded timestamps,
+ this function maps the session file and indexes its frames and keys.
+ A torn last chunk, left by a recording that was not closed cleanly, is ignored.
+ It returns -1 when the file is missing or not a session.
+ */
+int openReplay(SessionReplay &replay, std::string filename, bool realtime);
+
+/*
+ Given the replay state, this function decodes the next frame into frame, waiting for its recorded time when pacing,
+ and populates key with the key recorded after it. It returns false at the end of the session.
+ */
+bool replayFrame(SessionReplay &replay, cv::Mat &frame, int &key);
+
+/*
+ Given the replay state, this function returns the size of the recorded frames.
+ */
+cv::Size replayFrameSize(SessionReplay &replay);
+
+/*
+ Given the replay state, this function unmaps the session file.
+ */
+int closeReplay(SessionReplay &replay);
+
+#endif /* recorder_hpp */
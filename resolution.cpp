@@ -0,0 +1,48 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for adapting a calibration to the resolution the video stream is actually running at.
+*/
+
+#include "resolution.h"
+
+/*
+ Given a calibrated camera matrix, the image size it was calibrated at and the image size of the stream,
+ this function rescales the focal lengths and principal point in place so the matrix is valid for the stream.
+ Distortion coefficients are defined on normalised coordinates and do not change with resolution.
+ An empty calibrated size leaves the matrix untouched.
+ */
+int rescaleIntrinsics(cv::Mat &camera_matrix, cv::Size calibrated_size, cv::Size stream_size)
+{
+    if (calibrated_size.empty() || calibrated_size == stream_size)
+    {
+        return (0); // Nothing to rescale
+    }
+
+    double sx = (double)stream_size.width / calibrated_size.width;   // Horizontal scale factor
+    double sy = (double)stream_size.height / calibrated_size.height; // Vertical scale factor
+
+    camera_matrix.at<double>(0, 0) *= sx; // Focal length x
+    camera_matrix.at<double>(0, 1) *= sx; // Skew
+    camera_matrix.at<double>(1, 1) *= sy; // Focal length y
+
+    // Pixel centres sit at half-pixel offsets, so the principal point is scaled about the image corner rather than pixel (0, 0)
+    camera_matrix.at<double>(0, 2) = (camera_matrix.at<double>(0, 2) + 0.5) * sx - 0.5;
+    camera_matrix.at<double>(1, 2) = (camera_matrix.at<double>(1, 2) + 0.5) * sy - 0.5;
+
+    return (0);
+}
+
+/*
+ Given camera matrix, distortion coefficients and the image size of the stream,
+ this function builds the fixed point remap tables used to undistort frames of that size.
+ */
+int buildUndistortMaps(cv::Mat &camera_matrix, cv::Mat &dist_coeff, cv::Size image_size, cv::Mat &map_x, cv::Mat &map_y)
+{
+    cv::initUndistortRectifyMap(camera_matrix, dist_coeff, cv::Mat(), camera_matrix, image_size, CV_16SC2, map_x, map_y);
+
+    return (0);
+}
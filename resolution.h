@@ -0,0 +1,34 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for adapting a calibration to the resolution the video stream is actually running at.
+*/
+
+#ifndef resolution_hpp
+#define resolution_hpp
+
+#include <stdio.h>
+#include <iostream>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/calib3d.hpp>
+
+/*
+ Given a calibrated camera matrix, the image size it was calibrated at and the image size of the stream,
+ this function rescales the focal lengths and principal point in place so the matrix is valid for the stream.
+ Distortion coefficients are defined on normalised coordinates and do not change with resolution.
+ An empty calibrated size leaves the matrix untouched.
+ */
+int rescaleIntrinsics(cv::Mat &camera_matrix, cv::Size calibrated_size, cv::Size stream_size);
+
+/*
+ Given camera matrix, distortion coefficients and the image size of the stream,
+ this function builds the fixed point remap tables used to undistort frames of that size.
+ */
+int buildUndistortMaps(cv::Mat &camera_matrix, cv::Mat &dist_coeff, cv::Size image_size, cv::Mat &map_x, cv::Mat &map_y);
+
+#endif /* resolution_hpp */
@@ -0,0 +1,236 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for an adaptive frame scheduler that holds a target display rate by choosing, for every frame,
+between full target detection, optical flow tracking of the last detection and pose prediction.
+*/
+
+#include <opencv2/video/tracking.hpp>
+
+#include "scheduler.h"
+#include "subpix.h"
+
+/*
+ Given a start time, this function returns the milliseconds elapsed since then.
+ */
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*
+ Given the scheduler and the display rate to hold,
+ this function resets the cost estimates and tracking state and starts timing the first frame.
+ */
+int initScheduler(FrameScheduler &scheduler, double target_fps)
+{
+    scheduler = FrameScheduler();
+    scheduler.target_fps = target_fps;
+    scheduler.frame_start = std::chrono::steady_clock::now();
+
+    return (0);
+}
+
+/*
+ Given the scheduler, this function drops the tracking state and restarts the frame timing.
+ It is called on frames that are not scheduled so that stale corners and timings are not carried over.
+ */
+int resetTracking(FrameScheduler &scheduler)
+{
+    scheduler.tracking = false;
+    scheduler.have_pose = false;
+    scheduler.credit = 0.0;
+    scheduler.frame_start = std::chrono::steady_clock::now();
+
+    return (0);
+}
+
+/*
+ Given the scheduler, this function decides the action for the current frame from the measured stage costs:
+ detection when it fits in this frame's budget plus the time banked by earlier frames (or when tracking has run too long),
+ otherwise tracking when it fits, otherwise pose prediction.
+ */
+FrameAction scheduleFrame(FrameScheduler &scheduler)
+{
+    double period = 1000.0 / scheduler.target_fps; // Time available per displayed frame
+    double budget = period - scheduler.overhead;   // Time left for the action after the fixed per-frame work
+
+    if (!scheduler.tracking || scheduler.frames_since_detect >= scheduler.max_track_frames)
+    {
+        scheduler.action = FRAME_DETECT; // Nothing to track from, or tracking has drifted for too long
+    }
+    else if (scheduler.cost[FRAME_DETECT] <= budget + scheduler.credit)
+    {
+        scheduler.action = FRAME_DETECT; // Detection fits once the banked time is spent on it
+    }
+    else if (scheduler.cost[FRAME_TRACK] <= budget || !scheduler.have_pose)
+    {
+        scheduler.action = FRAME_TRACK;
+    }
+    else
+    {
+        scheduler.action = FRAME_PREDICT;
+    }
+
+    return (scheduler.action);
+}
+
+/*
+ Given the scheduler, the chosen action, the image frame, a vector of points, the target detector
+ and whether the detector's corners should be refined to sub-pixel accuracy after scaling back up,
+ this function performs the action, times it and populates the vector with the target corners.
+ Detection runs at the scheduler's current resolution scale. Prediction leaves the corners untouched.
+ It returns true when the target position is known for this frame.
+ */
+bool runScheduledFrame(FrameScheduler &scheduler, FrameAction action, cv::Mat &frame, std::vector<cv::Point2f> &corners, const TargetDetector &detect, bool refine)
+{
+    auto start = std::chrono::steady_clock::now();
+    bool found = false;
+
+    if (action == FRAME_PREDICT)
+    {
+        // The image is not looked at; the caller extrapolates the pose with predictPose
+        found = scheduler.have_pose;
+        scheduler.frames_since_detect++;
+    }
+    else
+    {
+        cv::Mat gray;
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+
+        if (action == FRAME_DETECT)
+        {
+            cv::Mat scratch;
+            if (scheduler.detect_scale < 1.0)
+            {
+                // Detect on a reduced copy and map the corners back to full resolution
+                cv::Mat small;
+                cv::resize(frame, small, cv::Size(), scheduler.detect_scale, scheduler.detect_scale, cv::INTER_AREA);
+                found = detect(small, scratch, corners, false);
+                if (found)
+                {
+                    for (auto &corner : corners)
+                    {
+                        corner *= (float)(1.0 / scheduler.detect_scale);
+                    }
+                    if (refine)
+                    {
+                        SubpixParams subpix;
+                        refineCorners(gray, corners, subpix);
+                    }
+                }
+            }
+            else
+            {
+                found = detect(frame, scratch, corners, false);
+            }
+            scheduler.frames_since_detect = 0;
+        }
+        else
+        {
+            // Follow the previous corners with pyramidal Lucas-Kanade; losing any corner ends the track
+            std::vector<unsigned char> status;
+            std::vector<float> err;
+            cv::calcOpticalFlowPyrLK(scheduler.prev_gray, gray, scheduler.corners, corners, status, err, cv::Size(21, 21), 3);
+            found = !corners.empty() && std::count(status.begin(), status.end(), 1) == (long)status.size();
+            scheduler.frames_since_detect++;
+        }
+
+        scheduler.tracking = found;
+        if (found)
+        {
+            scheduler.prev_gray = gray;
+            scheduler.corners = corners;
+        }
+        else
+        {
+            scheduler.have_pose = false;
+        }
+    }
+
+    // Smoothed cost of the action; the first measurement replaces the initial zero
+    scheduler.stage_ms = elapsedMs(start);
+    double &cost = scheduler.cost[action];
+    cost = cost == 0.0 ? scheduler.stage_ms : (1.0 - scheduler.alpha) * cost + scheduler.alpha * scheduler.stage_ms;
+
+    return (found);
+}
+
+/*
+ Given the scheduler and the pose measured on this frame, this function updates the pose velocity used for prediction.
+ */
+int updatePose(FrameScheduler &scheduler, cv::Mat &rot, cv::Mat &trans)
+{
+    if (scheduler.have_pose)
+    {
+        scheduler.rot_velocity = rot - scheduler.rot;
+        scheduler.trans_velocity = trans - scheduler.trans;
+    }
+    else
+    {
+        scheduler.rot_velocity = cv::Mat::zeros(rot.size(), rot.type());
+        scheduler.trans_velocity = cv::Mat::zeros(trans.size(), trans.type());
+    }
+
+    scheduler.rot = rot.clone();
+    scheduler.trans = trans.clone();
+    scheduler.have_pose = true;
+
+    return (0);
+}
+
+/*
+ Given the scheduler, this function extrapolates the last pose by one frame with constant velocity into rot and trans.
+ */
+int predictPose(FrameScheduler &scheduler, cv::Mat &rot, cv::Mat &trans)
+{
+    if (!scheduler.have_pose)
+    {
+        return (-1);
+    }
+
+    // Adding rotation vectors is only exact for rotations about a common axis, which is close enough between consecutive frames
+    scheduler.rot = scheduler.rot + scheduler.rot_velocity;
+    scheduler.trans = scheduler.trans + scheduler.trans_velocity;
+    rot = scheduler.rot.clone();
+    trans = scheduler.trans.clone();
+
+    return (0);
+}
+
+/*
+ Given the scheduler, this function closes the timing of the current frame, updates the overhead and banked time,
+ and lowers or raises the detector resolution so detection fits the frame budget.
+ */
+int finishFrame(FrameScheduler &scheduler)
+{
+    double period = 1000.0 / scheduler.target_fps;
+    double frame_ms = elapsedMs(scheduler.frame_start);
+    scheduler.frame_start = std::chrono::steady_clock::now();
+
+    double overhead = std::max(0.0, frame_ms - scheduler.stage_ms);
+    scheduler.overhead = (1.0 - scheduler.alpha) * scheduler.overhead + scheduler.alpha * overhead;
+
+    // Bank the slack of fast frames (and pay back slow ones), bounded so one long idle spell cannot justify a stall
+    scheduler.credit = std::max(-period, std::min(period * scheduler.max_track_frames, scheduler.credit + period - frame_ms));
+    if (scheduler.action == FRAME_DETECT)
+    {
+        scheduler.credit = std::min(scheduler.credit, 0.0);
+
+        // Shrink the detector input when detection overruns the frame, grow it back when there is plenty of room
+        double budget = period - scheduler.overhead;
+        if (scheduler.cost[FRAME_DETECT] > budget)
+        {
+            scheduler.detect_scale = std::max(scheduler.min_scale, scheduler.detect_scale * 0.85);
+        }
+        else if (scheduler.cost[FRAME_DETECT] < 0.5 * budget)
+        {
+            scheduler.detect_scale = std::min(1.0, scheduler.detect_scale * 1.1);
+        }
+    }
+
+    return (0);
+}
@@ -0,0 +1,107 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for an adaptive frame scheduler that holds a target display rate by choosing, for every frame,
+between full target detection, optical flow tracking of the last detection and pose prediction.
+*/
+
+#ifndef scheduler_hpp
+#define scheduler_hpp
+
+#include <stdio.h>
+#include <iostream>
+#include <chrono>
+#include <functional>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+/*
+ Work done on a frame, from most to least expensive.
+ */
+enum FrameAction
+{
+    FRAME_DETECT = 0, // Run the full target detector
+    FRAME_TRACK = 1,  // Track the previous corners with optical flow
+    FRAME_PREDICT = 2 // Extrapolate the previous pose without looking at the image
+};
+
+/*
+ Target detector run by the scheduler, usually detectTarget bound to the session's context.
+ */
+typedef std::function<bool(cv::Mat &src, cv::Mat &dst, std::vector<cv::Point2f> &corners, bool drawCorners)> TargetDetector;
+
+/*
+ Cost measurements and tracking state of the scheduler.
+ */
+struct FrameScheduler
+{
+    double target_fps = 0.0;                           // Display rate to hold, 0 disables scheduling
+    double alpha = 0.2;                                // Smoothing factor of the cost estimates
+    double cost[3] = {0.0, 0.0, 0.0};                  // Smoothed cost in ms of each FrameAction
+    double overhead = 0.0;                             // Smoothed cost in ms of the rest of the frame (capture, pose, drawing, display)
+    double credit = 0.0;                               // Frame time in ms banked by cheap frames towards the next detection
+    double detect_scale = 1.0;                         // Resolution scale the detector currently runs at
+    double min_scale = 0.35;                           // Smallest resolution scale the detector may drop to
+    int max_track_frames = 15;                         // Frames tracked or predicted before a detection is forced
+    int frames_since_detect = 0;                       // Frames since the last full detection
+    bool tracking = false;                             // True while corners from a previous frame are available
+    bool have_pose = false;                            // True while a previous pose is available for prediction
+    FrameAction action = FRAME_DETECT;                 // Action chosen for the current frame
+    double stage_ms = 0.0;                             // Time spent in the current frame's action
+    cv::Mat prev_gray;                                 // Grayscale image the corners were last found in
+    std::vector<cv::Point2f> corners;                  // Corners found in prev_gray
+    cv::Mat rot, trans;                                // Last measured pose
+    cv::Mat rot_velocity;                              // Change in rotation per frame
+    cv::Mat trans_velocity;                            // Change in translation per frame
+    std::chrono::steady_clock::time_point frame_start; // Start of the current frame
+};
+
+/*
+ Given the scheduler and the display rate to hold,
+ this function resets the cost estimates and tracking state and starts timing the first frame.
+ */
+int initScheduler(FrameScheduler &scheduler, double target_fps);
+
+/*
+ Given the scheduler, this function drops the tracking state and restarts the frame timing.
+ It is called on frames that are not scheduled so that stale corners and timings are not carried over.
+ */
+int resetTracking(FrameScheduler &scheduler);
+
+/*
+ Given the scheduler, this function decides the action for the current frame from the measured stage costs:
+ detection when it fits in this frame's budget plus the time banked by earlier frames (or when tracking has run too long),
+ otherwise tracking when it fits, otherwise pose prediction.
+ */
+FrameAction scheduleFrame(FrameScheduler &scheduler);
+
+/*
+ Given the scheduler, the chosen action, the image frame, a vector of points, the target detector
+ and whether the detector's corners should be refined to sub-pixel accuracy after scaling back up,
+ this function performs the action, times it and populates the vector with the target corners.
+ Detection runs at the scheduler's current resolution scale. Prediction leaves the corners untouched.
+ It returns true when the target position is known for this frame.
+ */
+bool runScheduledFrame(FrameScheduler &scheduler, FrameAction action, cv::Mat &frame, std::vector<cv::Point2f> &corners, const TargetDetector &detect, bool refine);
+
+/*
+ Given the scheduler and the pose measured on this frame, this function updates the pose velocity used for prediction.
+ */
+int updatePose(FrameScheduler &scheduler, cv::Mat &rot, cv::Mat &trans);
+
+/*
+ Given the scheduler, this function extrapolates the last pose by one frame with constant velocity into rot and trans.
+ */
+int predictPose(FrameScheduler &scheduler, cv::Mat &rot, cv::Mat &trans);
+
+/*
+ Given the scheduler, this function closes the timing of the current frame, updates the overhead and banked time,
+ and lowers or raises the detector resolution so detection fits the frame budget.
+ */
+int finishFrame(FrameScheduler &scheduler);
+
+#endif /* scheduler_hpp */
@@ -0,0 +1,92 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for running independent sessions concurrently on a fixed pool of threads.
+*/
+
+#include <algorithm>
+
+#include "sessionpool.h"
+
+/*
+ Given the pool, this function runs queued sessions until the pool is stopped and the queue is empty.
+ */
+static int runSessions(SessionPool *pool)
+{
+    while (true)
+    {
+        std::function<void()> session;
+        {
+            std::unique_lock<std::mutex> guard(pool->lock);
+            pool->ready.wait(guard, [&] { return !pool->running || !pool->pending.empty(); });
+            if (pool->pending.empty())
+            {
+                break; // Stopped, and nothing left to run
+            }
+            session = std::move(pool->pending.front());
+            pool->pending.pop_front();
+        }
+
+        session();
+
+        std::lock_guard<std::mutex> guard(pool->lock);
+        pool->completed++;
+    }
+
+    return (0);
+}
+
+/*
+ Given the pool and a thread count, this function starts the workers; a count of 0 uses one thread per core.
+ */
+int startSessionPool(SessionPool &pool, int threads)
+{
+    if (threads <= 0)
+    {
+        threads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+
+    pool.running = true;
+    for (int i = 0; i < threads; i++)
+    {
+        pool.workers.emplace_back(runSessions, &pool);
+    }
+
+    return (0);
+}
+
+/*
+ Given the pool and a session, this function queues the session to run on the next free worker.
+ */
+int submitSession(SessionPool &pool, std::function<void()> session)
+{
+    {
+        std::lock_guard<std::mutex> guard(pool.lock);
+        pool.pending.push_back(std::move(session));
+    }
+    pool.ready.notify_one();
+
+    return (0);
+}
+
+/*
+ Given the pool, this function waits for every queued session to finish and stops the workers.
+ */
+int stopSessionPool(SessionPool &pool)
+{
+    {
+        std::lock_guard<std::mutex> guard(pool.lock);
+        pool.running = false;
+    }
+    pool.ready.notify_all();
+    for (auto &worker : pool.workers)
+    {
+        worker.join();
+    }
+    pool.workers.clear();
+
+    return (0);
+}
@@ -0,0 +1,51 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for running independent sessions, each with its own CoreContext, concurrently on a fixed pool of threads.
+*/
+
+#ifndef sessionpool_hpp
+#define sessionpool_hpp
+
+#include <stdio.h>
+#include <iostream>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ Queue of sessions and the threads that run them. A session is any callable; it owns its own context,
+ so sessions never share detector state and need no locking of their own.
+ */
+struct SessionPool
+{
+    std::vector<std::thread> workers;          // Threads running the sessions
+    std::deque<std::function<void()>> pending; // Sessions waiting for a thread
+    std::mutex lock;                           // Guards pending, running and the counts
+    std::condition_variable ready;             // Signalled when a session is queued or the pool stops
+    bool running = false;                      // Cleared to stop the workers once the queue is empty
+    int completed = 0;                         // Sessions run to completion
+};
+
+/*
+ Given the pool and a thread count, this function starts the workers; a count of 0 uses one thread per core.
+ */
+int startSessionPool(SessionPool &pool, int threads);
+
+/*
+ Given the pool and a session, this function queues the session to run on the next free worker.
+ */
+int submitSession(SessionPool &pool, std::function<void()> session);
+
+/*
+ Given the pool, this function waits for every queued session to finish and stops the workers.
+ */
+int stopSessionPool(SessionPool &pool);
+
+#endif /* sessionpool_hpp */
@@ -0,0 +1,95 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+main() CPP function for a client that reads the corners, pose and frames published by main or main_ar into shared memory.
+
+Usage: shm_client [name] [--show]
+*/
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <string.h>
+
+// OpenCV headers
+#include <opencv2/core.hpp>
+#include <opencv2/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+// User-defined headers
+#include "shmring.h"
+
+// Main function
+int main(int argc, char *argv[])
+{
+    std::string name = "/calib_ar"; // Shared-memory object written by --shm
+    bool show = false;              // Display the published frames
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--show") == 0)
+        {
+            show = true;
+        }
+        else
+        {
+            name = argv[i];
+        }
+    }
+
+    // Wait for the publisher to create the ring
+    ShmReader reader;
+    while (shmOpenReader(reader, name) != 0)
+    {
+        printf("Waiting for %s...\n", name.c_str());
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+    printf("Attached to %s\n", name.c_str());
+
+    ShmSample sample;  // Latest sample copied out of the ring
+    uint64_t read = 0; // Samples read
+    uint64_t expected = 0;
+    uint64_t missed = 0; // Samples published while the client was not looking
+    while (shmPublisherAlive(reader))
+    {
+        int status = shmReadLatest(reader, sample);
+        if (status <= 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2)); // Nothing new or a torn read, poll again
+            continue;
+        }
+
+        if (read > 0 && sample.index > expected)
+        {
+            missed += sample.index - expected;
+        }
+        expected = sample.index + 1;
+        read++;
+
+        double age = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count() - sample.timestamp;
+        printf("sample %llu  found %d  corners %d  calibration %016llx  latency %.2f ms",
+               (unsigned long long)sample.index, sample.found, (int)sample.corners.size(), (unsigned long long)sample.calibration_id, age * 1000.0);
+        if (sample.has_pose)
+        {
+            printf("  rot [%.4f %.4f %.4f]  trans [%.4f %.4f %.4f]", sample.rot.at<double>(0), sample.rot.at<double>(1), sample.rot.at<double>(2),
+                   sample.trans.at<double>(0), sample.trans.at<double>(1), sample.trans.at<double>(2));
+        }
+        printf("\n");
+
+        if (show && !sample.frame.empty())
+        {
+            cv::imshow("Shared frame", sample.frame);
+            if (cv::waitKey(1) == 'q')
+            {
+                break;
+            }
+        }
+    }
+
+    printf("Read %llu samples, missed %llu\n", (unsigned long long)read, (unsigned long long)missed);
+    shmCloseReader(reader);
+
+    return (0);
+}
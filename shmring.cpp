@@ -0,0 +1,320 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for publishing each frame's corners, camera pose, calibration ID and optionally the output frame
+into a POSIX shared-memory ring, and for reading them back from other processes on the same host.
+*/
+
+#include <chrono>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <signal.h>
+#include <sys/stat.h>
+
+#include "shmring.h"
+
+/*
+ Given a mapped ring and a slot number, this function returns the start of the slot.
+ */
+static ShmSlotHeader *ringSlot(unsigned char *base, uint64_t slot)
+{
+    ShmRingHeader *header = (ShmRingHeader *)base;
+    size_t offset = sizeof(ShmRingHeader) + (size_t)(slot % header->slot_count) * header->slot_size;
+
+    return ((ShmSlotHeader *)(base + offset));
+}
+
+/*
+ Given the camera matrix and distortion coefficients, this function returns a 64-bit hash identifying the calibration.
+ */
+uint64_t calibrationId(cv::Mat &camera_matrix, cv::Mat &dist_coeff)
+{
+    // FNV-1a over the coefficients as doubles, so the same calibration gives the same ID in every process
+    uint64_t hash = 1469598103934665603ULL;
+    for (cv::Mat *mat : {&camera_matrix, &dist_coeff})
+    {
+        cv::Mat values;
+        if (!mat->empty())
+        {
+            mat->convertTo(values, CV_64F);
+            values = values.reshape(1, 1).clone();
+        }
+        const unsigned char *bytes = values.ptr<unsigned char>();
+        for (size_t i = 0; i < values.total() * sizeof(double); i++)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    }
+
+    return (hash);
+}
+
+/*
+ Given the publisher and the frame size and type, this function creates, sizes and maps the shared-memory object.
+ */
+static int createRing(ShmPublisher &publisher, cv::Size frame_size, int frame_type)
+{
+    size_t frame_bytes = publisher.with_frames ? frame_size.area() * CV_ELEM_SIZE(frame_type) : 0;
+    size_t slot_size = sizeof(ShmSlotHeader) + publisher.max_corners * 2 * sizeof(float) + frame_bytes;
+    slot_size = (slot_size + 63) & ~(size_t)63; // Keep every slot on its own cache lines
+
+    publisher.size = sizeof(ShmRingHeader) + publisher.slot_count * slot_size;
+    publisher.fd = shm_open(publisher.name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (publisher.fd < 0 || ftruncate(publisher.fd, publisher.size) != 0)
+    {
+        printf("Unable to create shared memory %s\n", publisher.name.c_str());
+        return (-1);
+    }
+
+    void *base = mmap(NULL, publisher.size, PROT_READ | PROT_WRITE, MAP_SHARED, publisher.fd, 0);
+    if (base == MAP_FAILED)
+    {
+        printf("Unable to map shared memory %s\n", publisher.name.c_str());
+        return (-1);
+    }
+    publisher.base = (unsigned char *)base;
+
+    // The fresh object is zero filled, so every slot sequence starts even (not being written)
+    ShmRingHeader *header = (ShmRingHeader *)publisher.base;
+    header->version = SHM_RING_VERSION;
+    header->slot_count = publisher.slot_count;
+    header->slot_size = (uint32_t)slot_size;
+    header->max_corners = publisher.max_corners;
+    header->frame_rows = publisher.with_frames ? frame_size.height : 0;
+    header->frame_cols = publisher.with_frames ? frame_size.width : 0;
+    header->frame_type = publisher.with_frames ? frame_type : 0;
+    header->latest.store(0, std::memory_order_relaxed);
+    header->writer.store((uint32_t)getpid(), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SHM_RING_MAGIC; // Readers wait for the magic before trusting the layout
+
+    return (0);
+}
+
+/*
+ Given the publisher, the output frame, the target corners, whether they were found, the pose and the calibration ID,
+ this function writes one sample into the next slot of the ring. Pass empty rot and trans when there is no pose.
+ It returns -1 when the segment cannot be created, and from then on without trying again.
+ */
+int shmPublish(ShmPublisher &publisher, cv::Mat &frame, std::vector<cv::Point2f> &corners, bool found, cv::Mat &rot, cv::Mat &trans, uint64_t calibration_id)
+{
+    if (publisher.failed)
+    {
+        return (-1);
+    }
+    if (publisher.base == NULL && createRing(publisher, frame.size(), frame.type()) != 0)
+    {
+        shmClosePublisher(publisher);
+        publisher.failed = true; // Not retried every frame; publishing stays off for the rest of the run
+        printf("Shared-memory publishing disabled\n");
+        return (-1);
+    }
+
+    ShmRingHeader *header = (ShmRingHeader *)publisher.base;
+    uint64_t index = header->latest.load(std::memory_order_relaxed);
+    ShmSlotHeader *slot = ringSlot(publisher.base, index);
+
+    // Odd sequence while the slot is being rewritten
+    uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->index = index;
+    slot->timestamp = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    slot->calibration_id = calibration_id;
+    slot->found = found;
+    slot->has_pose = rot.total() >= 3 && trans.total() >= 3;
+    for (int i = 0; i < 3 && slot->has_pose; i++)
+    {
+        slot->rot[i] = rot.ptr<double>()[i];
+        slot->trans[i] = trans.ptr<double>()[i];
+    }
+
+    slot->corner_count = (uint32_t)std::min(corners.size(), (size_t)header->max_corners);
+    memcpy((unsigned char *)(slot + 1), corners.data(), slot->corner_count * sizeof(cv::Point2f));
+
+    // Frames that do not match the ring layout (e.g. after a resolution change) are left out
+    slot->has_frame = publisher.with_frames && frame.isContinuous() && (uint32_t)frame.rows == header->frame_rows &&
+                      (uint32_t)frame.cols == header->frame_cols && (uint32_t)frame.type() == header->frame_type;
+    if (slot->has_frame)
+    {
+        unsigned char *pixels = (unsigned char *)(slot + 1) + header->max_corners * 2 * sizeof(float);
+        memcpy(pixels, frame.data, frame.total() * frame.elemSize());
+    }
+
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+    header->latest.store(index + 1, std::memory_order_release);
+
+    return (0);
+}
+
+/*
+ Given the publisher, this function marks the publisher as gone, unmaps and removes the shared-memory object.
+ */
+int shmClosePublisher(ShmPublisher &publisher)
+{
+    if (publisher.base != NULL)
+    {
+        ((ShmRingHeader *)publisher.base)->writer.store(0, std::memory_order_release);
+        munmap(publisher.base, publisher.size);
+        publisher.base = NULL;
+    }
+    if (publisher.fd >= 0)
+    {
+        close(publisher.fd);
+        shm_unlink(publisher.name.c_str()); // Readers keep their mapping until they close it
+        publisher.fd = -1;
+    }
+
+    return (0);
+}
+
+/*
+ Given the reader and the name of the shared-memory object, this function maps the ring read-only.
+ It returns -1 when no publisher has created the ring yet.
+ */
+int shmOpenReader(ShmReader &reader, std::string name)
+{
+    reader.name = name;
+    reader.fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (reader.fd < 0)
+    {
+        return (-1);
+    }
+
+    struct stat info;
+    if (fstat(reader.fd, &info) != 0 || (size_t)info.st_size < sizeof(ShmRingHeader))
+    {
+        shmCloseReader(reader);
+        return (-1);
+    }
+    reader.size = info.st_size;
+
+    void *base = mmap(NULL, reader.size, PROT_READ, MAP_SHARED, reader.fd, 0);
+    if (base == MAP_FAILED)
+    {
+        shmCloseReader(reader);
+        return (-1);
+    }
+    reader.base = (unsigned char *)base;
+
+    ShmRingHeader *header = (ShmRingHeader *)reader.base;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->magic != SHM_RING_MAGIC || header->version != SHM_RING_VERSION ||
+        sizeof(ShmRingHeader) + (size_t)header->slot_count * header->slot_size > reader.size)
+    {
+        shmCloseReader(reader);
+        return (-1);
+    }
+    reader.last = 0;
+
+    return (0);
+}
+
+/*
+ Given the reader, this function copies the newest sample out of the ring.
+ It returns 1 when a new sample was read, 0 when nothing was published since the previous call and -1 when the read failed.
+ */
+int shmReadLatest(ShmReader &reader, ShmSample &sample)
+{
+    if (reader.base == NULL)
+    {
+        return (-1);
+    }
+
+    ShmRingHeader *header = (ShmRingHeader *)reader.base;
+    for (int attempt = 0; attempt < 8; attempt++)
+    {
+        uint64_t latest = header->latest.load(std::memory_order_acquire);
+        if (latest == reader.last)
+        {
+            return (0);
+        }
+
+        ShmSlotHeader *slot = ringSlot(reader.base, latest - 1);
+        uint64_t before = slot->sequence.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            continue; // Publisher is rewriting this slot, look again
+        }
+
+        sample.index = slot->index;
+        sample.timestamp = slot->timestamp;
+        sample.calibration_id = slot->calibration_id;
+        sample.found = slot->found != 0;
+        sample.has_pose = slot->has_pose != 0;
+        if (sample.has_pose)
+        {
+            sample.rot = cv::Mat(3, 1, CV_64F, (void *)slot->rot).clone();
+            sample.trans = cv::Mat(3, 1, CV_64F, (void *)slot->trans).clone();
+        }
+        else
+        {
+            sample.rot.release();
+            sample.trans.release();
+        }
+
+        uint32_t count = std::min(slot->corner_count, header->max_corners);
+        const cv::Point2f *corners = (const cv::Point2f *)(slot + 1);
+        sample.corners.assign(corners, corners + count);
+
+        if (slot->has_frame)
+        {
+            const unsigned char *pixels = (const unsigned char *)(slot + 1) + header->max_corners * 2 * sizeof(float);
+            cv::Mat(header->frame_rows, header->frame_cols, header->frame_type, (void *)pixels).copyTo(sample.frame);
+        }
+        else
+        {
+            sample.frame.release();
+        }
+
+        // The copy is only valid when the slot was not rewritten meanwhile
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) == before)
+        {
+            reader.last = latest;
+            return (1);
+        }
+    }
+
+    return (-1);
+}
+
+/*
+ Given the reader, this function returns true while the publisher is still attached to the ring.
+ */
+bool shmPublisherAlive(ShmReader &reader)
+{
+    if (reader.base == NULL)
+    {
+        return (false);
+    }
+
+    uint32_t pid = ((ShmRingHeader *)reader.base)->writer.load(std::memory_order_acquire);
+
+    return (pid != 0 && kill((pid_t)pid, 0) == 0);
+}
+
+/*
+ Given the reader, this function unmaps the ring.
+ */
+int shmCloseReader(ShmReader &reader)
+{
+    if (reader.base != NULL)
+    {
+        munmap(reader.base, reader.size);
+        reader.base = NULL;
+    }
+    if (reader.fd >= 0)
+    {
+        close(reader.fd);
+        reader.fd = -1;
+    }
+
+    return (0);
+}
@@ -0,0 +1,140 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for publishing each frame's corners, camera pose, calibration ID and optionally the output frame
+into a POSIX shared-memory ring, and for reading them back from other processes on the same host.
+*/
+
+#ifndef shmring_hpp
+#define shmring_hpp
+
+#include <stdio.h>
+#include <iostream>
+#include <atomic>
+#include <stdint.h>
+
+#include <opencv2/core.hpp>
+
+#define SHM_RING_MAGIC 0x474e4952 // "RING"
+#define SHM_RING_VERSION 1
+
+/*
+ Start of the shared-memory segment. The slots follow it, each slot_size bytes long.
+ */
+struct ShmRingHeader
+{
+    uint32_t magic;                // SHM_RING_MAGIC once the segment is initialised
+    uint32_t version;              // SHM_RING_VERSION
+    uint32_t slot_count;           // Number of slots in the ring
+    uint32_t slot_size;            // Bytes per slot including its ShmSlotHeader
+    uint32_t max_corners;          // Capacity of the corner array of each slot
+    uint32_t frame_rows;           // Size and type of the published frames, zero when frames are not published
+    uint32_t frame_cols;
+    uint32_t frame_type;
+    std::atomic<uint64_t> latest;  // Number of samples published so far; the newest is in slot (latest - 1) % slot_count
+    std::atomic<uint32_t> writer;  // Process ID of the publisher, zero once it has exited
+};
+
+/*
+ Start of every slot. The corners (x, y floats) and then the frame pixels follow it.
+ The sequence counter is odd while the publisher is writing the slot, so readers can detect torn reads.
+ */
+struct ShmSlotHeader
+{
+    std::atomic<uint64_t> sequence; // Seqlock counter of the slot
+    uint64_t index;                 // Number of the sample, counting from zero
+    double timestamp;               // Steady clock time of publication in seconds
+    uint64_t calibration_id;        // Hash of the camera matrix and distortion coefficients in use
+    int32_t found;                  // True when the target was found in the frame
+    int32_t has_pose;               // True when rot and trans hold the pose of this frame
+    uint32_t corner_count;          // Number of valid corners
+    uint32_t has_frame;             // True when the frame pixels are present
+    double rot[3];                  // Rodrigues rotation vector
+    double trans[3];                // Translation vector
+};
+
+/*
+ Publishing side of the ring. The segment is created on the first publish, sized from the first frame.
+ */
+struct ShmPublisher
+{
+    std::string name;           // Name of the shared-memory object, e.g. /calib_ar
+    bool with_frames = false;   // Publish the output frame alongside the corners and pose
+    int slot_count = 4;         // Slots in the ring; readers have this many frames of slack
+    int max_corners = 256;      // Corners stored per slot
+    int fd = -1;                // Descriptor of the shared-memory object
+    size_t size = 0;            // Bytes mapped
+    unsigned char *base = NULL; // Start of the mapping
+    bool failed = false;        // Set when the segment could not be created; nothing is published after that
+};
+
+/*
+ Reading side of the ring.
+ */
+struct ShmReader
+{
+    std::string name;           // Name of the shared-memory object
+    int fd = -1;                // Descriptor of the shared-memory object
+    size_t size = 0;            // Bytes mapped
+    unsigned char *base = NULL; // Start of the mapping
+    uint64_t last = 0;          // Value of latest when the previous sample was read
+};
+
+/*
+ One consistent sample copied out of the ring.
+ */
+struct ShmSample
+{
+    uint64_t index = 0;
+    double timestamp = 0.0;
+    uint64_t calibration_id = 0;
+    bool found = false;
+    bool has_pose = false;
+    std::vector<cv::Point2f> corners;
+    cv::Mat rot, trans; // 3x1 CV_64F, empty without a pose
+    cv::Mat frame;      // Empty when the publisher does not publish frames
+};
+
+/*
+ Given the camera matrix and distortion coefficients, this function returns a 64-bit hash identifying the calibration.
+ */
+uint64_t calibrationId(cv::Mat &camera_matrix, cv::Mat &dist_coeff);
+
+/*
+ Given the publisher, the output frame, the target corners, whether they were found, the pose and the calibration ID,
+ this function writes one sample into the next slot of the ring. Pass empty rot and trans when there is no pose.
+ It returns -1 when the segment cannot be created, and from then on without trying again.
+ */
+int shmPublish(ShmPublisher &publisher, cv::Mat &frame, std::vector<cv::Point2f> &corners, bool found, cv::Mat &rot, cv::Mat &trans, uint64_t calibration_id);
+
+/*
+ Given the publisher, this function marks the publisher as gone, unmaps and removes the shared-memory object.
+ */
+int shmClosePublisher(ShmPublisher &publisher);
+
+/*
+ Given the reader and the name of the shared-memory object, this function maps the ring read-only.
+ It returns -1 when no publisher has created the ring yet.
+ */
+int shmOpenReader(ShmReader &reader, std::string name);
+
+/*
+ Given the reader, this function copies the newest sample out of the ring.
+ It returns 1 when a new sample was read, 0 when nothing was published since the previous call and -1 when the read failed.
+ */
+int shmReadLatest(ShmReader &reader, ShmSample &sample);
+
+/*
+ Given the reader, this function returns true while the publisher is still attached to the ring.
+ */
+bool shmPublisherAlive(ShmReader &reader);
+
+/*
+ Given the reader, this function unmaps the ring.
+ */
+int shmCloseReader(ShmReader &reader);
+
+#endif /* shmring_hpp */
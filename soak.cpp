@@ -0,0 +1,585 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+main() CPP function for soak-testing the detect, pose and overlay path over hours of accelerated time.
+A recorded session or a synthetic clip is played in a loop, as fast as the machine allows, through processArFrame,
+the frame step main and main_ar ship, while a script toggles the modes the way the keys do: capturing and calibrating, reading the calibration back,
+the axes, the virtual object, the artwork and the undistorted view. Every window of frames records the frame latency,
+the resident set size, the heap in use and the number of live allocations. At the end the trend of each is fitted
+after a warm-up, and the run fails when one of them grows by more than its tolerance.
+
+Usage: soak [--replay=session.rec] [--target=chessboard|circles] [--hours=H] [--frames=N] [--fps=N] [--clip=N]
+            [--script=MODE:FRAMES,...] [--window=N] [--target-fps=N] [--drift] [--calib=soak_calib.csv] [--csv=soak.csv]
+            [--rss-tol=MB] [--live-tol=N] [--p99-tol=FRACTION]
+*/
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <stdlib.h>
+#include <unistd.h>
+#include <malloc.h>
+
+// OpenCV headers
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+// User-defined headers
+#include "core.h"
+#include "csv_util.h"
+#include "driftmon.h"
+#include "recorder.h"
+#include "resolution.h"
+#include "scheduler.h"
+#include "synth.h"
+
+// Every operator new in the process is counted, so a container that keeps growing shows up as a rising live count
+static std::atomic<long> allocations{0};
+static std::atomic<long> deallocations{0};
+
+void *operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *block = malloc(size > 0 ? size : 1);
+    if (block == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return (block);
+}
+
+void operator delete(void *block) noexcept
+{
+    if (block != NULL)
+    {
+        deallocations.fetch_add(1, std::memory_order_relaxed);
+        free(block);
+    }
+}
+
+void operator delete(void *block, size_t) noexcept
+{
+    operator delete(block);
+}
+
+/*
+ Modes the script switches between, each entered the way its key enters it.
+ */
+enum SoakMode
+{
+    MODE_CAPTURE,   // 's': detect with the corners drawn, take views and calibrate and save ('c') when the phase ends
+    MODE_AXES,      // 'x': read the calibration back and draw the axes
+    MODE_OBJECT,    // 'd' or 'o': read the calibration back and draw the virtual object
+    MODE_CANVAS,    // 't': read the calibration back and warp the artwork onto the circle grid
+    MODE_UNDISTORT, // 'u': rebuild the remap tables and show the undistorted stream
+    MODE_IDLE       // Detection only
+};
+
+static const char *mode_names[] = {"capture", "axes", "object", "canvas", "undistort", "idle"};
+
+/*
+ One step of the script: a mode and the number of frames it lasts.
+ */
+struct SoakPhase
+{
+    SoakMode mode;
+    int frames;
+};
+
+/*
+ Measurements of one window of frames.
+ */
+struct SoakWindow
+{
+    double minutes = 0.0;          // Virtual time at the end of the window
+    double p50_ms = 0.0;           // Median frame latency
+    double p99_ms = 0.0;           // 99th percentile frame latency
+    double rss_mb = 0.0;           // Resident set size
+    double heap_mb = 0.0;          // Heap in use, 0 where the C library cannot report it
+    double live = 0.0;             // Allocations not yet freed
+    double allocs_per_frame = 0.0; // operator new calls per frame
+};
+
+/*
+ Footage played in a loop: either a synthetic clip held in memory or a recorded session that is reopened at its end.
+ */
+struct SoakFootage
+{
+    std::vector<cv::Mat> clip; // Synthetic frames
+    std::string replay_file;   // Recorded session, when one is given
+    SessionReplay replay;
+    size_t next = 0;           // Next frame of the clip
+    int loops = 0;             // Times the footage was played to the end
+};
+
+/*
+ Given a script such as capture:300,axes:900 and a vector of phases, this function populates the vector.
+ It returns -1 when a mode is unknown or a phase has no frames.
+ */
+static int parseScript(const std::string &script, std::vector<SoakPhase> &phases)
+{
+    phases.clear();
+    size_t start = 0;
+    while (start < script.size())
+    {
+        size_t end = script.find(',', start);
+        end = end == std::string::npos ? script.size() : end;
+        std::string step = script.substr(start, end - start);
+        size_t colon = step.find(':');
+
+        int mode = 0;
+        while (mode <= MODE_IDLE && step.compare(0, colon, mode_names[mode]) != 0)
+        {
+            mode++;
+        }
+        int frames = colon == std::string::npos ? 0 : atoi(step.c_str() + colon + 1);
+        if (mode > MODE_IDLE || frames <= 0)
+        {
+            printf("Unknown script step %s\n", step.c_str());
+            return (-1);
+        }
+        phases.push_back({(SoakMode)mode, frames});
+        start = end + 1;
+    }
+
+    return (phases.empty() ? -1 : 0);
+}
+
+/*
+ Given the target, the number of frames and a vector of frames, this function renders a synthetic clip in which the board
+ moves steadily between random poses, like a hand-held camera, and ends at the pose it starts from so the clip loops smoothly.
+ */
+static int renderClip(TargetKind kind, int count, std::vector<cv::Mat> &clip)
+{
+    StereoTarget target = kind == TARGET_CIRCLES ? STEREO_CIRCLEGRID : STEREO_CHESSBOARD;
+    SynthParams params;
+    params.supersample = 2;
+    params.noise_sigma = 2.0;
+    prepareSynth(target, params);
+
+    const int steps = 30; // Frames between two key poses
+    int keys = std::max(1, count / steps);
+    std::vector<cv::Mat> rots(keys + 1), transs(keys + 1);
+    cv::RNG rng(1);
+    for (int k = 0; k < keys; k++)
+    {
+        randomBoardPose(target, params, rng, rots[k], transs[k]);
+    }
+    rots[keys] = rots[0];
+    transs[keys] = transs[0];
+
+    clip.clear();
+    SynthSample sample;
+    for (int i = 0; i < keys * steps; i++)
+    {
+        int k = i / steps;
+        double a = (double)(i % steps) / steps;
+        cv::Mat rot = rots[k] * (1.0 - a) + rots[k + 1] * a;
+        cv::Mat trans = transs[k] * (1.0 - a) + transs[k + 1] * a;
+        renderSynthView(target, params, rot, trans, rng, sample);
+        clip.push_back(sample.image.clone());
+    }
+
+    return (0);
+}
+
+/*
+ Given the footage and a cv::Mat, this function fetches the next frame, starting the footage over at its end.
+ It returns -1 when the footage has no frames at all.
+ */
+static int nextFootageFrame(SoakFootage &footage, cv::Mat &frame)
+{
+    if (footage.replay_file.empty())
+    {
+        if (footage.clip.empty())
+        {
+            return (-1);
+        }
+        frame = footage.clip[footage.next];
+        if (++footage.next == footage.clip.size())
+        {
+            footage.next = 0;
+            footage.loops++;
+        }
+        return (0);
+    }
+
+    int key;
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        if (replayFrame(footage.replay, frame, key) && !frame.empty())
+        {
+            return (0);
+        }
+        // Reopening the session each time round also soaks the replay path
+        closeReplay(footage.replay);
+        if (openReplay(footage.replay, footage.replay_file, false) != 0)
+        {
+            return (-1);
+        }
+        footage.loops++;
+    }
+
+    return (-1);
+}
+
+/*
+ This function returns the resident set size of the process in MB.
+ */
+static double residentMB()
+{
+    long pages = 0, resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if (fp != NULL)
+    {
+        if (fscanf(fp, "%ld %ld", &pages, &resident) != 2)
+        {
+            resident = 0;
+        }
+        fclose(fp);
+    }
+
+    return (resident * (double)sysconf(_SC_PAGESIZE) / 1e6);
+}
+
+/*
+ This function returns the heap in use in MB, which includes the buffers OpenCV allocates with malloc,
+ or 0 where the C library cannot report it.
+ */
+static double heapMB()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    return (info.uordblks / 1e6);
+#else
+    return (0.0);
+#endif
+}
+
+/*
+ Given the frame latencies of a window and a fraction, this function returns the latency at that percentile.
+ The latencies are reordered.
+ */
+static double percentile(std::vector<double> &latencies, double fraction)
+{
+    if (latencies.empty())
+    {
+        return (0.0);
+    }
+    size_t k = std::min(latencies.size() - 1, (size_t)(fraction * latencies.size()));
+    std::nth_element(latencies.begin(), latencies.begin() + k, latencies.end());
+
+    return (latencies[k]);
+}
+
+/*
+ Given the windows, the first window to use and a member of SoakWindow, this function fits a straight line to the member
+ by least squares and returns how much the line rises from the first window used to the last.
+ */
+static double trendRise(const std::vector<SoakWindow> &windows, size_t first, double SoakWindow::*member)
+{
+    size_t n = windows.size() - first;
+    double mean_x = (n - 1) / 2.0, mean_y = 0.0;
+    for (size_t i = first; i < windows.size(); i++)
+    {
+        mean_y += windows[i].*member / n;
+    }
+    double sxy = 0.0, sxx = 0.0;
+    for (size_t i = first; i < windows.size(); i++)
+    {
+        double x = (double)(i - first) - mean_x;
+        sxy += x * (windows[i].*member - mean_y);
+        sxx += x * x;
+    }
+
+    return (sxx > 0.0 ? sxy / sxx * (n - 1) : 0.0);
+}
+
+/*
+ Given a metric's name, its rise, its starting value, its tolerance and the unit, this function prints the verdict
+ and returns true when the rise is within the tolerance.
+ */
+static bool checkTrend(const char *name, double rise, double start, double tolerance, const char *unit)
+{
+    bool ok = rise <= tolerance;
+    printf("%-18s %+10.2f %-6s from %10.2f, tolerance %8.2f: %s\n", name, rise, unit, start, tolerance, ok ? "ok" : "FAIL");
+
+    return (ok);
+}
+
+// Main function
+int main(int argc, char *argv[])
+{
+    TargetKind kind = TARGET_CHESSBOARD;
+    SoakFootage footage;
+    double hours = 1.0;       // Virtual time to cover
+    long total_frames = 0;    // Overrides hours when set
+    double fps = 30.0;        // Frame rate the virtual time is counted at
+    int clip_frames = 60;     // Length of the synthetic clip
+    std::string script = "capture:300,axes:900,object:900,canvas:600,undistort:300,idle:300";
+    int window = 0;           // Frames per window, one pass of the script by default
+    double target_fps = 0.0;  // Scheduler rate in the AR modes, as --target-fps in main
+    std::string calib_file = "soak_calib.csv";
+    std::string csv_file;
+    double rss_tol = 8.0;     // MB the resident set and the heap may grow by
+    double live_tol = 2000.0; // Live allocations the run may gain
+    double p99_tol = 0.25;    // Relative rise of the p99 latency, above a 0.5 ms floor
+    DriftMonitor drift;
+    BundleParams solver;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--replay=", 0) == 0)
+        {
+            footage.replay_file = arg.substr(9);
+        }
+        else if (arg.rfind("--target=", 0) == 0)
+        {
+            kind = arg.substr(9) == "circles" ? TARGET_CIRCLES : TARGET_CHESSBOARD;
+        }
+        else if (arg.rfind("--hours=", 0) == 0)
+        {
+            hours = atof(arg.c_str() + 8);
+        }
+        else if (arg.rfind("--frames=", 0) == 0)
+        {
+            total_frames = atol(arg.c_str() + 9);
+        }
+        else if (arg.rfind("--fps=", 0) == 0)
+        {
+            fps = std::max(1.0, atof(arg.c_str() + 6));
+        }
+        else if (arg.rfind("--clip=", 0) == 0)
+        {
+            clip_frames = std::max(30, atoi(arg.c_str() + 7));
+        }
+        else if (arg.rfind("--script=", 0) == 0)
+        {
+            script = arg.substr(9);
+        }
+        else if (arg.rfind("--window=", 0) == 0)
+        {
+            window = atoi(arg.c_str() + 9);
+        }
+        else if (arg.rfind("--target-fps=", 0) == 0)
+        {
+            target_fps = atof(arg.c_str() + 13);
+        }
+        else if (arg.rfind("--calib=", 0) == 0)
+        {
+            calib_file = arg.substr(8);
+        }
+        else if (arg.rfind("--csv=", 0) == 0)
+        {
+            csv_file = arg.substr(6);
+        }
+        else if (arg.rfind("--rss-tol=", 0) == 0)
+        {
+            rss_tol = atof(arg.c_str() + 10);
+        }
+        else if (arg.rfind("--live-tol=", 0) == 0)
+        {
+            live_tol = atof(arg.c_str() + 11);
+        }
+        else if (arg.rfind("--p99-tol=", 0) == 0)
+        {
+            p99_tol = atof(arg.c_str() + 10);
+        }
+        else if (!parseDriftArg(drift, arg) && !parseBundleArg(solver, arg))
+        {
+            printf("Usage: soak [--replay=session.rec] [--target=chessboard|circles] [--hours=H] [--frames=N] [--fps=N] [--clip=N] [--script=MODE:FRAMES,...]\n"
+                   "            [--window=N] [--target-fps=N] [--drift] [--calib=soak_calib.csv] [--csv=soak.csv] [--rss-tol=MB] [--live-tol=N] [--p99-tol=FRACTION]\n");
+            return (-1);
+        }
+    }
+
+    std::vector<SoakPhase> phases;
+    if (parseScript(script, phases) != 0)
+    {
+        return (-1);
+    }
+    int cycle = 0;
+    for (const SoakPhase &phase : phases)
+    {
+        cycle += phase.frames;
+    }
+    window = window > 0 ? window : cycle; // Whole passes of the script keep every window's mix of modes the same
+    total_frames = total_frames > 0 ? total_frames : (long)(hours * 3600.0 * fps);
+
+    // Footage
+    cv::Mat frame;
+    if (!footage.replay_file.empty())
+    {
+        if (openReplay(footage.replay, footage.replay_file, false) != 0)
+        {
+            return (-1);
+        }
+    }
+    else
+    {
+        printf("Rendering a %d frame synthetic clip...\n", clip_frames);
+        renderClip(kind, clip_frames, footage.clip);
+    }
+    if (nextFootageFrame(footage, frame) != 0)
+    {
+        printf("No frames to play\n");
+        return (-1);
+    }
+    cv::Size frame_size = frame.size();
+
+    // Session state, as main and main_ar hold it
+    CoreContext core;
+    initCoreContext(core, kind, frame_size);
+    cv::Mat rot, trans, output, map_x, map_y;
+    cv::Size calib_size;
+    OverlayCompositor overlays;
+    cv::Mat artwork(240, 320, CV_8UC3);
+    cv::randu(artwork, cv::Scalar::all(0), cv::Scalar::all(255));
+    int canvas_layer = core.target.quad.empty() ? -1 : addImageLayer(overlays, artwork, core.target.quad);
+    int axes_layer = addLineLayer(overlays, core.target.axes);
+    int object_layer = addLineLayer(overlays, core.target.objects);
+    FrameScheduler scheduler;
+    initScheduler(scheduler, target_fps);
+    const int max_views = 10; // Views kept by the capture phases; later passes recalibrate the same views
+    int found_frames = 0;
+
+    printf("Soaking %ld frames (%.2f h at %.0f fps) in windows of %d frames, script %s\n", total_frames, total_frames / fps / 3600.0, fps, window,
+           script.c_str());
+    printf("%9s %8s %8s %9s %9s %9s %8s\n", "minutes", "p50 ms", "p99 ms", "RSS MB", "heap MB", "live", "allocs/f");
+
+    std::vector<SoakWindow> windows;
+    std::vector<double> latencies;
+    latencies.reserve(window);
+    std::vector<cv::Point2f> corners;
+    std::vector<cv::Vec3f> points;
+    size_t phase = phases.size() - 1;
+    int phase_left = 0;
+    long window_allocs = allocations.load();
+    auto started = std::chrono::steady_clock::now();
+    for (long n = 0; n < total_frames; n++)
+    {
+        // Leave the current mode and enter the next one, the way the keys do; not counted in the frame latency
+        if (phase_left-- == 0)
+        {
+            if (phases[phase].mode == MODE_CAPTURE && (int)core.corners_list.size() >= 5)
+            {
+                calibrateCamera(core, frame_size, solver);
+                saveCalibration(calib_file, core.camera_matrix, core.dist_coeff, frame_size);
+            }
+            phase = (phase + 1) % phases.size();
+            phase_left = phases[phase].frames - 1;
+
+            SoakMode mode = phases[phase].mode;
+            if (mode == MODE_AXES || mode == MODE_OBJECT || mode == MODE_CANVAS)
+            {
+                if (readCalibration(calib_file, core.camera_matrix, core.dist_coeff, calib_size) == 0)
+                {
+                    rescaleIntrinsics(core.camera_matrix, calib_size, frame_size);
+                    startDriftMonitor(drift, core.target.points, core.camera_matrix, core.dist_coeff, frame_size);
+                }
+            }
+            map_x.release();
+            resetTracking(scheduler);
+        }
+        SoakMode mode = phases[phase].mode;
+        bool posing = mode == MODE_AXES || mode == MODE_OBJECT || mode == MODE_CANVAS;
+
+        if (nextFootageFrame(footage, frame) != 0)
+        {
+            break;
+        }
+
+        // The frame step main and main_ar run, then the capture and the undistorted view
+        auto start = std::chrono::steady_clock::now();
+        if (canvas_layer >= 0)
+        {
+            overlays.layers[canvas_layer].visible = mode == MODE_CANVAS;
+        }
+        overlays.layers[axes_layer].visible = mode == MODE_AXES;
+        overlays.layers[object_layer].visible = mode == MODE_OBJECT;
+        bool found = processArFrame(core, scheduler, drift, overlays, frame, output, corners, rot, trans, posing, !posing);
+
+        if (mode == MODE_CAPTURE && found && (int)core.corners_list.size() < max_views && found_frames++ % 15 == 0)
+        {
+            selectCalibrationImg(core, corners, points);
+        }
+        if (mode == MODE_UNDISTORT && !core.dist_coeff.empty())
+        {
+            if (map_x.empty() || map_x.size() != output.size())
+            {
+                buildUndistortMaps(core.camera_matrix, core.dist_coeff, output.size(), map_x, map_y);
+            }
+            cv::Mat undistorted;
+            cv::remap(output, undistorted, map_x, map_y, cv::INTER_LINEAR);
+            output = undistorted;
+        }
+        if (target_fps > 0 && posing)
+        {
+            finishFrame(scheduler);
+        }
+        latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+        // Close the window
+        if ((int)latencies.size() == window)
+        {
+            SoakWindow result;
+            long allocs = allocations.load();
+            result.minutes = (n + 1) / fps / 60.0;
+            result.allocs_per_frame = (double)(allocs - window_allocs) / window;
+            result.live = (double)(allocs - deallocations.load());
+            result.p50_ms = percentile(latencies, 0.50);
+            result.p99_ms = percentile(latencies, 0.99);
+            result.rss_mb = residentMB();
+            result.heap_mb = heapMB();
+            printf("%9.1f %8.2f %8.2f %9.1f %9.1f %9.0f %8.1f\n", result.minutes, result.p50_ms, result.p99_ms, result.rss_mb, result.heap_mb,
+                   result.live, result.allocs_per_frame);
+            fflush(stdout);
+
+            windows.push_back(result);
+            latencies.clear(); // Keeps its capacity, so measuring allocates nothing
+            window_allocs = allocations.load();
+        }
+    }
+    double real_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    stopDriftMonitor(drift);
+    closeReplay(footage.replay);
+
+    if (!csv_file.empty())
+    {
+        std::vector<std::string> names;
+        std::vector<std::vector<float>> data;
+        for (size_t i = 0; i < windows.size(); i++)
+        {
+            const SoakWindow &w = windows[i];
+            names.push_back("window-" + std::to_string(i));
+            data.push_back({(float)w.minutes, (float)w.p50_ms, (float)w.p99_ms, (float)w.rss_mb, (float)w.heap_mb, (float)w.live, (float)w.allocs_per_frame});
+        }
+        writeCsvRows(csv_file, names, data);
+    }
+
+    double virtual_s = windows.size() * (double)window / fps;
+    printf("%zu windows, %.1f virtual minutes in %.1f s (%.0fx real time), footage looped %d times\n", windows.size(), virtual_s / 60.0, real_s,
+           real_s > 0.0 ? virtual_s / real_s : 0.0, footage.loops);
+
+    // The first windows fill caches, pools and tiles, so the trends are fitted after a warm-up of a fifth of the run
+    size_t first = std::max<size_t>(1, windows.size() / 5);
+    if (windows.size() < first + 3)
+    {
+        printf("Too few windows to fit a trend; run longer or use a smaller --window\n");
+        return (-1);
+    }
+    const SoakWindow &base = windows[first];
+    double p99_limit = std::max(0.5, p99_tol * base.p99_ms);
+    bool ok = checkTrend("RSS", trendRise(windows, first, &SoakWindow::rss_mb), base.rss_mb, rss_tol, "MB");
+    ok = checkTrend("heap in use", trendRise(windows, first, &SoakWindow::heap_mb), base.heap_mb, rss_tol, "MB") && ok;
+    ok = checkTrend("live allocations", trendRise(windows, first, &SoakWindow::live), base.live, live_tol, "") && ok;
+    ok = checkTrend("p99 latency", trendRise(windows, first, &SoakWindow::p99_ms), base.p99_ms, p99_limit, "ms") && ok;
+    printf("Soak %s\n", ok ? "passed" : "FAILED");
+
+    return (ok ? 0 : -1);
+}
@@ -0,0 +1,204 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for calibrating a two camera rig, rectifying synchronised image pairs and computing block-matching disparity maps.
+*/
+
+#include "stereo.h"
+#include "subpix.h"
+#include "csv_util.h"
+
+/*
+ Given the calibration target, this function returns its geometry.
+ */
+DynamicBoard stereoBoard(StereoTarget target)
+{
+    return (target == STEREO_CHESSBOARD ? Chessboard9x6::dynamic() : CircleGrid4x11::dynamic());
+}
+
+/*
+ Given a cv::Mat of the image frame, cv::Mat for the output, vector of points and the calibration target,
+ this function detects the target and optionally draws it. Chessboard corners are refined to sub-pixel accuracy.
+ */
+static bool extractTarget(cv::Mat &src, cv::Mat &dst, std::vector<cv::Point2f> &corners, StereoTarget target, bool drawCorners)
+{
+    dst = src.clone();
+
+    bool found = false;
+    cv::Size board_size = stereoBoard(target).size;
+    if (target == STEREO_CHESSBOARD)
+    {
+        found = cv::findChessboardCorners(src, board_size, corners);
+        if (found)
+        {
+            cv::Mat gray;
+            cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
+            SubpixParams subpix;
+            refineCorners(gray, corners, subpix);
+        }
+    }
+    else
+    {
+        found = cv::findCirclesGrid(src, board_size, corners, cv::CALIB_CB_ASYMMETRIC_GRID + cv::CALIB_CB_CLUSTERING);
+    }
+
+    if (drawCorners)
+    {
+        cv::drawChessboardCorners(dst, board_size, corners, found);
+    }
+
+    return (found);
+}
+
+/*
+ Given a cv::Mat of the left and right image frames, cv::Mats for the outputs, vectors of points and the calibration target,
+ this function detects the target in both frames and optionally draws the detections.
+ It returns true only when the target is found in both frames.
+ */
+bool stereoExtractCorners(cv::Mat &left, cv::Mat &right, cv::Mat &dst_left, cv::Mat &dst_right, std::vector<cv::Point2f> &left_corners, std::vector<cv::Point2f> &right_corners, StereoTarget target, bool drawCorners)
+{
+    bool found_left = extractTarget(left, dst_left, left_corners, target, drawCorners);     // Detect the target in the left frame
+    bool found_right = extractTarget(right, dst_right, right_corners, target, drawCorners); // Detect the target in the right frame
+
+    return (found_left && found_right);
+}
+
+/*
+ Given the calibration target, this function populates the vector of points in world coordinates for the target.
+ The ordering matches the target points in core.cpp.
+ */
+int stereoTargetPoints(StereoTarget target, std::vector<cv::Vec3f> &points)
+{
+    boardObjectPoints(stereoBoard(target), points);
+
+    return (0);
+}
+
+/*
+ Given vectors having a list of point sets, left and right corner sets and the image size,
+ this function runs stereo calibration seeded with the intrinsics already stored in the rig
+ and populates the rig with the refined intrinsics and the relative pose of the cameras.
+ This function also returns the reprojection error after performing calibration.
+ */
+float stereoCalibrateRig(std::vector<std::vector<cv::Vec3f>> &points_list, std::vector<std::vector<cv::Point2f>> &left_list, std::vector<std::vector<cv::Point2f>> &right_list, cv::Size image_size, StereoRig &rig)
+{
+    rig.image_size = image_size;
+    rig.rectified = false;
+
+    // The saved single camera calibrations are used as the starting point, so only the relative pose has to be found from scratch
+    float error = cv::stereoCalibrate(points_list,                                                                            // Vector containing multiple point sets
+                                      left_list,                                                                              // Corner sets seen by the left camera
+                                      right_list,                                                                             // Corner sets seen by the right camera
+                                      rig.camera_matrix[0], rig.dist_coeff[0],                                                // Left intrinsics (seed and output)
+                                      rig.camera_matrix[1], rig.dist_coeff[1],                                                // Right intrinsics (seed and output)
+                                      image_size,                                                                             // Size of the image frames
+                                      rig.R, rig.T, rig.E, rig.F,                                                             // Relative pose, essential and fundamental matrices
+                                      cv::CALIB_USE_INTRINSIC_GUESS + cv::CALIB_FIX_ASPECT_RATIO,                             // Refine the seeded intrinsics
+                                      cv::TermCriteria(cv::TermCriteria::MAX_ITER + cv::TermCriteria::EPS, 30, DBL_EPSILON)); // Termination criteria for the iterative algorithm
+
+    return (error);
+}
+
+/*
+ Given a calibrated rig, this function computes the rectification transforms and precomputes the remap tables for both cameras.
+ */
+int stereoRectifyRig(StereoRig &rig)
+{
+    cv::stereoRectify(rig.camera_matrix[0], rig.dist_coeff[0], rig.camera_matrix[1], rig.dist_coeff[1], rig.image_size, rig.R, rig.T,
+                      rig.R1, rig.R2, rig.P1, rig.P2, rig.Q, cv::CALIB_ZERO_DISPARITY, 0, rig.image_size, &rig.roi[0], &rig.roi[1]);
+
+    // Fixed point maps make the per-frame remap considerably cheaper than floating point maps
+    cv::initUndistortRectifyMap(rig.camera_matrix[0], rig.dist_coeff[0], rig.R1, rig.P1, rig.image_size, CV_16SC2, rig.map_x[0], rig.map_y[0]);
+    cv::initUndistortRectifyMap(rig.camera_matrix[1], rig.dist_coeff[1], rig.R2, rig.P2, rig.image_size, CV_16SC2, rig.map_x[1], rig.map_y[1]);
+
+    rig.rectified = true;
+
+    return (0);
+}
+
+/*
+ Given a rectified rig and a pair of image frames, this function remaps both frames into the rectified image pair.
+ */
+int rectifyPair(StereoRig &rig, cv::Mat &left, cv::Mat &right, cv::Mat &rect_left, cv::Mat &rect_right)
+{
+    if (!rig.rectified)
+    {
+        return (-1); // Remap tables have not been built yet
+    }
+
+    cv::remap(left, rect_left, rig.map_x[0], rig.map_y[0], cv::INTER_LINEAR);
+    cv::remap(right, rect_right, rig.map_x[1], rig.map_y[1], cv::INTER_LINEAR);
+
+    return (0);
+}
+
+/*
+ Given a rectified image pair, this function computes the block-matching disparity map (CV_16S, 4 fractional bits).
+ The image is split into horizontal bands which are matched in parallel on all cores.
+ */
+int computeDisparity(cv::Mat &rect_left, cv::Mat &rect_right, cv::Mat &disparity, int num_disparities, int block_size)
+{
+    cv::Mat gray_left, gray_right;
+    if (rect_left.channels() == 3)
+    {
+        cv::cvtColor(rect_left, gray_left, cv::COLOR_BGR2GRAY);
+        cv::cvtColor(rect_right, gray_right, cv::COLOR_BGR2GRAY);
+    }
+    else
+    {
+        gray_left = rect_left;
+        gray_right = rect_right;
+    }
+
+    disparity.create(gray_left.size(), CV_16S);
+
+    // Each band is matched with extra rows above and below so the block windows and pre-filter at the band edges see real image data
+    int rows = gray_left.rows;
+    int margin = std::max(block_size, 9) / 2 + 1;
+    int bands = std::max(1, std::min(cv::getNumThreads(), rows / (4 * margin)));
+
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range &range)
+                      {
+                          for (int b = range.start; b < range.end; b++)
+                          {
+                              int y0 = rows * b / bands;
+                              int y1 = rows * (b + 1) / bands;
+                              int top = std::max(0, y0 - margin);
+                              int bottom = std::min(rows, y1 + margin);
+
+                              // StereoBM keeps per-call scratch buffers inside the object, so every band needs its own matcher
+                              cv::Ptr<cv::StereoBM> matcher = cv::StereoBM::create(num_disparities, block_size);
+                              cv::Mat band_disparity;
+                              matcher->compute(gray_left.rowRange(top, bottom), gray_right.rowRange(top, bottom), band_disparity);
+
+                              band_disparity.rowRange(y0 - top, y1 - top).copyTo(disparity.rowRange(y0, y1));
+                          } });
+
+    return (0);
+}
+
+/*
+ Given a calibrated rig, this function saves the relative pose and rectification data into a CSV file, replacing its contents.
+ */
+int saveStereoCalibration(StereoRig &rig, std::string csv_filename)
+{
+    // Each matrix is written as one row of the CSV file, labelled with its name
+    std::vector<std::pair<std::string, cv::Mat>> rows = {{"rotation", rig.R}, {"translation", rig.T}, {"rectify_left", rig.R1}, {"rectify_right", rig.R2}, {"projection_left", rig.P1}, {"projection_right", rig.P2}, {"disparity_to_depth", rig.Q}};
+
+    std::vector<std::string> names;
+    std::vector<std::vector<float>> data;
+    for (auto &row : rows)
+    {
+        cv::Mat values;
+        row.second.convertTo(values, CV_32F);
+
+        names.push_back(row.first);
+        data.push_back(std::vector<float>(values.begin<float>(), values.end<float>())); // Flatten the matrix row by row
+    }
+
+    // Replace the file, so a reader of the first rows always finds the latest rig
+    return (writeCsvRows(csv_filename, names, data));
+}
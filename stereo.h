@@ -0,0 +1,96 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for calibrating a two camera rig, rectifying synchronised image pairs and computing block-matching disparity maps.
+*/
+
+#ifndef stereo_hpp
+#define stereo_hpp
+
+#include <stdio.h>
+#include <iostream>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/calib3d.hpp>
+
+#include "board.h"
+
+/*
+ Calibration targets that can be used to calibrate the stereo rig.
+ */
+enum StereoTarget
+{
+    STEREO_CHESSBOARD, // 9x6 chessboard used by main.cpp
+    STEREO_CIRCLEGRID  // 4x11 asymmetric circle grid used by main_ar.cpp
+};
+
+/*
+ Intrinsics of both cameras, their relative pose and the rectification data derived from them.
+ Index 0 is the left camera and index 1 is the right camera.
+ */
+struct StereoRig
+{
+    cv::Mat camera_matrix[2]; // Intrinsics of each camera
+    cv::Mat dist_coeff[2];    // Distortion coefficients of each camera
+    cv::Mat R, T, E, F;       // Pose of the right camera relative to the left, essential and fundamental matrices
+    cv::Mat R1, R2, P1, P2;   // Rectification rotations and projections
+    cv::Mat Q;                // Disparity-to-depth mapping
+    cv::Mat map_x[2];         // Precomputed rectification remap tables (x)
+    cv::Mat map_y[2];         // Precomputed rectification remap tables (y)
+    cv::Rect roi[2];          // Valid pixel region of each rectified image
+    cv::Size image_size;      // Size of the frames the rig was calibrated with
+    bool rectified = false;   // True once the remap tables have been built
+};
+
+/*
+ Given the calibration target, this function returns its geometry.
+ */
+DynamicBoard stereoBoard(StereoTarget target);
+
+/*
+ Given a cv::Mat of the left and right image frames, cv::Mats for the outputs, vectors of points and the calibration target,
+ this function detects the target in both frames and optionally draws the detections.
+ It returns true only when the target is found in both frames.
+ */
+bool stereoExtractCorners(cv::Mat &left, cv::Mat &right, cv::Mat &dst_left, cv::Mat &dst_right, std::vector<cv::Point2f> &left_corners, std::vector<cv::Point2f> &right_corners, StereoTarget target, bool drawCorners);
+
+/*
+ Given the calibration target, this function populates the vector of points in world coordinates for the target.
+ The ordering matches the target points in core.cpp.
+ */
+int stereoTargetPoints(StereoTarget target, std::vector<cv::Vec3f> &points);
+
+/*
+ Given vectors having a list of point sets, left and right corner sets and the image size,
+ this function runs stereo calibration seeded with the intrinsics already stored in the rig
+ and populates the rig with the refined intrinsics and the relative pose of the cameras.
+ This function also returns the reprojection error after performing calibration.
+ */
+float stereoCalibrateRig(std::vector<std::vector<cv::Vec3f>> &points_list, std::vector<std::vector<cv::Point2f>> &left_list, std::vector<std::vector<cv::Point2f>> &right_list, cv::Size image_size, StereoRig &rig);
+
+/*
+ Given a calibrated rig, this function computes the rectification transforms and precomputes the remap tables for both cameras.
+ */
+int stereoRectifyRig(StereoRig &rig);
+
+/*
+ Given a rectified rig and a pair of image frames, this function remaps both frames into the rectified image pair.
+ */
+int rectifyPair(StereoRig &rig, cv::Mat &left, cv::Mat &right, cv::Mat &rect_left, cv::Mat &rect_right);
+
+/*
+ Given a rectified image pair, this function computes the block-matching disparity map (CV_16S, 4 fractional bits).
+ The image is split into horizontal bands which are matched in parallel on all cores.
+ */
+int computeDisparity(cv::Mat &rect_left, cv::Mat &rect_right, cv::Mat &disparity, int num_disparities, int block_size);
+
+/*
+ Given a calibrated rig, this function saves the relative pose and rectification data into a CSV file, replacing its contents.
+ */
+int saveStereoCalibration(StereoRig &rig, std::string csv_filename);
+
+#endif /* stereo_hpp */
@@ -0,0 +1,240 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for refining corner positions to sub-pixel accuracy in parallel batches,
+with vectorised gradient windows and an optional saddle-point fit.
+*/
+
+#include <opencv2/core/hal/intrin.hpp>
+
+#include "subpix.h"
+
+/*
+ Given the interpolated window around a corner (two pixels wider and taller than the search window),
+ the Gaussian weights, the column offsets and the window sizes, this function accumulates the weighted gradient sums
+ a = sum gx^2, b = sum gx gy, c = sum gy^2, bb1 = sum (gx^2 x + gx gy y) and bb2 = sum (gx gy x + gy^2 y).
+ */
+static void gradientSums(const float *buf, int step, const float *mask, const float *px, int win_w, int win_h, int half_h, double sums[5])
+{
+    double a = 0, b = 0, c = 0, bb1 = 0, bb2 = 0;
+
+    for (int i = 0; i < win_h; i++)
+    {
+        const float *r0 = buf + i * step + 1;       // Row above, for the vertical gradient
+        const float *r1 = buf + (i + 1) * step;     // Centre row, for the horizontal gradient
+        const float *r2 = buf + (i + 2) * step + 1; // Row below, for the vertical gradient
+        const float *m = mask + i * win_w;
+        float py = (float)(i - half_h);
+        int j = 0;
+
+#if CV_SIMD
+        // Whole vectors of the row at once; the lanes are summed once per row. The operator forms and nlanes are what
+        // every OpenCV 4 release has for fixed-width vectors; scalable-vector builds take the scalar loop below
+        const int lanes = cv::v_float32::nlanes;
+        cv::v_float32 va = cv::vx_setzero_f32(), vb = cv::vx_setzero_f32(), vc = cv::vx_setzero_f32();
+        cv::v_float32 vbb1 = cv::vx_setzero_f32(), vbb2 = cv::vx_setzero_f32();
+        cv::v_float32 vpy = cv::vx_setall_f32(py);
+        for (; j <= win_w - lanes; j += lanes)
+        {
+            cv::v_float32 gx = cv::vx_load(r1 + j + 2) - cv::vx_load(r1 + j);
+            cv::v_float32 gy = cv::vx_load(r2 + j) - cv::vx_load(r0 + j);
+            cv::v_float32 w = cv::vx_load(m + j);
+            cv::v_float32 vpx = cv::vx_load(px + j);
+
+            cv::v_float32 gxx = gx * gx * w;
+            cv::v_float32 gxy = gx * gy * w;
+            cv::v_float32 gyy = gy * gy * w;
+
+            va = va + gxx;
+            vb = vb + gxy;
+            vc = vc + gyy;
+            vbb1 = cv::v_fma(gxx, vpx, cv::v_fma(gxy, vpy, vbb1));
+            vbb2 = cv::v_fma(gxy, vpx, cv::v_fma(gyy, vpy, vbb2));
+        }
+        a += cv::v_reduce_sum(va);
+        b += cv::v_reduce_sum(vb);
+        c += cv::v_reduce_sum(vc);
+        bb1 += cv::v_reduce_sum(vbb1);
+        bb2 += cv::v_reduce_sum(vbb2);
+#endif
+
+        // Remaining columns
+        for (; j < win_w; j++)
+        {
+            float gx = r1[j + 2] - r1[j];
+            float gy = r2[j] - r0[j];
+            float gxx = gx * gx * m[j], gxy = gx * gy * m[j], gyy = gy * gy * m[j];
+            a += gxx;
+            b += gxy;
+            c += gyy;
+            bb1 += gxx * px[j] + gxy * py;
+            bb2 += gxy * px[j] + gyy * py;
+        }
+    }
+
+    sums[0] = a;
+    sums[1] = b;
+    sums[2] = c;
+    sums[3] = bb1;
+    sums[4] = bb2;
+}
+
+/*
+ Given a grayscale image, a corner, the Gaussian weights, the column offsets and the refinement settings,
+ this function iterates the gradient orthogonality model of cv::cornerSubPix on the corner until it converges.
+ */
+static cv::Point2f refineGradient(cv::Mat &gray, cv::Point2f corner, const cv::Mat &mask, const std::vector<float> &px, SubpixParams &params, cv::Mat &buf)
+{
+    int win_w = 2 * params.window.width + 1, win_h = 2 * params.window.height + 1;
+    double eps2 = params.epsilon * params.epsilon;
+    cv::Point2f current = corner;
+
+    for (int iter = 0; iter < params.max_iterations; iter++)
+    {
+        cv::getRectSubPix(gray, cv::Size(win_w + 2, win_h + 2), current, buf, CV_32F);
+
+        double sums[5];
+        gradientSums(buf.ptr<float>(), (int)buf.step1(), mask.ptr<float>(), px.data(), win_w, win_h, params.window.height, sums);
+        double a = sums[0], b = sums[1], c = sums[2], bb1 = sums[3], bb2 = sums[4];
+
+        double det = a * c - b * b;
+        if (std::fabs(det) <= DBL_EPSILON * DBL_EPSILON)
+        {
+            break; // Flat window, nothing to refine against
+        }
+
+        double scale = 1.0 / det;
+        cv::Point2f next((float)(current.x + c * scale * bb1 - b * scale * bb2), (float)(current.y - b * scale * bb1 + a * scale * bb2));
+        double moved = (next.x - current.x) * (next.x - current.x) + (next.y - current.y) * (next.y - current.y);
+        current = next;
+
+        if (current.x < 0 || current.x >= gray.cols || current.y < 0 || current.y >= gray.rows || moved <= eps2)
+        {
+            break; // Converged, or left the image
+        }
+    }
+
+    return (current);
+}
+
+/*
+ Given a grayscale image, a corner, the least squares solver of the quadratic model and the refinement settings,
+ this function fits f(x, y) = a x^2 + b xy + c y^2 + d x + e y + f to the smoothed window around the corner
+ and moves the corner to the saddle point of the fit, repeating from the new position until it converges.
+ */
+static cv::Point2f refineSaddle(cv::Mat &gray, cv::Point2f corner, const cv::Mat &solver, int radius, SubpixParams &params, cv::Mat &buf)
+{
+    int size = 2 * radius + 1;
+    cv::Point2f current = corner;
+    cv::Mat smooth, values;
+
+    for (int iter = 0; iter < params.max_iterations; iter++)
+    {
+        // Two extra pixels on each side so the smoothing of the fitted window sees real data
+        cv::getRectSubPix(gray, cv::Size(size + 4, size + 4), current, buf, CV_32F);
+        cv::GaussianBlur(buf, smooth, cv::Size(5, 5), 1.0);
+        smooth(cv::Rect(2, 2, size, size)).copyTo(values);
+
+        cv::Mat coeffs = solver * values.reshape(1, size * size); // a, b, c, d, e
+        double a = coeffs.at<float>(0), b = coeffs.at<float>(1), c = coeffs.at<float>(2);
+        double d = coeffs.at<float>(3), e = coeffs.at<float>(4);
+
+        // Stationary point of the quadratic; it is a saddle only when the Hessian is indefinite
+        double det = 4 * a * c - b * b;
+        if (det >= 0)
+        {
+            break;
+        }
+        double dx = (-2 * c * d + b * e) / det;
+        double dy = (b * d - 2 * a * e) / det;
+        if (std::fabs(dx) > radius || std::fabs(dy) > radius)
+        {
+            break; // The fit does not describe a corner in this window
+        }
+
+        current += cv::Point2f((float)dx, (float)dy);
+        if (dx * dx + dy * dy <= params.epsilon * params.epsilon)
+        {
+            break;
+        }
+    }
+
+    return (current);
+}
+
+/*
+ Given a grayscale image, a vector of corners and the refinement settings,
+ this function moves every corner to its sub-pixel position. Corners are refined in parallel batches,
+ and each corner stops iterating as soon as it converges. Corners that would leave their window keep their position.
+ */
+int refineCorners(cv::Mat &gray, std::vector<cv::Point2f> &corners, SubpixParams &params)
+{
+    if (corners.empty())
+    {
+        return (0);
+    }
+
+    int win_w = 2 * params.window.width + 1, win_h = 2 * params.window.height + 1;
+
+    // Gaussian weights and column offsets of the gradient window, as used by cv::cornerSubPix
+    cv::Mat mask(win_h, win_w, CV_32F);
+    std::vector<float> px(win_w);
+    for (int i = 0; i < win_h; i++)
+    {
+        double y = (double)(i - params.window.height) / params.window.height;
+        for (int j = 0; j < win_w; j++)
+        {
+            double x = (double)(j - params.window.width) / params.window.width;
+            mask.at<float>(i, j) = (float)(std::exp(-x * x) * std::exp(-y * y));
+        }
+    }
+    for (int j = 0; j < win_w; j++)
+    {
+        px[j] = (float)(j - params.window.width);
+    }
+
+    // The quadratic model only holds close to the corner, so the saddle fit uses at most a 7x7 window;
+    // its least squares solution is the same linear map for every corner
+    int radius = std::max(2, std::min(3, std::min(params.window.width, params.window.height)));
+    cv::Mat design((2 * radius + 1) * (2 * radius + 1), 6, CV_32F), solver;
+    if (params.method == SUBPIX_SADDLE)
+    {
+        int row = 0;
+        for (int y = -radius; y <= radius; y++)
+        {
+            for (int x = -radius; x <= radius; x++)
+            {
+                float terms[6] = {(float)(x * x), (float)(x * y), (float)(y * y), (float)x, (float)y, 1.0f};
+                std::copy(terms, terms + 6, design.ptr<float>(row++));
+            }
+        }
+        cv::invert(design, solver, cv::DECOMP_SVD);
+        solver = solver.rowRange(0, 5).clone();
+    }
+
+    int batches = ((int)corners.size() + params.batch - 1) / params.batch;
+    cv::parallel_for_(cv::Range(0, batches), [&](const cv::Range &range)
+                      {
+                          cv::Mat buf; // Interpolated window, reused by every corner of the task
+                          for (int batch = range.start; batch < range.end; batch++)
+                          {
+                              int end = std::min((int)corners.size(), (batch + 1) * params.batch);
+                              for (int k = batch * params.batch; k < end; k++)
+                              {
+                                  cv::Point2f start = corners[k];
+                                  cv::Point2f refined = params.method == SUBPIX_SADDLE ? refineSaddle(gray, start, solver, radius, params, buf)
+                                                                                       : refineGradient(gray, start, mask, px, params, buf);
+
+                                  // Like cv::cornerSubPix, a corner that wandered out of its window is left where it was
+                                  if (std::fabs(refined.x - start.x) <= params.window.width && std::fabs(refined.y - start.y) <= params.window.height)
+                                  {
+                                      corners[k] = refined;
+                                  }
+                              }
+                          } });
+
+    return (0);
+}
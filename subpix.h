@@ -0,0 +1,48 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for refining corner positions to sub-pixel accuracy in parallel batches,
+with vectorised gradient windows and an optional saddle-point fit.
+*/
+
+#ifndef subpix_hpp
+#define subpix_hpp
+
+#include <stdio.h>
+#include <iostream>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+/*
+ Refinement methods.
+ */
+enum SubpixMethod
+{
+    SUBPIX_GRADIENT, // Iterative gradient orthogonality, the cv::cornerSubPix model
+    SUBPIX_SADDLE    // Least squares quadratic fit of the smoothed intensity, solved for its saddle point
+};
+
+/*
+ Settings of the refinement. The defaults match the cornerSubPix call the chessboard detector used to make.
+ */
+struct SubpixParams
+{
+    SubpixMethod method = SUBPIX_GRADIENT;
+    cv::Size window = {5, 5}; // Half size of the search window
+    int max_iterations = 30;  // Iterations per corner
+    double epsilon = 0.1;     // A corner is converged once an iteration moves it less than this many pixels
+    int batch = 8;            // Corners refined by one task
+};
+
+/*
+ Given a grayscale image, a vector of corners and the refinement settings,
+ this function moves every corner to its sub-pixel position. Corners are refined in parallel batches,
+ and each corner stops iterating as soon as it converges. Corners that would leave their window keep their position.
+ */
+int refineCorners(cv::Mat &gray, std::vector<cv::Point2f> &corners, SubpixParams &params);
+
+#endif /* subpix_hpp */
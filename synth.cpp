@@ -0,0 +1,325 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for rendering synthetic views of the calibration targets under known intrinsics, distortion and pose,
+with controllable blur, noise, lighting gradients and occlusion, and exact corner and pose labels.
+*/
+
+#include <filesystem>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "synth.h"
+#include "csv_util.h"
+
+/*
+ Given the image size, this function populates the camera matrix and distortion coefficients
+ with a typical webcam calibration at that size.
+ */
+int defaultSynthCamera(cv::Size image_size, cv::Mat &camera_matrix, cv::Mat &dist_coeff)
+{
+    double focal = 0.9 * image_size.width;
+    camera_matrix = (cv::Mat_<double>(3, 3) << focal, 0, (image_size.width - 1) / 2.0, 0, focal, (image_size.height - 1) / 2.0, 0, 0, 1);
+    dist_coeff = (cv::Mat_<double>(1, 5) << -0.12, 0.05, 0.0, 0.0, 0.0);
+
+    return (0);
+}
+
+/*
+ Given the calibration target and the resolution in pixels per board unit,
+ this function draws the flat target texture and returns the board coordinates of the texture's top left corner in origin.
+ */
+int renderBoardTexture(StereoTarget target, int pixels_per_unit, cv::Mat &texture, cv::Point2f &origin)
+{
+    // Dark and light levels stay clear of 0 and 255 so lighting and noise do not clip
+    const cv::Scalar dark(30, 30, 30), light(225, 225, 225);
+    int ppu = pixels_per_unit;
+
+    if (target == STEREO_CHESSBOARD)
+    {
+        // Inner corners at x = 0..8, y = 0..-5, so the 10x7 squares span x = -1..9 and y = 1..-6, plus a one unit white border
+        origin = cv::Point2f(-2, 2);
+        texture = cv::Mat(9 * ppu, 12 * ppu, CV_8UC3, light);
+        for (int row = 0; row < 7; row++)
+        {
+            for (int col = 0; col < 10; col++)
+            {
+                if ((row + col) % 2 == 0)
+                {
+                    cv::rectangle(texture, cv::Rect((col + 1) * ppu, (row + 1) * ppu, ppu, ppu), dark, cv::FILLED);
+                }
+            }
+        }
+    }
+    else
+    {
+        // Circle centres span x = 0..10 and y = 0..7 with a 1.5 unit white border
+        origin = cv::Point2f(-1.5f, 8.5f);
+        texture = cv::Mat(10 * ppu, 13 * ppu, CV_8UC3, light);
+
+        std::vector<cv::Vec3f> points;
+        stereoTargetPoints(target, points);
+        const int shift = 4; // Fractional bits so circle centres land exactly on the board coordinates
+        for (auto &point : points)
+        {
+            // Drawing coordinates are pixel centres, half a pixel in from the texture edge coordinates
+            cv::Point centre(cvRound(((point[0] - origin.x) * ppu - 0.5) * (1 << shift)), cvRound(((origin.y - point[1]) * ppu - 0.5) * (1 << shift)));
+            cv::circle(texture, centre, (ppu / 2) << shift, dark, cv::FILLED, cv::LINE_AA, shift);
+        }
+    }
+
+    return (0);
+}
+
+/*
+ Given the calibration target and the render parameters, this function draws the target texture
+ and undistorts every supersampled pixel once, so views can then be rendered in parallel with one remap each.
+ */
+int prepareSynth(StereoTarget target, SynthParams &params)
+{
+    if (params.camera_matrix.empty())
+    {
+        defaultSynthCamera(params.image_size, params.camera_matrix, params.dist_coeff);
+    }
+
+    params.target = target;
+    renderBoardTexture(target, params.pixels_per_unit, params.texture, params.origin);
+
+    // Supersampled pixel (u', v') sits at ((u' + 0.5) / S - 0.5, (v' + 0.5) / S - 0.5) in the output image,
+    // the same alignment cv::resize uses, so averaging S x S blocks gives the output pixel
+    int S = params.supersample;
+    cv::Size hi(params.image_size.width * S, params.image_size.height * S);
+    params.rays.create(hi, CV_32FC2);
+
+    cv::parallel_for_(cv::Range(0, hi.height), [&](const cv::Range &range)
+                      {
+                          std::vector<cv::Point2f> pixels(hi.width), rays;
+                          for (int v = range.start; v < range.end; v++)
+                          {
+                              for (int u = 0; u < hi.width; u++)
+                              {
+                                  pixels[u] = cv::Point2f((u + 0.5f) / S - 0.5f, (v + 0.5f) / S - 0.5f);
+                              }
+
+                              // Extra iterations so the inverse distortion matches projectPoints to well under a hundredth of a pixel
+                              cv::undistortPoints(pixels, rays, params.camera_matrix, params.dist_coeff, cv::noArray(), cv::noArray(),
+                                                  cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 50, 1e-12));
+                              std::copy(rays.begin(), rays.end(), params.rays.ptr<cv::Point2f>(v));
+                          } });
+
+    return (0);
+}
+
+/*
+ Given the calibration target, the render parameters and a random number generator,
+ this function draws a random board pose that keeps the whole target inside the image.
+ */
+int randomBoardPose(StereoTarget target, SynthParams &params, cv::RNG &rng, cv::Mat &rot, cv::Mat &trans)
+{
+    std::vector<cv::Vec3f> points;
+    stereoTargetPoints(target, points);
+    cv::Vec3d centre = target == STEREO_CHESSBOARD ? cv::Vec3d(4.0, -2.5, 0.0) : cv::Vec3d(5.0, 3.5, 0.0);
+
+    double fx = params.camera_matrix.at<double>(0, 0), fy = params.camera_matrix.at<double>(1, 1);
+    double margin = 0.03 * params.image_size.width;
+
+    for (int attempt = 0; attempt < 200; attempt++)
+    {
+        // Face the camera (board y up is image y down), then tilt about the board axes and roll a little
+        double tilt = params.max_tilt * CV_PI / 180.0;
+        cv::Mat Rx, Ry, Rz;
+        cv::Rodrigues(cv::Vec3d(rng.uniform(-tilt, tilt), 0, 0), Rx);
+        cv::Rodrigues(cv::Vec3d(0, rng.uniform(-tilt, tilt), 0), Ry);
+        cv::Rodrigues(cv::Vec3d(0, 0, rng.uniform(-CV_PI / 6, CV_PI / 6)), Rz);
+        cv::Mat R = Rz * Ry * Rx * cv::Mat(cv::Matx33d(1, 0, 0, 0, -1, 0, 0, 0, -1));
+
+        double distance = rng.uniform(params.min_distance, params.max_distance);
+        cv::Vec3d position(rng.uniform(-0.35, 0.35) * distance * params.image_size.width / fx,
+                           rng.uniform(-0.35, 0.35) * distance * params.image_size.height / fy, distance);
+        cv::Mat t = cv::Mat(position) - R * cv::Mat(centre);
+
+        cv::Rodrigues(R, rot);
+        trans = t.clone();
+
+        std::vector<cv::Point2f> corners;
+        cv::projectPoints(points, rot, trans, params.camera_matrix, params.dist_coeff, corners);
+        cv::Rect2f inside((float)margin, (float)margin, (float)(params.image_size.width - 2 * margin), (float)(params.image_size.height - 2 * margin));
+        bool visible = true;
+        for (auto &corner : corners)
+        {
+            visible = visible && inside.contains(corner);
+        }
+        if (visible)
+        {
+            return (0);
+        }
+    }
+
+    return (-1);
+}
+
+/*
+ Given the calibration target, the render parameters, the board pose and a random number generator for the degradations,
+ this function renders the view and populates the sample with the image and its exact labels.
+ The parameters must have been prepared for the target with prepareSynth.
+ */
+int renderSynthView(StereoTarget target, SynthParams &params, cv::Mat &rot, cv::Mat &trans, cv::RNG &rng, SynthSample &sample)
+{
+    if (params.rays.empty() || params.target != target)
+    {
+        return (-1);
+    }
+
+    // The board plane z = 0 maps to normalised image coordinates through H = [r1 r2 t],
+    // so every ray is sent back to board coordinates by H^-1 and then to texture coordinates
+    cv::Mat R;
+    cv::Rodrigues(rot, R);
+    cv::Mat H(3, 3, CV_64F);
+    R.col(0).copyTo(H.col(0));
+    R.col(1).copyTo(H.col(1));
+    trans.reshape(1, 3).copyTo(H.col(2));
+
+    double ppu = params.pixels_per_unit;
+    cv::Mat A = (cv::Mat_<double>(3, 3) << ppu, 0, -params.origin.x * ppu - 0.5, 0, -ppu, params.origin.y * ppu - 0.5, 0, 0, 1);
+    cv::Mat Hinv = H.inv();
+
+    cv::Mat map, depth;
+    cv::perspectiveTransform(params.rays, map, A * Hinv);
+    cv::transform(params.rays, depth, Hinv.row(2)); // Inverse depth of the plane along each ray; rays that meet it behind the camera are negative
+    map.setTo(cv::Scalar(-1e6, -1e6), depth <= 0);
+
+    cv::Mat hi;
+    cv::remap(params.texture, hi, map, cv::noArray(), cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(110, 110, 110));
+    cv::resize(hi, sample.image, params.image_size, 0, 0, cv::INTER_AREA);
+
+    sample.rot = rot.clone();
+    sample.trans = trans.clone();
+    std::vector<cv::Vec3f> points;
+    stereoTargetPoints(target, points);
+    cv::projectPoints(points, rot, trans, params.camera_matrix, params.dist_coeff, sample.corners);
+
+    // Occluders: a few random grey ellipses centred on the board covering the requested fraction of its area
+    if (params.occlusion > 0)
+    {
+        std::vector<cv::Point2f> hull;
+        cv::convexHull(sample.corners, hull);
+        double area = cv::contourArea(hull) * params.occlusion / 3.0;
+        for (int i = 0; i < 3; i++)
+        {
+            cv::Point2f centre = sample.corners[rng.uniform(0, (int)sample.corners.size())];
+            double aspect = rng.uniform(0.3, 1.0);
+            double a = std::sqrt(area / (CV_PI * aspect));
+            int grey = rng.uniform(0, 256);
+            cv::ellipse(sample.image, cv::RotatedRect(centre, cv::Size2f((float)(2 * a), (float)(2 * a * aspect)), (float)rng.uniform(0.0, 180.0)),
+                        cv::Scalar(grey, grey, grey), cv::FILLED, cv::LINE_AA);
+        }
+    }
+
+    if (params.blur_sigma > 0)
+    {
+        cv::GaussianBlur(sample.image, sample.image, cv::Size(), params.blur_sigma);
+    }
+
+    if (params.gradient > 0 || params.noise_sigma > 0)
+    {
+        cv::Mat image;
+        sample.image.convertTo(image, CV_32FC3);
+
+        if (params.gradient > 0)
+        {
+            // Brightness falls off linearly along a random direction across the image
+            double angle = rng.uniform(0.0, 2 * CV_PI);
+            double dx = std::cos(angle) / params.image_size.width, dy = std::sin(angle) / params.image_size.height;
+            cv::Mat gain(params.image_size, CV_32F);
+            for (int y = 0; y < gain.rows; y++)
+            {
+                float *row = gain.ptr<float>(y);
+                for (int x = 0; x < gain.cols; x++)
+                {
+                    row[x] = (float)(1.0 - params.gradient * (0.5 + (x - gain.cols / 2) * dx + (y - gain.rows / 2) * dy));
+                }
+            }
+            cv::Mat gain3;
+            cv::merge(std::vector<cv::Mat>{gain, gain, gain}, gain3);
+            image = image.mul(gain3);
+        }
+
+        if (params.noise_sigma > 0)
+        {
+            cv::Mat noise(image.size(), CV_32FC3);
+            rng.fill(noise, cv::RNG::NORMAL, 0.0, params.noise_sigma);
+            image += noise;
+        }
+
+        image.convertTo(sample.image, CV_8UC3);
+    }
+
+    return (0);
+}
+
+/*
+ Given the calibration target, the render parameters, the number of views and a seed,
+ this function renders the views in parallel on all cores. View i only depends on the seed and i,
+ so the same seed reproduces the same dataset.
+ */
+int generateSynthDataset(StereoTarget target, SynthParams &params, int count, uint64_t seed, std::vector<SynthSample> &samples)
+{
+    prepareSynth(target, params);
+    samples.assign(count, SynthSample());
+
+    cv::parallel_for_(cv::Range(0, count), [&](const cv::Range &range)
+                      {
+                          for (int i = range.start; i < range.end; i++)
+                          {
+                              cv::RNG rng(seed * 0x9E3779B97F4A7C15ULL + i + 1); // Independent stream per view
+                              cv::Mat rot, trans;
+                              randomBoardPose(target, params, rng, rot, trans);
+                              renderSynthView(target, params, rot, trans, rng, samples[i]);
+                          } });
+
+    return (0);
+}
+
+/*
+ Given the rendered samples and an output directory, this function writes every image as a PNG
+ and appends its pose and corner labels to labels.csv in the same directory.
+ */
+int writeSynthDataset(std::vector<SynthSample> &samples, std::string directory)
+{
+    std::filesystem::create_directories(directory);
+
+    // PNG encoding dominates, so the images are written in parallel and the labels afterwards in order
+    cv::parallel_for_(cv::Range(0, (int)samples.size()), [&](const cv::Range &range)
+                      {
+                          for (int i = range.start; i < range.end; i++)
+                          {
+                              cv::imwrite(directory + "/synth-" + std::to_string(i) + ".png", samples[i].image);
+                          } });
+
+    // One row per image: rotation vector, translation vector, then x and y of every corner
+    std::string csv_filename = directory + "/labels.csv";
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        std::string name = "synth-" + std::to_string(i) + ".png";
+        std::vector<float> data;
+        for (int k = 0; k < 3; k++)
+        {
+            data.push_back((float)samples[i].rot.at<double>(k));
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            data.push_back((float)samples[i].trans.at<double>(k));
+        }
+        for (auto &corner : samples[i].corners)
+        {
+            data.push_back(corner.x);
+            data.push_back(corner.y);
+        }
+        appendCsvRow(csv_filename, name, data, i == 0);
+    }
+
+    return (0);
+}
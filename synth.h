@@ -0,0 +1,102 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for rendering synthetic views of the calibration targets under known intrinsics, distortion and pose,
+with controllable blur, noise, lighting gradients and occlusion, and exact corner and pose labels.
+*/
+
+#ifndef synth_hpp
+#define synth_hpp
+
+#include <stdio.h>
+#include <iostream>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/calib3d.hpp>
+
+#include "stereo.h"
+
+/*
+ Camera model and image degradations used to render a view.
+ */
+struct SynthParams
+{
+    cv::Mat camera_matrix;            // Intrinsics of the virtual camera
+    cv::Mat dist_coeff;               // Distortion coefficients of the virtual camera
+    cv::Size image_size = {960, 540}; // Size of the rendered images
+    int supersample = 3;              // Samples per pixel along each axis, for anti-aliased edges
+    double blur_sigma = 0.0;          // Gaussian blur in pixels, for defocus and motion
+    double noise_sigma = 0.0;         // Gaussian sensor noise in grey levels
+    double gradient = 0.0;            // Strength of a linear lighting gradient (0 to 1)
+    double occlusion = 0.0;           // Fraction of the board area covered by random occluders (0 to 1)
+    double min_distance = 12.0;       // Nearest board distance, in board units
+    double max_distance = 30.0;       // Board distances are drawn between min_distance and max_distance
+    double max_tilt = 45.0;           // Largest board tilt away from the camera, in degrees
+    int pixels_per_unit = 200;        // Resolution of the target texture
+
+    // Filled by prepareSynth and shared read-only by every view
+    StereoTarget target = STEREO_CHESSBOARD; // Target the texture was drawn for
+    cv::Mat texture;                         // Flat target texture
+    cv::Point2f origin;                      // Board coordinates of the texture's top left corner
+    cv::Mat rays;                            // Undistorted normalised coordinates of every supersampled pixel (CV_32FC2)
+};
+
+/*
+ One rendered view and its labels.
+ */
+struct SynthSample
+{
+    cv::Mat image;                    // Rendered BGR image
+    cv::Mat rot, trans;               // Pose of the board (Rodrigues rotation and translation, CV_64F)
+    std::vector<cv::Point2f> corners; // Exact image position of every target point, in the order of stereoTargetPoints
+};
+
+/*
+ Given the image size, this function populates the camera matrix and distortion coefficients
+ with a typical webcam calibration at that size.
+ */
+int defaultSynthCamera(cv::Size image_size, cv::Mat &camera_matrix, cv::Mat &dist_coeff);
+
+/*
+ Given the calibration target and the resolution in pixels per board unit,
+ this function draws the flat target texture and returns the board coordinates of the texture's top left corner in origin.
+ */
+int renderBoardTexture(StereoTarget target, int pixels_per_unit, cv::Mat &texture, cv::Point2f &origin);
+
+/*
+ Given the calibration target and the render parameters, this function draws the target texture
+ and undistorts every supersampled pixel once, so views can then be rendered in parallel with one remap each.
+ */
+int prepareSynth(StereoTarget target, SynthParams &params);
+
+/*
+ Given the calibration target, the render parameters and a random number generator,
+ this function draws a random board pose that keeps the whole target inside the image.
+ */
+int randomBoardPose(StereoTarget target, SynthParams &params, cv::RNG &rng, cv::Mat &rot, cv::Mat &trans);
+
+/*
+ Given the calibration target, the render parameters, the board pose and a random number generator for the degradations,
+ this function renders the view and populates the sample with the image and its exact labels.
+ The parameters must have been prepared for the target with prepareSynth.
+ */
+int renderSynthView(StereoTarget target, SynthParams &params, cv::Mat &rot, cv::Mat &trans, cv::RNG &rng, SynthSample &sample);
+
+/*
+ Given the calibration target, the render parameters, the number of views and a seed,
+ this function renders the views in parallel on all cores. View i only depends on the seed and i,
+ so the same seed reproduces the same dataset.
+ */
+int generateSynthDataset(StereoTarget target, SynthParams &params, int count, uint64_t seed, std::vector<SynthSample> &samples);
+
+/*
+ Given the rendered samples and an output directory, this function writes every image as a PNG
+ and appends its pose and corner labels to labels.csv in the same directory.
+ */
+int writeSynthDataset(std::vector<SynthSample> &samples, std::string directory);
+
+#endif /* synth_hpp */
@@ -0,0 +1,317 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+main() CPP function for generating synthetic datasets of the calibration targets with exact labels,
+and for measuring detector accuracy and speed against those labels.
+
+Usage: synth_boards [output_directory] [count] [chessboard|circles] [--blur=S] [--noise=S] [--gradient=G] [--occlusion=F]
+                    [--supersample=N] [--seed=N] [--calib=calibration.csv] [--size=WxH] [--eval[=DETECTOR]]
+                    [--solve-scaling[=MAX_VIEWS]]
+*/
+
+#include <iostream>
+#include <chrono>
+
+// OpenCV headers
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+// User-defined headers
+#include "synth.h"
+#include "circlegrid.h"
+#include "subpix.h"
+#include "core.h"
+#include "resolution.h"
+
+/*
+ Given the detected and true corner positions, this function matches every detection to its nearest true corner
+ and returns the mean and maximum distance. Matching by distance makes the error independent of the detector's ordering.
+ */
+static int cornerErrors(std::vector<cv::Point2f> &detected, std::vector<cv::Point2f> &truth, double &mean_error, double &max_error)
+{
+    mean_error = 0.0;
+    max_error = 0.0;
+    for (auto &corner : detected)
+    {
+        double best = DBL_MAX;
+        for (auto &label : truth)
+        {
+            best = std::min(best, (double)cv::norm(corner - label));
+        }
+        mean_error += best;
+        max_error = std::max(max_error, best);
+    }
+    mean_error /= std::max((size_t)1, detected.size());
+
+    return (0);
+}
+
+/*
+ Given the target, the samples, the camera model and the detector to use, this function runs the detector on every sample
+ and prints the detection rate, time per frame, corner error and the error of the pose solved from the detections.
+ */
+static int evaluateDetector(StereoTarget target, std::vector<SynthSample> &samples, SynthParams &params, std::string detector_name)
+{
+    std::vector<cv::Vec3f> points;
+    stereoTargetPoints(target, points);
+
+    int detected = 0;
+    double total_ms = 0.0, refine_ms = 0.0, mean_sum = 0.0, worst = 0.0, rot_sum = 0.0, trans_sum = 0.0;
+    for (auto &sample : samples)
+    {
+        std::vector<cv::Point2f> corners;
+        auto start = std::chrono::steady_clock::now();
+        bool found;
+        if (target == STEREO_CHESSBOARD)
+        {
+            // Same detection as detectTarget in core.cpp; the refinement is timed on its own
+            found = cv::findChessboardCorners(sample.image, Chessboard9x6::size(), corners);
+            if (found)
+            {
+                cv::Mat gray;
+                cv::cvtColor(sample.image, gray, cv::COLOR_BGR2GRAY);
+                auto refine_start = std::chrono::steady_clock::now();
+                if (detector_name == "opencv")
+                {
+                    cv::cornerSubPix(gray, corners, cv::Size(5, 5), cv::Size(-1, -1), cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 30, 0.1));
+                }
+                else
+                {
+                    SubpixParams subpix;
+                    subpix.method = detector_name == "saddle" ? SUBPIX_SADDLE : SUBPIX_GRADIENT;
+                    refineCorners(gray, corners, subpix);
+                }
+                refine_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - refine_start).count();
+            }
+        }
+        else if (detector_name == "opencv")
+        {
+            // Original single-threaded call on the colour frame
+            found = cv::findCirclesGrid(sample.image, CircleGrid4x11::size(), corners, cv::CALIB_CB_ASYMMETRIC_GRID + cv::CALIB_CB_CLUSTERING);
+        }
+        else
+        {
+            // Parallel blob detector used by detectTarget; views are unrelated, so no state is carried between them
+            CircleGridDetector detector;
+            cv::Mat gray;
+            cv::cvtColor(sample.image, gray, cv::COLOR_BGR2GRAY);
+            found = detectCircleGrid(detector, gray, corners);
+        }
+        total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (!found)
+        {
+            continue;
+        }
+        detected++;
+
+        double mean_error, max_error;
+        cornerErrors(corners, sample.corners, mean_error, max_error);
+        mean_sum += mean_error;
+        worst = std::max(worst, max_error);
+
+        // Pose from the detections, with each detection paired to the world point of its nearest label
+        std::vector<cv::Vec3f> matched;
+        for (auto &corner : corners)
+        {
+            int nearest = 0;
+            for (int i = 1; i < (int)sample.corners.size(); i++)
+            {
+                if (cv::norm(corner - sample.corners[i]) < cv::norm(corner - sample.corners[nearest]))
+                {
+                    nearest = i;
+                }
+            }
+            matched.push_back(points[nearest]);
+        }
+        cv::Mat rot, trans, R, R_true;
+        cv::solvePnP(matched, corners, params.camera_matrix, params.dist_coeff, rot, trans);
+        cv::Rodrigues(rot, R);
+        cv::Rodrigues(sample.rot, R_true);
+        cv::Mat R_delta;
+        cv::Rodrigues(R * R_true.t(), R_delta);
+        rot_sum += cv::norm(R_delta) * 180.0 / CV_PI;
+        trans_sum += cv::norm(trans - sample.trans) / cv::norm(sample.trans);
+    }
+
+    int n = (int)samples.size();
+    printf("detected %d / %d   time %.2f ms/frame\n", detected, n, total_ms / std::max(1, n));
+    if (target == STEREO_CHESSBOARD && detected > 0)
+    {
+        printf("refinement %.3f ms/frame\n", refine_ms / detected);
+    }
+    if (detected > 0)
+    {
+        printf("corner error mean %.4f px  max %.4f px\n", mean_sum / detected, worst);
+        printf("pose error rotation %.4f deg  translation %.4f %%\n", rot_sum / detected, 100.0 * trans_sum / detected);
+    }
+
+    return (0);
+}
+
+/*
+ Given the calibration target, the render parameters, the largest number of views and a seed, this function draws random board poses,
+ projects the target with the render camera and adds 0.2 px of Gaussian noise to the corners, then calibrates the first 10, 20, 40, ...
+ views with cv::calibrateCamera and with the sparse bundle adjustment. It prints the time, the RMS error and the focal length error
+ of each solver per view count. Nothing is rendered, so the figures are the solvers' alone.
+ */
+static int timeSolvers(StereoTarget target, SynthParams &params, int max_views, uint64_t seed)
+{
+    if (params.camera_matrix.empty())
+    {
+        defaultSynthCamera(params.image_size, params.camera_matrix, params.dist_coeff);
+    }
+    std::vector<cv::Vec3f> world;
+    stereoTargetPoints(target, world);
+
+    cv::RNG rng(seed);
+    std::vector<cv::Mat> points, corners;
+    for (int i = 0; i < max_views; i++)
+    {
+        cv::Mat rot, trans;
+        std::vector<cv::Point2f> projected;
+        randomBoardPose(target, params, rng, rot, trans);
+        cv::projectPoints(world, rot, trans, params.camera_matrix, params.dist_coeff, projected);
+        for (auto &corner : projected)
+        {
+            corner += cv::Point2f((float)rng.gaussian(0.2), (float)rng.gaussian(0.2));
+        }
+        points.push_back(cv::Mat(world).clone());
+        corners.push_back(cv::Mat(projected).clone());
+    }
+
+    double fx = params.camera_matrix.at<double>(0, 0);
+    printf("%6s %12s %10s %10s %12s %10s %10s %6s\n", "views", "opencv ms", "rms px", "fx err %", "sparse ms", "rms px", "fx err %", "iters");
+    for (int n = 10; n <= max_views; n *= 2)
+    {
+        std::vector<cv::Mat> view_points(points.begin(), points.begin() + n), view_corners(corners.begin(), corners.begin() + n);
+        BundleParams opencv, sparse;
+        sparse.solver = SOLVER_SPARSE;
+
+        cv::Mat opencv_matrix = cv::Mat::eye(3, 3, CV_64FC1), opencv_dist;
+        auto start = std::chrono::steady_clock::now();
+        float opencv_error = calibrateViews(view_points, view_corners, params.image_size, opencv_matrix, opencv_dist, opencv);
+        double opencv_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        cv::Mat sparse_matrix = cv::Mat::eye(3, 3, CV_64FC1), sparse_dist;
+        float sparse_error = calibrateBundle(view_points, view_corners, params.image_size, sparse_matrix, sparse_dist, sparse);
+
+        printf("%6d %12.1f %10.4f %10.3f %12.1f %10.4f %10.3f %6d\n", n, opencv_ms, opencv_error, 100.0 * fabs(opencv_matrix.at<double>(0, 0) - fx) / fx,
+               sparse.ms, sparse_error, 100.0 * fabs(sparse_matrix.at<double>(0, 0) - fx) / fx, sparse.iterations);
+        fflush(stdout);
+    }
+
+    return (0);
+}
+
+// Main function
+int main(int argc, char *argv[])
+{
+    std::string directory = "synth"; // Output directory
+    int count = 100;                 // Number of views
+    StereoTarget target = STEREO_CHESSBOARD;
+    SynthParams params;
+    uint64_t seed = 1;
+    std::string calib_file; // Intrinsics to render with, instead of the default webcam model
+    bool evaluate = false;  // Measure the detector instead of writing the dataset
+    std::string detector;   // Detector measured by --eval
+    int solve_views = 0;    // Largest view count timed by --solve-scaling, 0 when the solvers are not timed
+
+    int positional = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--blur=", 0) == 0)
+        {
+            params.blur_sigma = atof(arg.c_str() + 7);
+        }
+        else if (arg.rfind("--noise=", 0) == 0)
+        {
+            params.noise_sigma = atof(arg.c_str() + 8);
+        }
+        else if (arg.rfind("--gradient=", 0) == 0)
+        {
+            params.gradient = atof(arg.c_str() + 11);
+        }
+        else if (arg.rfind("--occlusion=", 0) == 0)
+        {
+            params.occlusion = atof(arg.c_str() + 12);
+        }
+        else if (arg.rfind("--supersample=", 0) == 0)
+        {
+            params.supersample = std::max(1, atoi(arg.c_str() + 14));
+        }
+        else if (arg.rfind("--seed=", 0) == 0)
+        {
+            seed = strtoull(arg.c_str() + 7, NULL, 10);
+        }
+        else if (arg.rfind("--calib=", 0) == 0)
+        {
+            calib_file = arg.substr(8);
+        }
+        else if (arg.rfind("--size=", 0) == 0)
+        {
+            sscanf(arg.c_str(), "--size=%dx%d", &params.image_size.width, &params.image_size.height);
+        }
+        else if (arg == "--eval" || arg.rfind("--eval=", 0) == 0)
+        {
+            evaluate = true;
+            detector = arg.size() > 7 ? arg.substr(7) : "";
+        }
+        else if (arg == "--solve-scaling" || arg.rfind("--solve-scaling=", 0) == 0)
+        {
+            solve_views = arg.size() > 16 ? atoi(arg.c_str() + 16) : 640;
+        }
+        else if (positional == 0)
+        {
+            directory = arg;
+            positional++;
+        }
+        else if (positional == 1)
+        {
+            count = atoi(arg.c_str());
+            positional++;
+        }
+        else
+        {
+            target = arg == "circles" ? STEREO_CIRCLEGRID : STEREO_CHESSBOARD;
+        }
+    }
+
+    // Render with a saved calibration when given, rescaled to the output size
+    if (!calib_file.empty())
+    {
+        cv::Size calib_size;
+        params.camera_matrix = cv::Mat::eye(3, 3, CV_64FC1);
+        readCalibration(calib_file, params.camera_matrix, params.dist_coeff, calib_size);
+        rescaleIntrinsics(params.camera_matrix, calib_size, params.image_size);
+        params.dist_coeff.convertTo(params.dist_coeff, CV_64F);
+    }
+
+    if (solve_views > 0)
+    {
+        return (timeSolvers(target, params, solve_views, seed));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SynthSample> samples;
+    generateSynthDataset(target, params, count, seed, samples);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Rendered %d views in %.2f s\n", count, elapsed);
+
+    if (evaluate)
+    {
+        evaluateDetector(target, samples, params, detector);
+    }
+    else
+    {
+        writeSynthDataset(samples, directory);
+        printf("Wrote %d images and labels.csv to %s\n", count, directory.c_str());
+    }
+
+    return (0);
+}
@@ -0,0 +1,163 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+main() CPP function for inspecting, merging and calibrating from the view stores written by main and main_ar with --views.
+
+Usage: view_tool info store.views
+       view_tool merge merged.views first.views [second.views ...]
+       view_tool calibrate store.views [--camera-id=N] [--size=WxH] [--out=calibration.csv] [--solver=sparse] [--loss=huber:S] [--fix=k3,...]
+*/
+
+#include <iostream>
+#include <map>
+#include <string.h>
+#include <unistd.h>
+
+// OpenCV headers
+#include <opencv2/core.hpp>
+
+// User-defined headers
+#include "viewstore.h"
+#include "csv_util.h"
+
+// Main function
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printf("Usage: view_tool info|merge|calibrate store.views [...]\n");
+        return (-1);
+    }
+    std::string command = argv[1];
+    std::string filename = argv[2];
+
+    if (command == "merge")
+    {
+        ViewStore store;
+        if (openViewStore(store, filename) != 0)
+        {
+            return (-1);
+        }
+        for (int i = 3; i < argc; i++)
+        {
+            int added = mergeViewStore(store, argv[i]);
+            if (added >= 0)
+            {
+                printf("Merged %d views from %s\n", added, argv[i]);
+            }
+        }
+        printf("%s holds %d views\n", filename.c_str(), viewStoreCount(store, -1, cv::Size()));
+        closeViewStore(store);
+        return (0);
+    }
+
+    // The other commands only read the store, so refuse to create it
+    ViewStore store;
+    if (access(filename.c_str(), F_OK) != 0 || openViewStore(store, filename) != 0)
+    {
+        printf("Unable to open view store %s\n", filename.c_str());
+        return (-1);
+    }
+
+    if (command == "info")
+    {
+        // Views and corners per camera and frame size
+        std::map<std::pair<uint32_t, std::pair<int, int>>, std::pair<int, uint64_t>> groups;
+        for (uint64_t i = 0; i < store.header->view_count; i++)
+        {
+            ViewRecord &view = store.views[i];
+            auto &group = groups[{view.camera, {view.width, view.height}}];
+            group.first++;
+            group.second += view.count;
+        }
+
+        printf("%llu views, %llu corners, %.1f MB mapped\n", (unsigned long long)store.header->view_count,
+               (unsigned long long)store.header->point_count, store.size / (1024.0 * 1024.0));
+        for (auto &group : groups)
+        {
+            printf("camera %u  %dx%d  %d views  %llu corners\n", group.first.first, group.first.second.first, group.first.second.second,
+                   group.second.first, (unsigned long long)group.second.second);
+        }
+    }
+    else if (command == "calibrate")
+    {
+        int camera_id = -1;
+        cv::Size image_size;
+        std::string out_file = "view_calibration.csv";
+        BundleParams solver;
+        for (int i = 3; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (arg.rfind("--camera-id=", 0) == 0)
+            {
+                camera_id = atoi(arg.c_str() + 12);
+            }
+            else if (arg.rfind("--size=", 0) == 0)
+            {
+                sscanf(arg.c_str(), "--size=%dx%d", &image_size.width, &image_size.height);
+            }
+            else if (arg.rfind("--out=", 0) == 0)
+            {
+                out_file = arg.substr(6);
+            }
+            else
+            {
+                parseBundleArg(solver, arg);
+            }
+        }
+
+        // Without a size, use the size of the first view of the camera
+        for (uint64_t i = 0; image_size.empty() && i < store.header->view_count; i++)
+        {
+            ViewRecord &view = store.views[i];
+            if (camera_id < 0 || view.camera == (uint32_t)camera_id)
+            {
+                image_size = cv::Size(view.width, view.height);
+            }
+        }
+
+        int views = viewStoreCount(store, camera_id, image_size);
+        if (views < 5)
+        {
+            printf("Need at least 5 views, found %d\n", views);
+            closeViewStore(store);
+            return (-1);
+        }
+
+        double cammat[] = {1, 0, (double)image_size.width / 2, 0, 1, (double)image_size.height / 2, 0, 0, 1};
+        cv::Mat camera_matrix(cv::Size(3, 3), CV_64FC1, &cammat);
+        cv::Mat dist_coeff;
+        printf("Calibrating %dx%d from %d views...\n", image_size.width, image_size.height, views);
+        float reprojErr = calibrateViewStore(store, camera_id, image_size, camera_matrix, dist_coeff, solver);
+        std::cout << "Calibrated camera matrix:" << std::endl;
+        std::cout << camera_matrix << std::endl;
+        std::cout << "Re-projection error: " << reprojErr << std::endl;
+        std::cout << "Distortion coefficients: " << dist_coeff << std::endl;
+
+        // Same rows as saveCalibration, so readCalibration can load the result; the file is replaced, not appended to
+        std::vector<float> camVector, distVector;
+        camera_matrix.reshape(1, 1).convertTo(camVector, CV_32F);
+        if (!dist_coeff.empty())
+        {
+            dist_coeff.reshape(1, 1).convertTo(distVector, CV_32F);
+        }
+        std::vector<float> sizeVector = {(float)image_size.width, (float)image_size.height};
+        if (writeCsvRows(out_file, {"camera_matrix", "distortion_coefficient", "image_size"}, {camVector, distVector, sizeVector}) != 0)
+        {
+            printf("Unable to write %s\n", out_file.c_str());
+            closeViewStore(store);
+            return (-1);
+        }
+        printf("Saved the calibration to %s\n", out_file.c_str());
+    }
+    else
+    {
+        printf("Unknown command %s\n", command.c_str());
+    }
+
+    closeViewStore(store);
+    return (0);
+}
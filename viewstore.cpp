@@ -0,0 +1,336 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Function implementations for a memory-mapped store of calibration views. Every view's corners and world points live in two flat arrays
+indexed by an offsets table, so stores of thousands of views from many cameras can be resumed, merged and calibrated
+without copying the views into per-view vectors.
+*/
+
+#include <chrono>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "viewstore.h"
+
+/*
+ Given an offset, this function returns it rounded up to a cache line so every section starts aligned.
+ */
+static uint64_t aligned(uint64_t offset)
+{
+    return ((offset + 63) & ~(uint64_t)63);
+}
+
+/*
+ Given the store, this function points the section pointers at the current mapping.
+ */
+static void bindSections(ViewStore &store)
+{
+    store.header = (ViewStoreHeader *)store.base;
+    store.views = (ViewRecord *)(store.base + store.header->views_offset);
+    store.corners = (cv::Point2f *)(store.base + store.header->corners_offset);
+    store.points = (cv::Vec3f *)(store.base + store.header->points_offset);
+}
+
+/*
+ Given the store and a file size, this function resizes the file and maps it again.
+ It returns -1 when the file cannot be resized or mapped.
+ */
+static int remapStore(ViewStore &store, size_t size)
+{
+    if (store.base != NULL)
+    {
+        munmap(store.base, store.size);
+        store.base = NULL;
+    }
+    if (ftruncate(store.fd, size) != 0)
+    {
+        return (-1);
+    }
+
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, store.fd, 0);
+    if (base == MAP_FAILED)
+    {
+        return (-1);
+    }
+    store.base = (unsigned char *)base;
+    store.size = size;
+
+    return (0);
+}
+
+/*
+ Given the store and the views and corners about to be added, this function makes room for them.
+ Capacities double, so appending is amortised constant time; the sections move up to their new offsets,
+ the last section first so nothing is overwritten before it has been moved.
+ */
+static int reserveStore(ViewStore &store, uint64_t views_needed, uint64_t points_needed)
+{
+    ViewStoreHeader old = *store.header;
+    if (views_needed <= old.view_capacity && points_needed <= old.point_capacity)
+    {
+        return (0);
+    }
+
+    uint64_t view_capacity = std::max(views_needed, std::max(old.view_capacity * 2, (uint64_t)64));
+    uint64_t point_capacity = std::max(points_needed, std::max(old.point_capacity * 2, (uint64_t)4096));
+    uint64_t views_offset = aligned(sizeof(ViewStoreHeader));
+    uint64_t corners_offset = aligned(views_offset + view_capacity * sizeof(ViewRecord));
+    uint64_t points_offset = aligned(corners_offset + point_capacity * sizeof(cv::Point2f));
+    size_t size = points_offset + point_capacity * sizeof(cv::Vec3f);
+
+    if (remapStore(store, size) != 0)
+    {
+        printf("Unable to grow the view store\n");
+        return (-1);
+    }
+
+    memmove(store.base + points_offset, store.base + old.points_offset, old.point_count * sizeof(cv::Vec3f));
+    memmove(store.base + corners_offset, store.base + old.corners_offset, old.point_count * sizeof(cv::Point2f));
+    memmove(store.base + views_offset, store.base + old.views_offset, old.view_count * sizeof(ViewRecord));
+
+    ViewStoreHeader *header = (ViewStoreHeader *)store.base;
+    header->view_capacity = view_capacity;
+    header->point_capacity = point_capacity;
+    header->views_offset = views_offset;
+    header->corners_offset = corners_offset;
+    header->points_offset = points_offset;
+    bindSections(store);
+
+    return (0);
+}
+
+/*
+ Given the store and a file name, this function maps the store file, creating an empty store when the file does not exist,
+ so that a session can be resumed where it left off. It returns -1 when the file cannot be opened or is not a view store.
+ */
+int openViewStore(ViewStore &store, std::string filename)
+{
+    store.fd = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat info;
+    if (store.fd < 0 || fstat(store.fd, &info) != 0)
+    {
+        printf("Unable to open view store %s\n", filename.c_str());
+        closeViewStore(store);
+        return (-1);
+    }
+
+    if (info.st_size == 0)
+    {
+        // New store: a header with empty sections, grown on the first append
+        if (remapStore(store, sizeof(ViewStoreHeader)) != 0)
+        {
+            closeViewStore(store);
+            return (-1);
+        }
+        ViewStoreHeader *header = (ViewStoreHeader *)store.base;
+        memset(header, 0, sizeof(ViewStoreHeader));
+        header->magic = VIEWSTORE_MAGIC;
+        header->version = VIEWSTORE_VERSION;
+        header->views_offset = header->corners_offset = header->points_offset = sizeof(ViewStoreHeader);
+        bindSections(store);
+        return (reserveStore(store, 1, 1));
+    }
+
+    // Existing store: check it before trusting its offsets
+    if (remapStore(store, info.st_size) != 0 || store.size < sizeof(ViewStoreHeader))
+    {
+        printf("Unable to map view store %s\n", filename.c_str());
+        closeViewStore(store);
+        return (-1);
+    }
+    ViewStoreHeader *header = (ViewStoreHeader *)store.base;
+    bool valid = header->magic == VIEWSTORE_MAGIC && header->version == VIEWSTORE_VERSION &&
+                 header->view_count <= header->view_capacity && header->point_count <= header->point_capacity &&
+                 header->points_offset + header->point_capacity * sizeof(cv::Vec3f) <= store.size;
+    if (!valid)
+    {
+        printf("%s is not a view store\n", filename.c_str());
+        closeViewStore(store);
+        return (-1);
+    }
+    bindSections(store);
+
+    return (0);
+}
+
+/*
+ Given the store, the world points and corners of a view, the camera it was captured with and the frame size,
+ this function appends the view. The view is counted only once its data is in place.
+ */
+int appendView(ViewStore &store, std::vector<cv::Vec3f> &points, std::vector<cv::Point2f> &corners, uint32_t camera, cv::Size image_size)
+{
+    if (store.base == NULL || points.size() != corners.size())
+    {
+        return (-1);
+    }
+
+    ViewStoreHeader *header = store.header;
+    if (reserveStore(store, header->view_count + 1, header->point_count + points.size()) != 0)
+    {
+        return (-1);
+    }
+    header = store.header; // The mapping may have moved
+
+    uint64_t first = header->point_count;
+    memcpy(store.points + first, points.data(), points.size() * sizeof(cv::Vec3f));
+    memcpy(store.corners + first, corners.data(), corners.size() * sizeof(cv::Point2f));
+
+    ViewRecord &view = store.views[header->view_count];
+    view.first = first;
+    view.count = (uint32_t)points.size();
+    view.camera = camera;
+    view.width = image_size.width;
+    view.height = image_size.height;
+    view.timestamp = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    header->point_count += points.size();
+    header->view_count++;
+
+    return (0);
+}
+
+/*
+ Given the store and the file name of another store, this function appends all views of the other store.
+ It returns the number of views added, or -1 when the other file is not a view store.
+ */
+int mergeViewStore(ViewStore &store, std::string filename)
+{
+    // Opening would create a missing file, which is never what a merge wants
+    ViewStore other;
+    if (access(filename.c_str(), F_OK) != 0)
+    {
+        printf("Unable to find view store %s\n", filename.c_str());
+        return (-1);
+    }
+    if (openViewStore(other, filename) != 0)
+    {
+        return (-1);
+    }
+
+    // Reserve once for the whole merge, then copy the other store's arrays in bulk
+    ViewStoreHeader *src = other.header;
+    if (reserveStore(store, store.header->view_count + src->view_count, store.header->point_count + src->point_count) != 0)
+    {
+        closeViewStore(other);
+        return (-1);
+    }
+    ViewStoreHeader *dst = store.header;
+
+    memcpy(store.points + dst->point_count, other.points, src->point_count * sizeof(cv::Vec3f));
+    memcpy(store.corners + dst->point_count, other.corners, src->point_count * sizeof(cv::Point2f));
+    for (uint64_t i = 0; i < src->view_count; i++)
+    {
+        ViewRecord view = other.views[i];
+        view.first += dst->point_count;
+        store.views[dst->view_count + i] = view;
+    }
+
+    int added = (int)src->view_count;
+    dst->point_count += src->point_count;
+    dst->view_count += src->view_count;
+    closeViewStore(other);
+
+    return (added);
+}
+
+/*
+ Given a stored view, a camera (-1 for all cameras) and a frame size (empty for all sizes),
+ this function returns true when the view was captured with that camera at that size.
+ */
+static bool viewMatches(ViewRecord &view, int camera, cv::Size image_size)
+{
+    return ((camera < 0 || view.camera == (uint32_t)camera) && (image_size.empty() || cv::Size(view.width, view.height) == image_size));
+}
+
+/*
+ Given the store, a camera (-1 for all cameras) and a frame size (empty for all sizes),
+ this function returns the number of stored views that match. A store that is not open has none.
+ */
+int viewStoreCount(ViewStore &store, int camera, cv::Size image_size)
+{
+    int count = 0;
+    for (uint64_t i = 0; store.base != NULL && i < store.header->view_count; i++)
+    {
+        count += viewMatches(store.views[i], camera, image_size);
+    }
+
+    return (count);
+}
+
+/*
+ Given the store, a camera (-1 for all cameras), a frame size (empty for all sizes) and vectors of matrices,
+ this function populates the vectors with one Nx1 matrix per matching view that points straight into the mapped arrays.
+ The matrices are valid until the store next grows or is closed.
+ */
+int viewStoreArrays(ViewStore &store, int camera, cv::Size image_size, std::vector<cv::Mat> &points, std::vector<cv::Mat> &corners)
+{
+    points.clear();
+    corners.clear();
+    if (store.base == NULL)
+    {
+        return (-1);
+    }
+
+    for (uint64_t i = 0; i < store.header->view_count; i++)
+    {
+        ViewRecord &view = store.views[i];
+        if (!viewMatches(view, camera, image_size))
+        {
+            continue;
+        }
+        points.push_back(cv::Mat((int)view.count, 1, CV_32FC3, store.points + view.first));
+        corners.push_back(cv::Mat((int)view.count, 1, CV_32FC2, store.corners + view.first));
+    }
+
+    return (0);
+}
+
+/*
+ Given the store, a camera (-1 for all cameras), the frame size, an initial camera matrix and the solver settings,
+ this function calibrates the camera from every stored view of that camera at that size and returns the reprojection error.
+ */
+float calibrateViewStore(ViewStore &store, int camera, cv::Size image_size, cv::Mat &camera_matrix, cv::Mat &dist_coeff, BundleParams &solver)
+{
+    std::vector<cv::Mat> points, corners;
+    viewStoreArrays(store, camera, image_size, points, corners);
+    if (points.empty())
+    {
+        return (-1.0f);
+    }
+
+    // Same model and solver as the calibration in main.cpp
+    float error = calibrateViews(points, corners, image_size, camera_matrix, dist_coeff, solver);
+
+    return (error);
+}
+
+/*
+ Given the store, this function flushes the mapping to the file and closes it.
+ */
+int closeViewStore(ViewStore &store)
+{
+    if (store.base != NULL)
+    {
+        msync(store.base, store.size, MS_SYNC);
+        munmap(store.base, store.size);
+    }
+    if (store.fd >= 0)
+    {
+        close(store.fd);
+    }
+    store.fd = -1;
+    store.base = NULL;
+    store.size = 0;
+    store.header = NULL;
+    store.views = NULL;
+    store.corners = NULL;
+    store.points = NULL;
+
+    return (0);
+}
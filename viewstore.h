@@ -0,0 +1,111 @@
+/*
+Tejasri Kasturi & Veditha Gudapati
+CS 5330 Computer Vision
+Spring 2024
+Project 4
+
+Functions for a memory-mapped store of calibration views. Every view's corners and world points live in two flat arrays
+indexed by an offsets table, so stores of thousands of views from many cameras can be resumed, merged and calibrated
+without copying the views into per-view vectors.
+*/
+
+#ifndef viewstore_hpp
+#define viewstore_hpp
+
+#include <stdio.h>
+#include <iostream>
+#include <stdint.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/calib3d.hpp>
+
+#include "bundle.h"
+
+#define VIEWSTORE_MAGIC 0x57564143 // "CAVW"
+#define VIEWSTORE_VERSION 1
+
+/*
+ Header at the start of the store file. The three sections follow at the given offsets and are resized together.
+ */
+struct ViewStoreHeader
+{
+    uint32_t magic;          // VIEWSTORE_MAGIC
+    uint32_t version;        // VIEWSTORE_VERSION
+    uint64_t view_count;     // Views stored
+    uint64_t point_count;    // Corners stored across all views
+    uint64_t view_capacity;  // Views the offsets table has room for
+    uint64_t point_capacity; // Corners the corner and point arrays have room for
+    uint64_t views_offset;   // Offset of the ViewRecord table
+    uint64_t corners_offset; // Offset of the cv::Point2f corner array
+    uint64_t points_offset;  // Offset of the cv::Vec3f world point array
+};
+
+/*
+ Entry of the offsets table describing one view.
+ */
+struct ViewRecord
+{
+    uint64_t first;        // Index of the view's first corner in the corner and point arrays
+    uint32_t count;        // Corners in the view
+    uint32_t camera;       // Camera the view was captured with
+    int32_t width, height; // Size of the frame the corners were found in
+    double timestamp;      // Capture time, seconds since the epoch
+};
+
+/*
+ An open store. The pointers into the mapping move whenever the store grows.
+ */
+struct ViewStore
+{
+    int fd = -1;                    // Descriptor of the store file
+    unsigned char *base = NULL;     // Start of the mapping
+    size_t size = 0;                // Bytes mapped
+    ViewStoreHeader *header = NULL; // Header at the start of the mapping
+    ViewRecord *views = NULL;       // Offsets table
+    cv::Point2f *corners = NULL;    // Image coordinates of all corners
+    cv::Vec3f *points = NULL;       // World coordinates of all corners
+};
+
+/*
+ Given the store and a file name, this function maps the store file, creating an empty store when the file does not exist,
+ so that a session can be resumed where it left off. It returns -1 when the file cannot be opened or is not a view store.
+ */
+int openViewStore(ViewStore &store, std::string filename);
+
+/*
+ Given the store, the world points and corners of a view, the camera it was captured with and the frame size,
+ this function appends the view. The view is counted only once its data is in place.
+ */
+int appendView(ViewStore &store, std::vector<cv::Vec3f> &points, std::vector<cv::Point2f> &corners, uint32_t camera, cv::Size image_size);
+
+/*
+ Given the store and the file name of another store, this function appends all views of the other store.
+ It returns the number of views added, or -1 when the other file is not a view store.
+ */
+int mergeViewStore(ViewStore &store, std::string filename);
+
+/*
+ Given the store, a camera (-1 for all cameras) and a frame size (empty for all sizes),
+ this function returns the number of stored views that match. A store that is not open has none.
+ */
+int viewStoreCount(ViewStore &store, int camera, cv::Size image_size);
+
+/*
+ Given the store, a camera (-1 for all cameras), a frame size (empty for all sizes) and vectors of matrices,
+ this function populates the vectors with one Nx1 matrix per matching view that points straight into the mapped arrays.
+ The matrices are valid until the store next grows or is closed.
+ */
+int viewStoreArrays(ViewStore &store, int camera, cv::Size image_size, std::vector<cv::Mat> &points, std::vector<cv::Mat> &corners);
+
+/*
+ Given the store, a camera (-1 for all cameras), the frame size, an initial camera matrix and the solver settings,
+ this function calibrates the camera from every stored view of that camera at that size and returns the reprojection error.
+ */
+float calibrateViewStore(ViewStore &store, int camera, cv::Size image_size, cv::Mat &camera_matrix, cv::Mat &dist_coeff, BundleParams &solver);
+
+/*
+ Given the store, this function flushes the mapping to the file and closes it.
+ */
+int closeViewStore(ViewStore &store);
+
+#endif /* viewstore_hpp */